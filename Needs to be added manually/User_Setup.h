@@ -26,15 +26,18 @@
 
 //#define TOUCH_CS 33 // Optional for touch screen
 
+// The firmware only draws with the GLCD font; the other fonts only take
+// flash.  Anti-aliased text uses the firmware's own glyph cache
+// with a VLW font subset by tools/font_subset.py, not SMOOTH_FONT.
 #define LOAD_GLCD
-#define LOAD_FONT2
-#define LOAD_FONT4
-#define LOAD_FONT6
-#define LOAD_FONT7
-#define LOAD_FONT8
-#define LOAD_GFXFF
-
-#define SMOOTH_FONT
+//#define LOAD_FONT2
+//#define LOAD_FONT4
+//#define LOAD_FONT6
+//#define LOAD_FONT7
+//#define LOAD_FONT8
+//#define LOAD_GFXFF
+
+//#define SMOOTH_FONT
 
 // FSPI port (SPI2) used unless following defined. HSPI port (SPI3) NOT TESTED YET
 #define USE_HSPI_PORT
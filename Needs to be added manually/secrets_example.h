@@ -27,6 +27,37 @@
     SMARTMETER_TOKEN           – optional bearer token for authenticating with
                                  your smart‑meter.  Leave blank if not needed.
 
+  History backfill (optional, leave BACKFILL_URL empty to disable):
+    BACKFILL_URL – URL returning the energy document of one past day, with
+                   {date} for the UTC date, e.g.
+                   "http://192.168.0.50/api/daily?date={date}"
+
+  Shelly / Tasmota meter configuration (used in MODE_RPC_METER):
+    RPC_METER_HOST      – IP address or hostname of the device
+    RPC_METER_KIND      – "shelly-pro3em", "shelly-gen1", "shelly-plug" or
+                          "tasmota"
+    RPC_METER_GENERATOR – 1 if the device measures the inverter output
+                          instead of the grid connection, otherwise 0
+
+  InfluxDB export (optional, leave INFLUX_WRITE_URL empty to disable):
+    INFLUX_WRITE_URL – full v2 write URL including org, bucket and
+                       precision=s, e.g.
+                       "http://192.168.0.10:8086/api/v2/write?org=home&bucket=solar&precision=s"
+    INFLUX_TOKEN     – API token with write access to the bucket
+
+  Alarms (optional, see alarm_rules.h for the syntax):
+    ALARM_RULES – rule list, e.g. "battery<20/25; gen<50/100@11-14; age>900/600"
+    ALARM_URL   – webhook receiving a JSON POST whenever an alarm is raised
+                  or cleared.  Leave empty to only show the banner.
+
+  Remote configuration:
+    ADMIN_TOKEN – token required to change settings over HTTP
+                  (``POST /api/config``).  Leave empty on trusted networks.
+
+  These values are factory defaults.  Every setting can later be changed
+  over the serial console or HTTP; changed values are kept in NVS and take
+  precedence over this file.
+
   All strings must be enclosed in double quotes.  For unused fields leave the
   string empty ("").
   -----------------------------------------------------------------------------
@@ -46,8 +77,40 @@
 // The authentication URL and energy query URL must be provided by Anker.
 #define ANKER_AUTH_URL ""
 #define ANKER_ENERGY_URL ""
+// Optional alternative regional hosts for the URLs above, comma separated
+// ("host[:port]").  The fastest healthy one is used.
+#define ANKER_HOSTS ""
 
 // Local smart‑meter configuration
 #define SMARTMETER_HOST ""
 #define SMARTMETER_ENERGY_ENDPOINT ""
-#define SMARTMETER_TOKEN ""
\ No newline at end of file
+#define SMARTMETER_TOKEN ""
+
+// Paths of the values in the cloud or smart-meter response, e.g.
+// "battery=data.soc; gen_curve=data.hours[*].pv".  Empty for the format
+// described in the README.
+#define FIELD_MAP ""
+
+// Energy document of a past day, {date} = YYYY-MM-DD.  Days missed while
+// offline are fetched from here.
+#define BACKFILL_URL ""
+
+// Shelly / Tasmota meter configuration
+#define RPC_METER_HOST ""
+#define RPC_METER_KIND "shelly-pro3em"
+#define RPC_METER_GENERATOR 0
+
+// InfluxDB export
+#define INFLUX_WRITE_URL ""
+#define INFLUX_TOKEN ""
+
+// Extra rows computed from the current values, e.g.
+// "Export=max(gen-cons,0) kWh".  See src/derived_values.h.
+#define DERIVED_VALUES ""
+
+// Alarm rules and webhook
+#define ALARM_RULES "battery<20/25; age>900/600"
+#define ALARM_URL ""
+
+// Token for changing settings over HTTP
+#define ADMIN_TOKEN ""
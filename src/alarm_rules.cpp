@@ -0,0 +1,157 @@
+#include "alarm_rules.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const METRIC_NAMES[] = {"battery", "gen", "power", "age"};
+static_assert(sizeof(METRIC_NAMES) / sizeof(METRIC_NAMES[0]) ==
+                  static_cast<size_t>(AlarmMetric::COUNT),
+              "METRIC_NAMES must list every AlarmMetric");
+
+const char *alarmMetricName(AlarmMetric metric) {
+  return METRIC_NAMES[static_cast<size_t>(metric)];
+}
+
+AlarmEngine::AlarmEngine() : count_(0), active_(0) {
+  memset(byMetric_, 0, sizeof(byMetric_));
+}
+
+static const char *skipSpaces(const char *p) {
+  while (*p == ' ' || *p == '\t') {
+    ++p;
+  }
+  return p;
+}
+
+// Parse one rule from ``p``.  Returns the position after the rule or null
+// on a syntax error.
+static const char *parseRule(const char *p, AlarmRule &r) {
+  p = skipSpaces(p);
+  size_t m = 0;
+  size_t nameLen = 0;
+  for (; m < static_cast<size_t>(AlarmMetric::COUNT); ++m) {
+    nameLen = strlen(METRIC_NAMES[m]);
+    if (strncmp(p, METRIC_NAMES[m], nameLen) == 0) {
+      break;
+    }
+  }
+  if (m == static_cast<size_t>(AlarmMetric::COUNT)) {
+    return nullptr;
+  }
+  r.metric = static_cast<AlarmMetric>(m);
+  p = skipSpaces(p + nameLen);
+  if (*p != '<' && *p != '>') {
+    return nullptr;
+  }
+  r.below = *p++ == '<';
+  char *end;
+  r.setAt = strtof(p, &end);
+  if (end == p) {
+    return nullptr;
+  }
+  p = end;
+  r.clearAt = r.setAt;
+  if (*p == '/') {
+    r.clearAt = strtof(++p, &end);
+    if (end == p) {
+      return nullptr;
+    }
+    p = end;
+    // The clear threshold must lie outside the alarm range, otherwise the
+    // alarm could never be cleared.
+    if (r.below ? r.clearAt < r.setAt : r.clearAt > r.setAt) {
+      return nullptr;
+    }
+  }
+  r.fromHour = -1;
+  r.toHour = -1;
+  if (*p == '@') {
+    long from = strtol(++p, &end, 10);
+    if (end == p || *end != '-') {
+      return nullptr;
+    }
+    p = end + 1;
+    long to = strtol(p, &end, 10);
+    if (end == p || from < 0 || from > 23 || to < 0 || to > 24 || from == to) {
+      return nullptr;
+    }
+    p = end;
+    r.fromHour = static_cast<int8_t>(from);
+    r.toHour = static_cast<int8_t>(to);
+  }
+  return skipSpaces(p);
+}
+
+bool AlarmEngine::compile(const char *text, char *err, size_t errCap) {
+  AlarmRule rules[MAX_RULES];
+  size_t n = 0;
+  const char *p = skipSpaces(text);
+  while (*p) {
+    if (n == MAX_RULES) {
+      snprintf(err, errCap, "more than %u rules", static_cast<unsigned>(MAX_RULES));
+      return false;
+    }
+    const char *next = parseRule(p, rules[n]);
+    if (!next || (*next && *next != ';' && *next != ',')) {
+      snprintf(err, errCap, "syntax error at \"%.16s\"", p);
+      return false;
+    }
+    ++n;
+    p = skipSpaces(*next ? next + 1 : next);
+  }
+
+  memcpy(rules_, rules, n * sizeof(AlarmRule));
+  count_ = static_cast<uint8_t>(n);
+  active_ = 0;
+  memset(byMetric_, 0, sizeof(byMetric_));
+  for (size_t i = 0; i < n; ++i) {
+    values_[i] = NAN;
+    byMetric_[static_cast<size_t>(rules_[i].metric)] |= 1u << i;
+  }
+  return true;
+}
+
+uint32_t AlarmEngine::update(AlarmMetric metric, float value, int hour) {
+  if (isnan(value)) {
+    return 0;
+  }
+  uint32_t changed = 0;
+  uint32_t pending = byMetric_[static_cast<size_t>(metric)];
+  while (pending) {
+    size_t i = __builtin_ctz(pending);
+    pending &= pending - 1;
+    const AlarmRule &r = rules_[i];
+    uint32_t bit = 1u << i;
+    values_[i] = value;
+
+    bool inWindow = true;
+    if (r.fromHour >= 0) {
+      inWindow = hour >= 0 && (r.fromHour < r.toHour
+                                   ? hour >= r.fromHour && hour < r.toHour
+                                   : hour >= r.fromHour || hour < r.toHour);
+    }
+    bool raised = active_ & bit;
+    bool now;
+    if (!inWindow) {
+      now = false;
+    } else if (raised) {
+      now = r.below ? value < r.clearAt : value > r.clearAt;
+    } else {
+      now = r.below ? value < r.setAt : value > r.setAt;
+    }
+    if (now != raised) {
+      active_ ^= bit;
+      changed |= bit;
+    }
+  }
+  return changed;
+}
+
+size_t AlarmEngine::describe(size_t i, char *out, size_t cap) const {
+  const AlarmRule &r = rules_[i];
+  int n = snprintf(out, cap, "%s%c%g", alarmMetricName(r.metric),
+                   r.below ? '<' : '>', static_cast<double>(r.setAt));
+  return n < 0 ? 0 : static_cast<size_t>(n) < cap ? n : cap - 1;
+}
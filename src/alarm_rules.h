@@ -0,0 +1,85 @@
+/*
+  -----------------------------------------------------------------------------
+  alarm_rules.h — Incremental threshold rules with hysteresis
+
+  Alarm conditions are written as a short rule list, e.g.
+
+      battery<20/25; gen<50/100@11-14; age>900/600
+
+  Each rule names a metric, a comparison, the threshold that raises the
+  alarm and an optional second threshold that clears it again (hysteresis),
+  followed by an optional hour window in which the rule applies.  The
+  example raises an alarm when the battery drops below 20 % until it is
+  back at 25 %, when generation stays under 50 W between 11:00 and 14:00,
+  and when the data is older than 15 minutes.
+
+  The list is compiled once into a fixed table.  Every incoming sample is
+  then checked only against the rules of its own metric, in constant time
+  and without looking at any history: a rule's state is the only thing
+  carried from one sample to the next.
+
+  The code is plain C++ without Arduino dependencies so that rule sets can
+  be tried on a host.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum class AlarmMetric : uint8_t {
+  BATTERY,    // battery charge in %
+  GENERATION, // generation power of the current hour in W
+  POWER,      // instantaneous grid power in W, import > 0
+  AGE,        // seconds since the last successful update
+  COUNT
+};
+
+struct AlarmRule {
+  AlarmMetric metric;
+  bool below;     // true for '<', false for '>'
+  float setAt;    // threshold that raises the alarm
+  float clearAt;  // threshold that clears it, never inside the alarm range
+  int8_t fromHour; // hour window [fromHour, toHour), -1 for always
+  int8_t toHour;
+};
+
+class AlarmEngine {
+public:
+  static constexpr size_t MAX_RULES = 8;
+
+  AlarmEngine();
+
+  // Replace the rule set.  On a syntax error the previous rules are kept
+  // and a message is written to ``err``.
+  bool compile(const char *text, char *err, size_t errCap);
+
+  // Check one sample against the rules of ``metric``.  ``hour`` is the
+  // current hour of day or -1 if the clock is not set; rules with an hour
+  // window are inactive while it is unknown.  NaN samples are ignored.
+  // Returns a bit mask of the rules whose state changed.
+  uint32_t update(AlarmMetric metric, float value, int hour);
+
+  // Bit mask of the rules that are currently raised.
+  uint32_t active() const { return active_; }
+
+  size_t count() const { return count_; }
+  const AlarmRule &rule(size_t i) const { return rules_[i]; }
+
+  // Last value that was checked against rule ``i``.
+  float value(size_t i) const { return values_[i]; }
+
+  // Format rule ``i`` as in the rule list, e.g. "battery<20".
+  size_t describe(size_t i, char *out, size_t cap) const;
+
+private:
+  AlarmRule rules_[MAX_RULES];
+  float values_[MAX_RULES];
+  uint8_t count_;
+  uint32_t active_;
+  uint32_t byMetric_[static_cast<size_t>(AlarmMetric::COUNT)];
+};
+
+// Name of a metric as used in rule lists.
+const char *alarmMetricName(AlarmMetric metric);
@@ -0,0 +1,146 @@
+#include "alarms.h"
+
+#include <ArduinoJson.h>
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include <time.h>
+
+#include "config_store.h"
+#include "console.h"
+
+constexpr size_t ALARM_QUEUE_LENGTH = 8;
+constexpr uint16_t ALARM_TIMEOUT_MS = 3000;
+
+// One raised or cleared alarm on its way to the webhook.
+struct AlarmEvent {
+  char rule[24];
+  bool active;
+  float value;
+  uint32_t time;
+};
+
+static AlarmEngine engine;
+static QueueHandle_t eventQueue = nullptr;
+static TaskHandle_t notifyTaskHandle = nullptr;
+
+// Hour of day for rules with an hour window, -1 until the clock is set.
+static int currentHour() {
+  time_t now = time(nullptr);
+  if (now < 100000) {
+    return -1;
+  }
+  struct tm tmNow;
+  gmtime_r(&now, &tmNow);
+  return tmNow.tm_hour;
+}
+
+static void notifyTask(void *) {
+  AlarmEvent ev;
+  for (;;) {
+    if (xQueueReceive(eventQueue, &ev, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+    String url = configString(ConfigKey::AlarmUrl);
+    if (url.length() == 0 || WiFi.status() != WL_CONNECTED) {
+      continue;
+    }
+    JsonDocument doc;
+    doc["device"] = WiFi.getHostname();
+    doc["alarm"] = ev.rule;
+    doc["active"] = ev.active;
+    doc["value"] = ev.value;
+    if (ev.time) {
+      doc["time"] = ev.time;
+    }
+    String body;
+    serializeJson(doc, body);
+    WiFiClient client;
+    HTTPClient http;
+    http.setTimeout(ALARM_TIMEOUT_MS);
+    http.begin(client, url);
+    http.addHeader("Content-Type", "application/json");
+    int code = http.POST(body);
+    http.end();
+    if (code < 200 || code >= 300) {
+      Serial.printf("Alarm notification failed: %d\n", code);
+    }
+  }
+}
+
+void reloadAlarms() {
+  char err[48];
+  if (!engine.compile(configString(ConfigKey::AlarmRules).c_str(), err,
+                      sizeof(err))) {
+    Serial.printf("Invalid alarm rules: %s\n", err);
+    return;
+  }
+  Serial.printf("%u alarm rules loaded\n", static_cast<unsigned>(engine.count()));
+}
+
+// ``alarms`` lists every rule with its state and last value.
+static void alarmsCommand(char *) {
+  char text[24];
+  for (size_t i = 0; i < engine.count(); ++i) {
+    engine.describe(i, text, sizeof(text));
+    Serial.printf("  %-16s %-6s %.1f\n", text,
+                  (engine.active() & (1u << i)) ? "ALARM" : "ok", engine.value(i));
+  }
+}
+
+void beginAlarms() {
+  if (eventQueue) {
+    return;
+  }
+  reloadAlarms();
+  eventQueue = xQueueCreate(ALARM_QUEUE_LENGTH, sizeof(AlarmEvent));
+  if (!eventQueue ||
+      xTaskCreatePinnedToCore(notifyTask, "alarms", 4096, nullptr,
+                              tskIDLE_PRIORITY + 1, &notifyTaskHandle,
+                              0) != pdPASS) {
+    Serial.println("Failed to start alarm notifications");
+  }
+  registerConsoleCommand("alarms", "show alarm rules and their state",
+                         alarmsCommand);
+}
+
+bool alarmSample(AlarmMetric metric, float value) {
+  uint32_t changed = engine.update(metric, value, currentHour());
+  if (changed == 0) {
+    return false;
+  }
+  time_t now = time(nullptr);
+  for (size_t i = 0; i < engine.count(); ++i) {
+    if (!(changed & (1u << i))) {
+      continue;
+    }
+    AlarmEvent ev;
+    engine.describe(i, ev.rule, sizeof(ev.rule));
+    ev.active = engine.active() & (1u << i);
+    ev.value = value;
+    ev.time = now > 100000 ? static_cast<uint32_t>(now) : 0;
+    Serial.printf("Alarm %s: %s (%.1f)\n", ev.active ? "raised" : "cleared",
+                  ev.rule, value);
+    // Never block the caller; a full queue only loses the notification.
+    if (notifyTaskHandle) {
+      xQueueSend(eventQueue, &ev, 0);
+    }
+  }
+  return true;
+}
+
+bool alarmBannerText(char *out, size_t cap) {
+  uint32_t active = engine.active();
+  if (active == 0) {
+    return false;
+  }
+  size_t first = __builtin_ctz(active);
+  char rule[24];
+  engine.describe(first, rule, sizeof(rule));
+  int others = __builtin_popcount(active) - 1;
+  if (others > 0) {
+    snprintf(out, cap, "%s (%.0f) +%d", rule, engine.value(first), others);
+  } else {
+    snprintf(out, cap, "%s (%.0f)", rule, engine.value(first));
+  }
+  return true;
+}
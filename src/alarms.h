@@ -0,0 +1,40 @@
+/*
+  -----------------------------------------------------------------------------
+  alarms.h — Alarm rules, banner text and outbound notifications
+
+  Connects the rule engine from ``alarm_rules.h`` to the firmware.  The
+  rule list comes from the ``alarm_rules`` setting; the main loop feeds
+  every new value with ``alarmSample()`` and redraws only the alarm banner
+  when an alarm is raised or cleared.  Hour windows are evaluated in UTC,
+  like the timestamp on the display.
+
+  Each change is also logged to the serial port and, if ``alarm_url`` is
+  set, posted as a small JSON document by a low-priority task so a slow
+  webhook never delays the display:
+
+      {"device":"solix-display","alarm":"battery<20","active":true,
+       "value":18.5,"time":1700000000}
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "alarm_rules.h"
+
+// Compile the configured rules, start the notification task and register
+// the ``alarms`` console command.
+void beginAlarms();
+
+// Recompile the rules after the ``alarm_rules`` setting changed.  All
+// alarms are cleared and re-evaluated from the next samples.
+void reloadAlarms();
+
+// Check a new value.  Returns true if an alarm was raised or cleared, i.e.
+// the banner needs to be redrawn.  Call from the main loop only.
+bool alarmSample(AlarmMetric metric, float value);
+
+// Text for the alarm banner, e.g. "battery<20 (18.5) +1".  Returns false
+// if no alarm is active.
+bool alarmBannerText(char *out, size_t cap);
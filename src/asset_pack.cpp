@@ -0,0 +1,170 @@
+/* --- asset_pack.cpp — Pre-converted images from one indexed archive --- */
+
+#include "asset_pack.h"
+
+#include <TFT_eSPI.h>
+#include <string.h>
+
+namespace {
+
+constexpr uint16_t PACK_VERSION = 1;
+constexpr uint8_t FORMAT_RGB565 = 0;
+constexpr uint8_t FORMAT_RLE565 = 1;
+constexpr uint8_t FLAG_TRANSPARENT = 1;
+// Pixels pushed to the display per block of rows.
+constexpr size_t DRAW_BLOCK_PIXELS = 2048;
+
+struct Header {
+  char magic[4];
+  uint16_t version;
+  uint16_t count;
+  uint16_t slots;
+  uint16_t reserved;
+  uint32_t dataOffset;
+};
+static_assert(sizeof(Header) == 16, "Header must match the archive layout");
+
+uint32_t fnv1a(const char *s) {
+  uint32_t h = 0x811C9DC5u;
+  while (*s) {
+    h = (h ^ static_cast<uint8_t>(*s++)) * 0x01000193u;
+  }
+  return h;
+}
+
+}  // namespace
+
+bool AssetPack::open(const char *path) {
+  close();
+  if (!reader_.open(path)) {
+    return false;
+  }
+  Header h;
+  bool ok = reader_.read(reinterpret_cast<uint8_t *>(&h), sizeof(h)) == sizeof(h) &&
+            memcmp(h.magic, "APAK", 4) == 0 && h.version == PACK_VERSION &&
+            h.slots != 0 && (h.slots & (h.slots - 1)) == 0 && h.slots >= h.count;
+  if (ok) {
+    entries_.resize(h.count);
+    slots_.resize(h.slots);
+    size_t entryBytes = h.count * sizeof(Entry);
+    size_t slotBytes = h.slots * sizeof(uint16_t);
+    ok = reader_.read(reinterpret_cast<uint8_t *>(entries_.data()), entryBytes) == entryBytes &&
+         reader_.read(reinterpret_cast<uint8_t *>(slots_.data()), slotBytes) == slotBytes;
+  }
+  for (size_t i = 0; ok && i < entries_.size(); ++i) {
+    const Entry &e = entries_[i];
+    ok = e.offset >= h.dataOffset && e.offset <= reader_.size() &&
+         e.length <= reader_.size() - e.offset && e.width && e.height &&
+         e.format <= FORMAT_RLE565;
+  }
+  if (!ok) {
+    Serial.printf("%s is not a valid asset archive\n", path);
+    close();
+    return false;
+  }
+  return true;
+}
+
+void AssetPack::close() {
+  reader_.close();
+  std::vector<Entry>().swap(entries_);
+  std::vector<uint16_t>().swap(slots_);
+  std::vector<uint16_t>().swap(lines_);
+}
+
+int AssetPack::find(const char *name) const {
+  if (slots_.empty()) {
+    return -1;
+  }
+  uint32_t hash = fnv1a(name);
+  size_t mask = slots_.size() - 1;
+  for (size_t probe = 0, s = hash & mask; probe < slots_.size();
+       ++probe, s = (s + 1) & mask) {
+    uint16_t slot = slots_[s];
+    if (slot == 0) {
+      break;
+    }
+    if (slot <= entries_.size() && entries_[slot - 1].hash == hash) {
+      return slot - 1;
+    }
+  }
+  return -1;
+}
+
+bool AssetPack::draw(TFT_eSPI &tft, int id, int16_t x, int16_t y) {
+  if (id < 0 || static_cast<size_t>(id) >= entries_.size()) {
+    return false;
+  }
+  const Entry &e = entries_[id];
+  uint16_t rows = std::max<size_t>(1, DRAW_BLOCK_PIXELS / e.width);
+  lines_.resize(static_cast<size_t>(rows) * e.width);
+  if (!reader_.seek(e.offset)) {
+    return false;
+  }
+  bool ok = e.format == FORMAT_RGB565 ? drawRaw(tft, e, x, y)
+                                      : drawRle(tft, e, x, y);
+  std::vector<uint16_t>().swap(lines_);
+  return ok;
+}
+
+void AssetPack::push(TFT_eSPI &tft, const Entry &e, int16_t x, int16_t y,
+                     uint16_t rows) {
+  if (e.flags & FLAG_TRANSPARENT) {
+    tft.pushImage(x, y, e.width, rows, lines_.data(), e.key);
+  } else {
+    tft.pushImage(x, y, e.width, rows, lines_.data());
+  }
+}
+
+bool AssetPack::drawRaw(TFT_eSPI &tft, const Entry &e, int16_t x, int16_t y) {
+  uint16_t block = lines_.size() / e.width;
+  for (uint16_t row = 0; row < e.height; row += block) {
+    uint16_t rows = std::min<uint16_t>(block, e.height - row);
+    size_t bytes = static_cast<size_t>(rows) * e.width * 2;
+    if (reader_.read(reinterpret_cast<uint8_t *>(lines_.data()), bytes) != bytes) {
+      return false;
+    }
+    push(tft, e, x, y + row, rows);
+  }
+  return true;
+}
+
+// Packets never span rows: a header byte with the top bit set repeats the
+// next pixel (header & 0x7F) + 1 times, otherwise header + 1 pixels follow.
+bool AssetPack::drawRle(TFT_eSPI &tft, const Entry &e, int16_t x, int16_t y) {
+  uint16_t block = lines_.size() / e.width;
+  uint16_t first = 0;
+  size_t filled = 0;
+  size_t end = static_cast<size_t>(block) * e.width;
+  for (uint16_t row = 0; row < e.height; ++row) {
+    size_t rowEnd = filled + e.width;
+    while (filled < rowEnd) {
+      uint8_t header;
+      if (reader_.read(&header, 1) != 1) {
+        return false;
+      }
+      size_t count = (header & 0x7F) + 1u;
+      if (filled + count > rowEnd) {
+        return false;
+      }
+      uint16_t *dst = lines_.data() + filled;
+      if (header & 0x80) {
+        uint16_t pixel;
+        if (reader_.read(reinterpret_cast<uint8_t *>(&pixel), 2) != 2) {
+          return false;
+        }
+        std::fill(dst, dst + count, pixel);
+      } else if (reader_.read(reinterpret_cast<uint8_t *>(dst), count * 2) !=
+                 count * 2) {
+        return false;
+      }
+      filled += count;
+    }
+    if (filled == end || row + 1 == e.height) {
+      push(tft, e, x, y + first, row + 1 - first);
+      first = row + 1;
+      filled = 0;
+    }
+  }
+  return true;
+}
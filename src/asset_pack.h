@@ -0,0 +1,70 @@
+/*
+  -----------------------------------------------------------------------------
+  asset_pack.h — Pre-converted images from one indexed archive
+
+  ``tools/pack_assets.py`` converts PNG images on the host into an archive
+  the display can take without decoding:
+
+    header   "APAK", version, image count, hash slots, data offset
+    index    per image: name hash, size, format, transparent key colour,
+             offset and length of the pixels
+    slots    open-addressing table of the name hashes (index + 1, 0 = free)
+    pixels   RGB565 big-endian, either raw or run-length encoded per row;
+             images of 4 KB and more start on a sector boundary
+
+  ``open()`` reads the header, index and slot table once.  ``find()`` then
+  hashes the name and probes the slots, and ``draw()`` seeks to the pixels
+  and pushes them to the display row block by row block, so showing an
+  image costs a single seek and no decoding.  All values are little-endian.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <vector>
+
+#include "sd_card.h"
+
+class TFT_eSPI;
+
+constexpr const char *ASSET_PACK_PATH = "/assets.pak";
+
+class AssetPack {
+public:
+  bool open(const char *path);
+  void close();
+  bool isOpen() const { return reader_.isOpen(); }
+
+  // Index of the image called ``name``, -1 if the archive has none.
+  int find(const char *name) const;
+
+  uint16_t width(int id) const { return entries_[id].width; }
+  uint16_t height(int id) const { return entries_[id].height; }
+
+  // Draw image ``id`` with its top left corner at (x, y).
+  bool draw(TFT_eSPI &tft, int id, int16_t x, int16_t y);
+
+private:
+  struct Entry {
+    uint32_t hash;
+    uint16_t width;
+    uint16_t height;
+    uint8_t format;
+    uint8_t flags;
+    uint16_t key;
+    uint32_t offset;
+    uint32_t length;
+  };
+  static_assert(sizeof(Entry) == 20, "Entry must match the archive layout");
+
+  bool drawRaw(TFT_eSPI &tft, const Entry &e, int16_t x, int16_t y);
+  bool drawRle(TFT_eSPI &tft, const Entry &e, int16_t x, int16_t y);
+  void push(TFT_eSPI &tft, const Entry &e, int16_t x, int16_t y,
+            uint16_t rows);
+
+  SdReader reader_;
+  std::vector<Entry> entries_;
+  std::vector<uint16_t> slots_;
+  std::vector<uint16_t> lines_;
+};
@@ -0,0 +1,623 @@
+#include "backfill.h"
+
+#include <ArduinoJson.h>
+#include <HTTPClient.h>
+#include <LittleFS.h>
+#include <WiFi.h>
+#include <time.h>
+
+#include "config_store.h"
+#include "console.h"
+#include "endpoint_probe.h"
+#include "json_mapping.h"
+#include "range_api.h"
+
+// Days before today that are checked for gaps.
+#ifndef BACKFILL_DAYS
+#define BACKFILL_DAYS 7
+#endif
+
+// Requests in flight on the backfill connection.
+#ifndef BACKFILL_PIPELINE
+#define BACKFILL_PIPELINE 4
+#endif
+
+constexpr const char *BACKFILL_ARCHIVE_PATH = "/days.bin";
+// One slot more than the RAM history holds.
+constexpr uint32_t BACKFILL_ARCHIVE_DAYS = 32;
+constexpr size_t DAY_HOURS = 24;
+constexpr uint32_t SECONDS_PER_DAY = 86400;
+// The first scan waits for the first regular fetch to get through.
+constexpr uint32_t BACKFILL_START_DELAY_MS = 60UL * 1000UL;
+constexpr uint32_t BACKFILL_SCAN_INTERVAL_MS = 30UL * 60UL * 1000UL;
+constexpr uint32_t BACKFILL_BACKOFF_MIN_MS = 60UL * 1000UL;
+constexpr uint32_t BACKFILL_BACKOFF_MAX_MS = 4UL * 60UL * 60UL * 1000UL;
+constexpr uint32_t BACKFILL_TIMEOUT_MS = 10UL * 1000UL;
+constexpr size_t BACKFILL_LINE_MAX = 128;
+// Values of the ``mode`` setting that have credentials for the source.
+constexpr uint32_t MODE_CLOUD = 0;
+constexpr uint32_t MODE_SMARTMETER = 1;
+
+static_assert(BACKFILL_DAYS < BACKFILL_ARCHIVE_DAYS,
+              "the archive must hold every day that is backfilled");
+static_assert(BACKFILL_PIPELINE >= 1, "at least one request must be in flight");
+
+// How far a day got.  Only an answer fetched after the day ended has its
+// final values; what the fetchers saw while it ran stays ``DAY_LIVE``.
+enum DayState : uint8_t { DAY_MISSING, DAY_LIVE, DAY_FINAL, DAY_UNAVAILABLE };
+
+// One slot of the archive file, at offset (day % BACKFILL_ARCHIVE_DAYS).
+struct DayRecord {
+  uint32_t day;   // days since 1970-01-01, 0 for an unused slot
+  uint8_t hours;  // hours [0, hours) hold values
+  uint8_t state;  // DayState
+  uint16_t reserved;
+  float gen[DAY_HOURS];
+  float cons[DAY_HOURS];
+};
+
+// Day, hours and state of every slot, so that scans and the archiving on
+// every fetch never read the flash.  Guarded by ``archiveMutex``, which
+// also serialises the file accesses.
+struct DaySummary {
+  uint32_t day;
+  uint8_t hours;
+  uint8_t state;
+};
+
+static DaySummary summary[BACKFILL_ARCHIVE_DAYS];
+static SemaphoreHandle_t archiveMutex = nullptr;
+static bool archiveAvailable = false;
+static EnergyHistory *historyRef = nullptr;
+
+// Backfill task state.
+static TaskHandle_t backfillTaskHandle = nullptr;
+static JsonFieldMap backfillMap;
+static uint32_t filledDays = 0;
+static uint32_t failedRounds = 0;
+
+static void formatDate(uint32_t day, char *out, size_t cap) {
+  time_t t = static_cast<time_t>(day) * SECONDS_PER_DAY;
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  strftime(out, cap, "%Y-%m-%d", &tm);
+}
+
+static bool readRecord(uint32_t slot, DayRecord &rec) {
+  File f = LittleFS.open(BACKFILL_ARCHIVE_PATH, FILE_READ);
+  if (!f) {
+    return false;
+  }
+  bool ok = f.seek(slot * sizeof(DayRecord)) &&
+            f.read(reinterpret_cast<uint8_t *>(&rec), sizeof(rec)) == sizeof(rec);
+  f.close();
+  return ok;
+}
+
+// Write ``rec`` to its slot and update the summary.  Call with
+// ``archiveMutex`` held.
+static void storeDay(const DayRecord &rec) {
+  uint32_t slot = rec.day % BACKFILL_ARCHIVE_DAYS;
+  File f = LittleFS.open(BACKFILL_ARCHIVE_PATH, "r+");
+  bool ok = f && f.seek(slot * sizeof(DayRecord)) &&
+            f.write(reinterpret_cast<const uint8_t *>(&rec), sizeof(rec)) == sizeof(rec);
+  if (f) {
+    f.close();
+  }
+  if (!ok) {
+    Serial.println("Day archive: write failed");
+    return;
+  }
+  summary[slot].day = rec.day;
+  summary[slot].hours = rec.hours;
+  summary[slot].state = rec.state;
+}
+
+// Start an empty archive, e.g. on first boot.
+static bool createArchive() {
+  File f = LittleFS.open(BACKFILL_ARCHIVE_PATH, FILE_WRITE);
+  if (!f) {
+    return false;
+  }
+  DayRecord empty;
+  memset(&empty, 0, sizeof(empty));
+  bool ok = true;
+  for (uint32_t i = 0; i < BACKFILL_ARCHIVE_DAYS && ok; ++i) {
+    ok = f.write(reinterpret_cast<const uint8_t *>(&empty), sizeof(empty)) == sizeof(empty);
+  }
+  f.close();
+  return ok;
+}
+
+// ``backfill`` console command: state of the days the task looks after.
+static void backfillCommand(char *) {
+  static const char *const STATE_NAMES[] = {"missing", "live", "final", "no data"};
+  time_t now = time(nullptr);
+  if (now < 100000) {
+    Serial.println("Clock not set yet");
+    return;
+  }
+  uint32_t today = now / SECONDS_PER_DAY;
+  xSemaphoreTake(archiveMutex, portMAX_DELAY);
+  for (uint32_t i = 0; i <= BACKFILL_DAYS; ++i) {
+    uint32_t day = today - i;
+    const DaySummary &s = summary[day % BACKFILL_ARCHIVE_DAYS];
+    bool known = s.day == day;
+    char date[12];
+    formatDate(day, date, sizeof(date));
+    Serial.printf("%s  %-8s %2u h\n", date, STATE_NAMES[known ? s.state : DAY_MISSING],
+                  known ? s.hours : 0);
+  }
+  xSemaphoreGive(archiveMutex);
+  Serial.printf("%lu days backfilled, %lu failed rounds, task %s\n",
+                static_cast<unsigned long>(filledDays),
+                static_cast<unsigned long>(failedRounds),
+                backfillTaskHandle ? "running" : "stopped");
+}
+
+void loadDayArchive(EnergyHistory &history) {
+  historyRef = &history;
+  archiveMutex = xSemaphoreCreateMutex();
+  registerConsoleCommand("backfill", "show archived and backfilled days",
+                         backfillCommand);
+  if (!LittleFS.begin(true)) {
+    Serial.println("Day archive: flash unavailable");
+    return;
+  }
+  File f = LittleFS.open(BACKFILL_ARCHIVE_PATH, FILE_READ);
+  if (!f || f.size() != BACKFILL_ARCHIVE_DAYS * sizeof(DayRecord)) {
+    if (f) {
+      f.close();
+    }
+    archiveAvailable = createArchive();
+    return;
+  }
+  archiveAvailable = true;
+  DayRecord rec;
+  for (uint32_t slot = 0; slot < BACKFILL_ARCHIVE_DAYS; ++slot) {
+    DaySummary &s = summary[slot];
+    if (f.read(reinterpret_cast<uint8_t *>(&rec), sizeof(rec)) == sizeof(rec) &&
+        rec.day != 0 && rec.day % BACKFILL_ARCHIVE_DAYS == slot &&
+        rec.hours <= DAY_HOURS && rec.state <= DAY_UNAVAILABLE) {
+      s.day = rec.day;
+      s.hours = rec.hours;
+      s.state = rec.state;
+    } else {
+      memset(&s, 0, sizeof(s));
+    }
+  }
+  // Oldest first, so the history ring only ever moves forward
+  uint32_t loaded = 0;
+  for (uint32_t previous = 0;;) {
+    uint32_t next = UINT32_MAX;
+    for (const DaySummary &s : summary) {
+      if (s.day > previous && s.day < next && s.hours > 0) {
+        next = s.day;
+      }
+    }
+    if (next == UINT32_MAX) {
+      break;
+    }
+    if (f.seek((next % BACKFILL_ARCHIVE_DAYS) * sizeof(DayRecord)) &&
+        f.read(reinterpret_cast<uint8_t *>(&rec), sizeof(rec)) == sizeof(rec)) {
+      history.recordHours(rec.day * SECONDS_PER_DAY, rec.gen, rec.cons, rec.hours);
+      ++loaded;
+    }
+    previous = next;
+  }
+  f.close();
+  Serial.printf("Loaded %lu archived days\n", static_cast<unsigned long>(loaded));
+}
+
+void archiveDay(uint32_t dayStart, const float *gen, const float *cons,
+                size_t hours) {
+  if (!archiveAvailable || hours == 0) {
+    return;
+  }
+  uint32_t day = dayStart / SECONDS_PER_DAY;
+  hours = min(hours, DAY_HOURS);
+  xSemaphoreTake(archiveMutex, portMAX_DELAY);
+  const DaySummary &s = summary[day % BACKFILL_ARCHIVE_DAYS];
+  if (s.day < day || (s.day == day && s.state == DAY_LIVE && hours > s.hours)) {
+    DayRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.day = day;
+    rec.hours = hours;
+    rec.state = DAY_LIVE;
+    memcpy(rec.gen, gen, hours * sizeof(float));
+    memcpy(rec.cons, cons, hours * sizeof(float));
+    storeDay(rec);
+  }
+  xSemaphoreGive(archiveMutex);
+}
+
+// Days of the last BACKFILL_DAYS without final values, newest first.
+static size_t findGaps(uint32_t today, uint32_t *days) {
+  size_t n = 0;
+  xSemaphoreTake(archiveMutex, portMAX_DELAY);
+  for (uint32_t i = 1; i <= BACKFILL_DAYS; ++i) {
+    uint32_t day = today - i;
+    const DaySummary &s = summary[day % BACKFILL_ARCHIVE_DAYS];
+    if (s.day != day || s.state == DAY_LIVE) {
+      days[n++] = day;
+    }
+  }
+  xSemaphoreGive(archiveMutex);
+  return n;
+}
+
+// Keep the answer for ``day`` that ``backfillMap`` just read.  A day the
+// source has no complete curves for keeps whatever was seen live.
+static void storeAnswer(uint32_t day, bool found) {
+  const JsonFieldMap::Fields &f = backfillMap.fields();
+  bool complete = found && f.genLength == DAY_HOURS && f.consLength == DAY_HOURS;
+  DayRecord rec;
+  memset(&rec, 0, sizeof(rec));
+  xSemaphoreTake(archiveMutex, portMAX_DELAY);
+  uint32_t slot = day % BACKFILL_ARCHIVE_DAYS;
+  if (!complete && summary[slot].day == day) {
+    readRecord(slot, rec);
+  }
+  rec.day = day;
+  if (complete) {
+    rec.hours = DAY_HOURS;
+    memcpy(rec.gen, f.gen, sizeof(rec.gen));
+    memcpy(rec.cons, f.cons, sizeof(rec.cons));
+  }
+  rec.state = complete ? DAY_FINAL : DAY_UNAVAILABLE;
+  storeDay(rec);
+  xSemaphoreGive(archiveMutex);
+  char date[12];
+  formatDate(day, date, sizeof(date));
+  if (!complete) {
+    Serial.printf("Backfill: no data for %s\n", date);
+    return;
+  }
+  lockHistory();
+  historyRef->recordHours(day * SECONDS_PER_DAY, rec.gen, rec.cons, DAY_HOURS);
+  unlockHistory();
+  ++filledDays;
+  Serial.printf("Backfilled %s\n", date);
+}
+
+// Get a token from the cloud, like fetchAnkerData() does for every fetch.
+static bool cloudToken(String &token) {
+  String authUrl = endpointUrl(configString(ConfigKey::AnkerAuthUrl));
+  if (authUrl.length() == 0) {
+    return false;
+  }
+  WiFiClient client;
+  HTTPClient http;
+  http.begin(client, authUrl);
+  http.addHeader("Content-Type", "application/json");
+  JsonDocument loginDoc;
+  loginDoc["userAccount"] = configString(ConfigKey::AnkerUser);
+  loginDoc["password"] = configString(ConfigKey::AnkerPassword);
+  loginDoc["country"] = configString(ConfigKey::AnkerCountry);
+  String loginBody;
+  serializeJson(loginDoc, loginBody);
+  int code = http.POST(loginBody);
+  if (code != HTTP_CODE_OK) {
+    Serial.printf("Backfill: auth failed: %d\n", code);
+    http.end();
+    return false;
+  }
+  String response = http.getString();
+  http.end();
+  JsonDocument authDoc;
+  if (deserializeJson(authDoc, response)) {
+    return false;
+  }
+  const char *t = authDoc["access_token"];
+  if (!t) {
+    return false;
+  }
+  token = t;
+  return true;
+}
+
+// Split an http:// URL into the host as written (with the port, for the
+// Host header), the name to connect to, the port and the path.
+static bool splitHttpUrl(const String &url, String &host, String &name,
+                         uint16_t &port, String &path) {
+  if (!url.startsWith("http://")) {
+    return false;
+  }
+  int slash = url.indexOf('/', 7);
+  host = slash < 0 ? url.substring(7) : url.substring(7, slash);
+  path = slash < 0 ? String("/") : url.substring(slash);
+  int colon = host.indexOf(':');
+  name = colon < 0 ? host : host.substring(0, colon);
+  port = colon < 0 ? 80 : static_cast<uint16_t>(host.substring(colon + 1).toInt());
+  return name.length() > 0;
+}
+
+static bool timedOut(uint32_t deadline) {
+  return static_cast<int32_t>(millis() - deadline) >= 0;
+}
+
+// Read a header line without the line break; overlong lines are cut.
+static bool readLine(WiFiClient &client, char *line, size_t cap, uint32_t deadline) {
+  size_t n = 0;
+  for (;;) {
+    int c = client.read();
+    if (c < 0) {
+      if (!client.connected() || timedOut(deadline)) {
+        return false;
+      }
+      vTaskDelay(1);
+      continue;
+    }
+    if (c == '\n') {
+      break;
+    }
+    if (c != '\r' && n < cap - 1) {
+      line[n++] = static_cast<char>(c);
+    }
+  }
+  line[n] = '\0';
+  return true;
+}
+
+// Feed ``len`` body bytes into the field map, or everything up to the end
+// of the connection if ``len`` is SIZE_MAX.
+static bool feedBody(WiFiClient &client, size_t len, uint32_t deadline) {
+  uint8_t buf[256];
+  while (len > 0) {
+    int n = client.read(buf, min(len, sizeof(buf)));
+    if (n > 0) {
+      backfillMap.feed(buf, n);
+      if (len != SIZE_MAX) {
+        len -= n;
+      }
+      continue;
+    }
+    if (!client.connected()) {
+      return len == SIZE_MAX;
+    }
+    if (timedOut(deadline)) {
+      return false;
+    }
+    vTaskDelay(1);
+  }
+  return true;
+}
+
+static bool feedChunked(WiFiClient &client, uint32_t deadline) {
+  char line[BACKFILL_LINE_MAX];
+  for (;;) {
+    if (!readLine(client, line, sizeof(line), deadline)) {
+      return false;
+    }
+    size_t len = strtoul(line, nullptr, 16);
+    if (len == 0) {
+      break;
+    }
+    if (!feedBody(client, len, deadline) ||
+        !readLine(client, line, sizeof(line), deadline)) {
+      return false;
+    }
+  }
+  // Trailers up to the empty line
+  do {
+    if (!readLine(client, line, sizeof(line), deadline)) {
+      return false;
+    }
+  } while (line[0]);
+  return true;
+}
+
+// Whether the header value ``value`` contains ``token``, ignoring case.
+static bool headerHas(const char *value, const char *token) {
+  size_t len = strlen(token);
+  for (; *value; ++value) {
+    if (strncasecmp(value, token, len) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+enum class Answer : uint8_t { DAY, NO_DATA, RETRY, BROKEN };
+
+/*
+ * Read the next answer on the pipelined connection into ``backfillMap``.
+ * The body is always read to its end so the following answer starts at the
+ * right place.  ``keepAlive`` is cleared if the server closes the
+ * connection after this answer.
+ */
+static Answer readAnswer(WiFiClient &client, bool &keepAlive) {
+  uint32_t deadline = millis() + BACKFILL_TIMEOUT_MS;
+  char line[BACKFILL_LINE_MAX];
+  if (!readLine(client, line, sizeof(line), deadline) ||
+      strncmp(line, "HTTP/1.", 7) != 0) {
+    return Answer::BROKEN;
+  }
+  int status = atoi(line + 9);
+  keepAlive = line[7] != '0';
+  long length = -1;
+  bool chunked = false;
+  for (;;) {
+    if (!readLine(client, line, sizeof(line), deadline)) {
+      return Answer::BROKEN;
+    }
+    if (!line[0]) {
+      break;
+    }
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      length = atol(line + 15);
+    } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+      chunked = headerHas(line + 18, "chunked");
+    } else if (strncasecmp(line, "Connection:", 11) == 0) {
+      keepAlive = !headerHas(line + 11, "close");
+    }
+  }
+  backfillMap.begin();
+  bool read;
+  if (chunked) {
+    read = feedChunked(client, deadline);
+  } else if (length >= 0) {
+    read = feedBody(client, length, deadline);
+  } else {
+    keepAlive = false;
+    read = feedBody(client, SIZE_MAX, deadline);
+  }
+  if (!read) {
+    return Answer::BROKEN;
+  }
+  if (status == 200) {
+    return backfillMap.complete() ? Answer::DAY : Answer::NO_DATA;
+  }
+  if (status >= 500 || status == 429) {
+    return Answer::RETRY;
+  }
+  return Answer::NO_DATA;
+}
+
+/*
+ * Request ``days`` over one connection with up to BACKFILL_PIPELINE
+ * requests in flight.  Requests the server did not answer before closing
+ * the connection are sent again on a new one.  Returns false if the source
+ * could not be reached or reported an error; the days answered so far are
+ * kept.
+ */
+static bool fetchDays(const uint32_t *days, size_t count) {
+  String url = configString(ConfigKey::BackfillUrl);
+  uint32_t mode = configUInt(ConfigKey::Mode);
+  String auth;
+  if (mode == MODE_CLOUD) {
+    url = endpointUrl(url);
+    String token;
+    if (!cloudToken(token)) {
+      return false;
+    }
+    auth = "Authorization: Bearer " + token + "\r\n";
+  } else if (mode == MODE_SMARTMETER) {
+    String token = configString(ConfigKey::MeterToken);
+    if (token.length() > 0) {
+      auth = "Authorization: Bearer " + token + "\r\n";
+    }
+  }
+  String host, name, pathTemplate;
+  uint16_t port;
+  if (!splitHttpUrl(url, host, name, port, pathTemplate)) {
+    Serial.println("Backfill: backfill_url must be an http:// URL");
+    return false;
+  }
+  WiFiClient client;
+  size_t sent = 0;
+  size_t done = 0;
+  bool retried = false;
+  while (done < count) {
+    if (!client.connected()) {
+      if (!client.connect(name.c_str(), port, BACKFILL_TIMEOUT_MS)) {
+        Serial.printf("Backfill: cannot connect to %s\n", host.c_str());
+        return false;
+      }
+      sent = done;
+    }
+    for (; sent < count && sent - done < BACKFILL_PIPELINE; ++sent) {
+      char date[12];
+      formatDate(days[sent], date, sizeof(date));
+      String path = pathTemplate;
+      path.replace("{date}", date);
+      client.printf("GET %s HTTP/1.1\r\nHost: %s\r\n%sConnection: keep-alive\r\n\r\n",
+                    path.c_str(), host.c_str(), auth.c_str());
+    }
+    bool keepAlive = true;
+    Answer answer = readAnswer(client, keepAlive);
+    if (answer == Answer::BROKEN) {
+      // Closed without notice: one more try on a fresh connection
+      client.stop();
+      if (retried) {
+        Serial.println("Backfill: connection lost");
+        return false;
+      }
+      retried = true;
+      continue;
+    }
+    if (answer == Answer::RETRY) {
+      Serial.println("Backfill: source busy or failing");
+      client.stop();
+      return false;
+    }
+    retried = false;
+    storeAnswer(days[done++], answer == Answer::DAY);
+    if (!keepAlive) {
+      client.stop();
+    }
+    // Let the fetchers and the web server in between days
+    vTaskDelay(1);
+  }
+  client.stop();
+  return true;
+}
+
+static void compileFieldMap() {
+  String text = configString(ConfigKey::FieldMap);
+  char err[48];
+  if (!backfillMap.compile(text.length() ? text.c_str() : DEFAULT_FIELD_MAP, err,
+                           sizeof(err))) {
+    Serial.printf("Backfill: invalid field mapping: %s\n", err);
+  }
+}
+
+static void backfillTask(void *) {
+  uint32_t wait = BACKFILL_START_DELAY_MS;
+  uint32_t backoff = 0;
+  for (;;) {
+    // Woken early by wakeBackfill() and configuration changes
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+    if (configString(ConfigKey::BackfillUrl).length() == 0) {
+      break;
+    }
+    wait = BACKFILL_SCAN_INTERVAL_MS;
+    time_t now = time(nullptr);
+    if (WiFi.status() != WL_CONNECTED || now < 100000) {
+      continue;
+    }
+    uint32_t days[BACKFILL_DAYS];
+    size_t n = findGaps(now / SECONDS_PER_DAY, days);
+    if (n == 0) {
+      backoff = 0;
+      continue;
+    }
+    Serial.printf("Backfilling %u days\n", static_cast<unsigned>(n));
+    compileFieldMap();
+    if (fetchDays(days, n)) {
+      backoff = 0;
+      continue;
+    }
+    ++failedRounds;
+    backoff = backoff == 0 ? BACKFILL_BACKOFF_MIN_MS
+                           : min(backoff * 2, BACKFILL_BACKOFF_MAX_MS);
+    wait = backoff;
+  }
+  backfillTaskHandle = nullptr;
+  vTaskDelete(nullptr);
+}
+
+bool beginBackfill() {
+  if (backfillTaskHandle) {
+    wakeBackfill();
+    return true;
+  }
+  if (!archiveAvailable || configString(ConfigKey::BackfillUrl).length() == 0) {
+    return false;
+  }
+  // Idle priority: old days can always wait for drawing and fetching
+  if (xTaskCreatePinnedToCore(backfillTask, "backfill", 6144, nullptr,
+                              tskIDLE_PRIORITY, &backfillTaskHandle,
+                              0) != pdPASS) {
+    Serial.println("Failed to start backfill task");
+    backfillTaskHandle = nullptr;
+    return false;
+  }
+  return true;
+}
+
+void wakeBackfill() {
+  if (backfillTaskHandle) {
+    xTaskNotifyGive(backfillTaskHandle);
+  }
+}
@@ -0,0 +1,64 @@
+/*
+  -----------------------------------------------------------------------------
+  backfill.h — Day archive and backfill of days missed while offline
+
+  The sources only report today's curve, so a day the display spent
+  offline would be missing from the history for good.  Every day is
+  therefore kept in a small archive on the internal flash (``/days.bin``,
+  one fixed slot per day for the last ``BACKFILL_ARCHIVE_DAYS`` days):
+
+    • the fetchers add today's hours as they arrive, one write per hour;
+    • at boot the archive is loaded into the RAM history, so the graph
+      can be panned back right away;
+    • a background task looks for days of the last ``BACKFILL_DAYS`` that
+      are missing or were only seen while they were still running, and
+      requests them from the source.
+
+  Missing days are requested over a single keep-alive connection with up
+  to ``BACKFILL_PIPELINE`` requests in flight, so a week costs about one
+  round trip instead of seven.  Each day is written to the archive as soon
+  as its answer has been read: the archive is the checkpoint, and after a
+  reboot the task simply carries on with the days still missing.  Days the
+  source has no data for (404, or no complete curves) are not asked for
+  again.
+
+  The task runs at idle priority and yields between answers, so drawing
+  and the regular fetches are never delayed.  It scans every half hour and
+  right after a fetch succeeds following a failure.
+
+  The source is part of the runtime settings (``config_store.h``), with
+  the default from ``secrets.h``:
+    backfill_url – URL of the energy document of one day, with ``{date}``
+                   standing for the UTC date (YYYY-MM-DD), e.g.
+                   "http://192.168.0.50/api/daily?date={date}"
+                   (BACKFILL_URL).  Empty disables the backfill; the
+                   archive is kept either way.
+  In cloud mode the host follows the selected endpoint and the request
+  carries a token from the auth URL; in smart-meter mode ``meter_token``
+  is sent.  The answer is read through ``field_map``.  ``backfill`` on the
+  console lists the state of every archived day.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "history.h"
+
+// Mount the flash, load the archived days into ``history`` and remember
+// it for the backfill task.  Call once before other tasks use the history.
+void loadDayArchive(EnergyHistory &history);
+
+// Start the backfill task.  Returns false if no ``backfill_url`` is
+// configured; the task ends by itself when it is removed again.
+bool beginBackfill();
+
+// Keep the hours [0, hours) of the day starting at ``dayStart`` (UNIX
+// seconds, UTC midnight) in the archive.  Only writes to the flash when a
+// new hour or a new day has begun.
+void archiveDay(uint32_t dayStart, const float *gen, const float *cons,
+                size_t hours);
+
+// Look for missing days now, e.g. after the source was unreachable.
+void wakeBackfill();
@@ -0,0 +1,388 @@
+#include "config_store.h"
+
+#include <ArduinoJson.h>
+#include <Preferences.h>
+#include <WebServer.h>
+#include <atomic>
+#include <memory>
+
+#include "console.h"
+#include "secrets.h"
+#include "web_server.h"
+
+// Older ``secrets.h`` files predate the optional settings.
+#ifndef ANKER_HOSTS
+#define ANKER_HOSTS ""
+#endif
+#ifndef FIELD_MAP
+#define FIELD_MAP ""
+#endif
+#ifndef DERIVED_VALUES
+#define DERIVED_VALUES ""
+#endif
+#ifndef BACKFILL_URL
+#define BACKFILL_URL ""
+#endif
+#ifndef RPC_METER_HOST
+#define RPC_METER_HOST ""
+#endif
+#ifndef RPC_METER_KIND
+#define RPC_METER_KIND "shelly-pro3em"
+#endif
+#ifndef RPC_METER_GENERATOR
+#define RPC_METER_GENERATOR 0
+#endif
+#ifndef INFLUX_WRITE_URL
+#define INFLUX_WRITE_URL ""
+#endif
+#ifndef INFLUX_TOKEN
+#define INFLUX_TOKEN ""
+#endif
+#ifndef ADMIN_TOKEN
+#define ADMIN_TOKEN ""
+#endif
+#ifndef ALARM_RULES
+#define ALARM_RULES ""
+#endif
+#ifndef ALARM_URL
+#define ALARM_URL ""
+#endif
+
+static_assert(sizeof(FIELD_MAP) <= CONFIG_TEXT_MAX,
+              "FIELD_MAP is longer than CONFIG_TEXT_MAX - 1 characters");
+static_assert(sizeof(DERIVED_VALUES) <= CONFIG_TEXT_MAX,
+              "DERIVED_VALUES is longer than CONFIG_TEXT_MAX - 1 characters");
+static_assert(sizeof(ALARM_RULES) <= CONFIG_TEXT_MAX,
+              "ALARM_RULES is longer than CONFIG_TEXT_MAX - 1 characters");
+
+// Names of the operation modes in the order of ``Mode`` in main.cpp.
+static const char *const MODE_CHOICES[] = {"cloud", "smartmeter", "optical",
+                                           "rpc", nullptr};
+
+#define CFG_STR(name, group, secret, def) \
+  {name, ConfigType::STRING, group, secret, def, 0, 0, 0, nullptr, CONFIG_STR_MAX - 1}
+// Mappings and lists, which need more room than a URL or a password.
+#define CFG_TEXT(name, group, def) \
+  {name, ConfigType::STRING, group, false, def, 0, 0, 0, nullptr, CONFIG_TEXT_MAX - 1}
+#define CFG_UINT(name, group, def, lo, hi) \
+  {name, ConfigType::UINT, group, false, nullptr, def, lo, hi, nullptr, 0}
+
+// One entry per ConfigKey, in the same order.
+static const ConfigDesc CONFIG_DESCS[] = {
+    CFG_STR("wifi_ssid", CFG_GROUP_WIFI, false, WIFI_SSID),
+    CFG_STR("wifi_password", CFG_GROUP_WIFI, true, WIFI_PASSWORD),
+    {"mode", ConfigType::ENUM, CFG_GROUP_MODE, false, nullptr, 0, 0, 3,
+     MODE_CHOICES, 0},
+    CFG_UINT("refresh_s", CFG_GROUP_SCHEDULE, 300, 10, 86400),
+    CFG_UINT("retry_s", CFG_GROUP_SCHEDULE, 180, 10, 86400),
+    CFG_UINT("brightness", CFG_GROUP_DISPLAY, 255, 0, 255),
+    CFG_TEXT("derived", CFG_GROUP_DISPLAY, DERIVED_VALUES),
+    CFG_STR("anker_user", CFG_GROUP_ANKER, false, ANKER_USER),
+    CFG_STR("anker_password", CFG_GROUP_ANKER, true, ANKER_PASSWORD),
+    CFG_STR("anker_country", CFG_GROUP_ANKER, false, ANKER_COUNTRY),
+    CFG_STR("anker_auth_url", CFG_GROUP_ANKER, false, ANKER_AUTH_URL),
+    CFG_STR("anker_data_url", CFG_GROUP_ANKER, false, ANKER_ENERGY_URL),
+    CFG_STR("anker_hosts", CFG_GROUP_ANKER, false, ANKER_HOSTS),
+    CFG_STR("meter_host", CFG_GROUP_SMARTMETER, false, SMARTMETER_HOST),
+    CFG_STR("meter_endpoint", CFG_GROUP_SMARTMETER, false,
+            SMARTMETER_ENERGY_ENDPOINT),
+    CFG_STR("meter_token", CFG_GROUP_SMARTMETER, true, SMARTMETER_TOKEN),
+    CFG_TEXT("field_map", CFG_GROUP_ANKER | CFG_GROUP_SMARTMETER, FIELD_MAP),
+    CFG_STR("backfill_url", CFG_GROUP_BACKFILL, false, BACKFILL_URL),
+    CFG_STR("rpc_host", CFG_GROUP_RPC, false, RPC_METER_HOST),
+    CFG_STR("rpc_kind", CFG_GROUP_RPC, false, RPC_METER_KIND),
+    CFG_UINT("rpc_generator", CFG_GROUP_RPC, RPC_METER_GENERATOR, 0, 1),
+    CFG_STR("influx_url", CFG_GROUP_EXPORT, false, INFLUX_WRITE_URL),
+    CFG_STR("influx_token", CFG_GROUP_EXPORT, true, INFLUX_TOKEN),
+    CFG_STR("admin_token", 0, true, ADMIN_TOKEN),
+    CFG_TEXT("alarm_rules", CFG_GROUP_ALARM, ALARM_RULES),
+    CFG_STR("alarm_url", CFG_GROUP_ALARM, false, ALARM_URL),
+};
+static_assert(sizeof(CONFIG_DESCS) / sizeof(CONFIG_DESCS[0]) ==
+                  static_cast<size_t>(ConfigKey::Count),
+              "CONFIG_DESCS must list every ConfigKey");
+
+constexpr size_t KEY_COUNT = static_cast<size_t>(ConfigKey::Count);
+
+// Cached values.  Numbers are read with a single atomic load; strings are
+// protected by the sequence counter ``stringSeq`` (odd while a write is in
+// progress) so readers never block.
+static std::atomic<uint32_t> numbers[KEY_COUNT];
+static char *strings[KEY_COUNT]; // maxLength + 1 bytes each, from beginConfig()
+static std::atomic<uint32_t> stringSeq(0);
+static portMUX_TYPE stringMux = portMUX_INITIALIZER_UNLOCKED;
+
+static std::atomic<uint32_t> pendingChanges(0);
+static SemaphoreHandle_t writeLock = nullptr;
+static Preferences prefs;
+
+static int findKey(const char *name) {
+  for (size_t i = 0; i < KEY_COUNT; ++i) {
+    if (strcmp(CONFIG_DESCS[i].name, name) == 0) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+// Replace a cached string.  The copy runs with preemption disabled so a
+// reader on the other core only ever spins for the duration of a memcpy.
+static void storeString(size_t i, const char *value) {
+  portENTER_CRITICAL(&stringMux);
+  stringSeq.fetch_add(1, std::memory_order_acq_rel);
+  strlcpy(strings[i], value, CONFIG_DESCS[i].maxLength + 1);
+  stringSeq.fetch_add(1, std::memory_order_release);
+  portEXIT_CRITICAL(&stringMux);
+}
+
+const ConfigDesc &configDesc(ConfigKey key) {
+  return CONFIG_DESCS[static_cast<size_t>(key)];
+}
+
+uint32_t configUInt(ConfigKey key) {
+  return numbers[static_cast<size_t>(key)].load(std::memory_order_relaxed);
+}
+
+size_t configString(ConfigKey key, char *out, size_t cap) {
+  size_t i = static_cast<size_t>(key);
+  for (;;) {
+    uint32_t seq = stringSeq.load(std::memory_order_acquire);
+    if (seq & 1) {
+      continue;
+    }
+    strlcpy(out, strings[i], cap);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (stringSeq.load(std::memory_order_relaxed) == seq) {
+      return strlen(out);
+    }
+  }
+}
+
+String configString(ConfigKey key) {
+  char buf[CONFIG_STR_MAX];
+  size_t cap = configDesc(key).maxLength + 1;
+  if (cap <= sizeof(buf)) {
+    configString(key, buf, sizeof(buf));
+    return String(buf);
+  }
+  std::unique_ptr<char[]> text(new char[cap]);
+  configString(key, text.get(), cap);
+  return String(text.get());
+}
+
+String configText(ConfigKey key, bool mask) {
+  const ConfigDesc &d = configDesc(key);
+  switch (d.type) {
+  case ConfigType::STRING: {
+    String s = configString(key);
+    if (mask && d.secret && s.length() > 0) {
+      return String("********");
+    }
+    return s;
+  }
+  case ConfigType::ENUM:
+    return String(d.choices[configUInt(key)]);
+  case ConfigType::UINT:
+    break;
+  }
+  return String(configUInt(key));
+}
+
+// Parse ``text`` for key ``i``.  Numbers are returned in ``number``; enum
+// keys accept either the choice name or its index.
+static bool parseValue(size_t i, const char *text, uint32_t &number) {
+  const ConfigDesc &d = CONFIG_DESCS[i];
+  if (d.type == ConfigType::STRING) {
+    return strlen(text) <= d.maxLength;
+  }
+  if (d.type == ConfigType::ENUM) {
+    for (uint32_t c = 0; d.choices[c]; ++c) {
+      if (strcmp(d.choices[c], text) == 0) {
+        number = c;
+        return true;
+      }
+    }
+  }
+  char *end;
+  unsigned long v = strtoul(text, &end, 10);
+  if (end == text || *end != '\0' || v < d.minValue || v > d.maxValue) {
+    return false;
+  }
+  number = v;
+  return true;
+}
+
+// Update cache and NVS for key ``i``.  ``text`` is null to restore the
+// factory default.
+static bool applyValue(size_t i, const char *text) {
+  const ConfigDesc &d = CONFIG_DESCS[i];
+  uint32_t number = d.defNumber;
+  if (text && !parseValue(i, text, number)) {
+    return false;
+  }
+  xSemaphoreTake(writeLock, portMAX_DELAY);
+  bool changed;
+  if (d.type == ConfigType::STRING) {
+    const char *value = text ? text : d.defString;
+    changed = strcmp(strings[i], value) != 0;
+    if (changed) {
+      storeString(i, value);
+    }
+    if (text) {
+      prefs.putString(d.name, value);
+    }
+  } else {
+    changed = numbers[i].exchange(number) != number;
+    if (text) {
+      prefs.putUInt(d.name, number);
+    }
+  }
+  if (!text) {
+    prefs.remove(d.name);
+  }
+  xSemaphoreGive(writeLock);
+  if (changed) {
+    pendingChanges.fetch_or(d.group);
+  }
+  return true;
+}
+
+bool setConfig(const char *name, const char *value) {
+  int i = findKey(name);
+  if (i < 0 || !applyValue(i, value)) {
+    Serial.printf("Invalid config %s=%s\n", name, value);
+    return false;
+  }
+  return true;
+}
+
+bool resetConfig(const char *name) {
+  int i = findKey(name);
+  return i >= 0 && applyValue(i, nullptr);
+}
+
+uint32_t takeConfigChanges() {
+  return pendingChanges.exchange(0);
+}
+
+// ``config [list | get <key> | set <key> <value> | reset <key>]``
+static void configCommand(char *args) {
+  char *verb = strtok(args, " ");
+  char *key = strtok(nullptr, " ");
+  char *value = strtok(nullptr, "");
+  if (!verb || strcmp(verb, "list") == 0) {
+    for (size_t i = 0; i < KEY_COUNT; ++i) {
+      Serial.printf("  %-15s %s\n", CONFIG_DESCS[i].name,
+                    configText(static_cast<ConfigKey>(i), true).c_str());
+    }
+    return;
+  }
+  int i = key ? findKey(key) : -1;
+  if (i < 0) {
+    Serial.println("Unknown config key");
+    return;
+  }
+  if (strcmp(verb, "get") == 0) {
+    Serial.println(configText(static_cast<ConfigKey>(i), false));
+  } else if (strcmp(verb, "set") == 0) {
+    if (setConfig(key, value ? value : "")) {
+      Serial.println("OK");
+    }
+  } else if (strcmp(verb, "reset") == 0) {
+    resetConfig(key);
+    Serial.println("OK");
+  } else {
+    Serial.println("Usage: config [list|get <key>|set <key> <value>|reset <key>]");
+  }
+}
+
+void beginConfig() {
+  if (writeLock) {
+    return;
+  }
+  writeLock = xSemaphoreCreateMutex();
+  prefs.begin("solix", false);
+  for (size_t i = 0; i < KEY_COUNT; ++i) {
+    const ConfigDesc &d = CONFIG_DESCS[i];
+    if (d.type == ConfigType::STRING) {
+      strings[i] = new char[d.maxLength + 1];
+      strings[i][0] = '\0';
+      if (prefs.isKey(d.name)) {
+        prefs.getString(d.name, strings[i], d.maxLength + 1);
+      } else if (strlen(d.defString) > d.maxLength) {
+        // A cut-off mapping or URL would silently do the wrong thing
+        Serial.printf("Default of %s is longer than %u characters, ignored\n",
+                      d.name, static_cast<unsigned>(d.maxLength));
+      } else {
+        strlcpy(strings[i], d.defString, d.maxLength + 1);
+      }
+    } else {
+      uint32_t v = prefs.getUInt(d.name, d.defNumber);
+      if (v < d.minValue || v > d.maxValue) {
+        v = d.defNumber;
+      }
+      numbers[i].store(v);
+    }
+  }
+  registerConsoleCommand("config", "list|get|set|reset runtime settings",
+                         configCommand);
+}
+
+// Writes require the admin token when one is configured.
+static bool authorised(WebServer &server) {
+  char token[CONFIG_STR_MAX];
+  if (configString(ConfigKey::AdminToken, token, sizeof(token)) == 0) {
+    return true;
+  }
+  String given = server.hasHeader("X-Admin-Token") ? server.header("X-Admin-Token")
+                                                   : server.arg("token");
+  return given == token;
+}
+
+void registerConfigRoutes(WebServer &server) {
+  collectRequestHeader("X-Admin-Token");
+  WebServer *srv = &server;
+  server.on("/api/config", HTTP_GET, [srv]() {
+    JsonDocument doc;
+    for (size_t i = 0; i < KEY_COUNT; ++i) {
+      doc[CONFIG_DESCS[i].name] = configText(static_cast<ConfigKey>(i), true);
+    }
+    String body;
+    serializeJson(doc, body);
+    srv->send(200, "application/json", body);
+  });
+  // Form-encoded ``key=value`` pairs; all keys are validated first so a bad
+  // request changes nothing.
+  server.on("/api/config", HTTP_POST, [srv]() {
+    if (!authorised(*srv)) {
+      srv->send(403, "text/plain", "Forbidden\n");
+      return;
+    }
+    for (int a = 0; a < srv->args(); ++a) {
+      String name = srv->argName(a);
+      if (name == "token" || name == "plain") {
+        continue;
+      }
+      int i = findKey(name.c_str());
+      uint32_t number;
+      if (i >= 0 && CONFIG_DESCS[i].type == ConfigType::STRING &&
+          srv->arg(a).length() > CONFIG_DESCS[i].maxLength) {
+        srv->send(400, "text/plain",
+                  name + " is longer than " + String(CONFIG_DESCS[i].maxLength) +
+                      " characters\n");
+        return;
+      }
+      if (i < 0 || !parseValue(i, srv->arg(a).c_str(), number)) {
+        srv->send(400, "text/plain", String("Invalid value for ") + name + "\n");
+        return;
+      }
+    }
+    for (int a = 0; a < srv->args(); ++a) {
+      String name = srv->argName(a);
+      if (name != "token" && name != "plain") {
+        setConfig(name.c_str(), srv->arg(a).c_str());
+      }
+    }
+    srv->send(200, "text/plain", "OK\n");
+  });
+}
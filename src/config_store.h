@@ -0,0 +1,120 @@
+/*
+  -----------------------------------------------------------------------------
+  config_store.h — Typed runtime configuration kept in NVS
+
+  Every setting that used to be a compile-time macro in ``secrets.h`` is a
+  typed key here.  The macros remain as factory defaults; values changed at
+  run time are persisted in NVS (``Preferences``) and survive reboots.
+
+  Reads never touch NVS and never take a lock: numeric values are cached in
+  atomics and strings are copied out of a RAM cache guarded by a sequence
+  lock, so even code on the hot path can query the configuration freely.
+
+  Changes are made over the serial console (``config set <key> <value>``)
+  or HTTP (``POST /api/config``).  Each key belongs to a group; the main loop
+  collects the groups touched since its last check with
+  ``takeConfigChanges()`` and re-applies only those, e.g. reconnecting the
+  active source when its endpoint changed or re-running only the backlight
+  setup when the brightness changed.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+class WebServer;
+
+enum class ConfigKey : uint8_t {
+  WifiSsid,
+  WifiPassword,
+  Mode,
+  RefreshS,
+  RetryS,
+  Brightness,
+  Derived,
+  AnkerUser,
+  AnkerPassword,
+  AnkerCountry,
+  AnkerAuthUrl,
+  AnkerEnergyUrl,
+  AnkerHosts,
+  MeterHost,
+  MeterEndpoint,
+  MeterToken,
+  FieldMap,
+  BackfillUrl,
+  RpcHost,
+  RpcKind,
+  RpcGenerator,
+  InfluxUrl,
+  InfluxToken,
+  AdminToken,
+  AlarmRules,
+  AlarmUrl,
+  Count
+};
+
+// Subsystems affected by a key.  Returned as a bit mask by
+// ``takeConfigChanges()``.
+enum ConfigGroup : uint32_t {
+  CFG_GROUP_WIFI = 1u << 0,
+  CFG_GROUP_MODE = 1u << 1,
+  CFG_GROUP_SCHEDULE = 1u << 2,
+  CFG_GROUP_DISPLAY = 1u << 3,
+  CFG_GROUP_ANKER = 1u << 4,
+  CFG_GROUP_SMARTMETER = 1u << 5,
+  CFG_GROUP_RPC = 1u << 6,
+  CFG_GROUP_EXPORT = 1u << 7,
+  CFG_GROUP_ALARM = 1u << 8,
+  CFG_GROUP_BACKFILL = 1u << 9,
+};
+
+enum class ConfigType : uint8_t { STRING, UINT, ENUM };
+
+struct ConfigDesc {
+  const char *name;      // key name, also used as the NVS key (<= 15 chars)
+  ConfigType type;
+  uint32_t group;        // ConfigGroup bits
+  bool secret;           // masked when listed
+  const char *defString; // default for STRING keys
+  uint32_t defNumber;    // default for UINT / ENUM keys
+  uint32_t minValue;     // UINT range
+  uint32_t maxValue;
+  const char *const *choices; // ENUM names, null terminated
+  uint16_t maxLength;    // STRING: longest value in characters
+};
+
+// Buffer size for the value of a STRING key, including the terminator.
+// Mappings, row lists and alarm rules get the larger CONFIG_TEXT_MAX; see
+// ``configDesc(key).maxLength``.
+constexpr size_t CONFIG_STR_MAX = 128;
+constexpr size_t CONFIG_TEXT_MAX = 512;
+
+// Load all keys from NVS (falling back to the ``secrets.h`` defaults) and
+// register the ``config`` console command.
+void beginConfig();
+
+// Register ``GET/POST /api/config`` on the web server.
+void registerConfigRoutes(WebServer &server);
+
+// Lock-free reads of the cached values.  The buffer overload truncates to
+// ``cap``.
+uint32_t configUInt(ConfigKey key);
+String configString(ConfigKey key);
+size_t configString(ConfigKey key, char *out, size_t cap);
+
+// Change a key by name.  ``value`` is parsed according to the key's type.
+// Returns false for unknown keys or invalid values.
+bool setConfig(const char *name, const char *value);
+
+// Restore the factory default of a key.
+bool resetConfig(const char *name);
+
+// Format a value for display; secrets are masked when ``mask`` is set.
+String configText(ConfigKey key, bool mask);
+
+const ConfigDesc &configDesc(ConfigKey key);
+
+// Groups changed since the previous call.
+uint32_t takeConfigChanges();
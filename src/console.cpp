@@ -0,0 +1,56 @@
+#include "console.h"
+
+constexpr size_t CONSOLE_MAX_COMMANDS = 12;
+constexpr size_t CONSOLE_LINE_MAX = 160;
+
+struct ConsoleCommand {
+  const char *name;
+  const char *help;
+  ConsoleHandler handler;
+};
+
+static ConsoleCommand commands[CONSOLE_MAX_COMMANDS];
+static size_t commandCount = 0;
+static char line[CONSOLE_LINE_MAX];
+static size_t lineLen = 0;
+
+void registerConsoleCommand(const char *name, const char *help,
+                            ConsoleHandler handler) {
+  if (commandCount < CONSOLE_MAX_COMMANDS) {
+    commands[commandCount++] = {name, help, handler};
+  }
+}
+
+static void dispatch(char *text) {
+  char *args = strchr(text, ' ');
+  if (args) {
+    *args++ = '\0';
+  } else {
+    args = text + strlen(text);
+  }
+  for (size_t i = 0; i < commandCount; ++i) {
+    if (strcmp(commands[i].name, text) == 0) {
+      commands[i].handler(args);
+      return;
+    }
+  }
+  Serial.println("Commands:");
+  for (size_t i = 0; i < commandCount; ++i) {
+    Serial.printf("  %-10s %s\n", commands[i].name, commands[i].help);
+  }
+}
+
+void pollConsole() {
+  while (Serial.available() > 0) {
+    char c = static_cast<char>(Serial.read());
+    if (c == '\r' || c == '\n') {
+      if (lineLen > 0) {
+        line[lineLen] = '\0';
+        lineLen = 0;
+        dispatch(line);
+      }
+    } else if (lineLen < CONSOLE_LINE_MAX - 1) {
+      line[lineLen++] = c;
+    }
+  }
+}
@@ -0,0 +1,23 @@
+/*
+  -----------------------------------------------------------------------------
+  console.h — Line-based command console on the USB serial port
+
+  Modules register named commands; ``pollConsole()`` collects characters
+  from ``Serial`` without blocking and dispatches complete lines.  Typing
+  ``help`` lists the registered commands.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+// Receives the text after the command name (may be empty).  The buffer may
+// be modified, e.g. with strtok().
+typedef void (*ConsoleHandler)(char *args);
+
+void registerConsoleCommand(const char *name, const char *help,
+                            ConsoleHandler handler);
+
+// Read pending serial input and run complete commands.  Call from loop().
+void pollConsole();
@@ -0,0 +1,88 @@
+#include "content_hash.h"
+
+#include <string.h>
+
+static constexpr uint32_t P1 = 2654435761u;
+static constexpr uint32_t P2 = 2246822519u;
+static constexpr uint32_t P3 = 3266489917u;
+static constexpr uint32_t P4 = 668265263u;
+static constexpr uint32_t P5 = 374761393u;
+
+static inline uint32_t rotl(uint32_t x, int r) {
+  return (x << r) | (x >> (32 - r));
+}
+
+// Little-endian load, independent of alignment and host byte order.
+static inline uint32_t read32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static inline uint32_t round32(uint32_t acc, uint32_t input) {
+  return rotl(acc + input * P2, 13) * P1;
+}
+
+void Xxh32::reset(uint32_t seed) {
+  seed_ = seed;
+  v_[0] = seed + P1 + P2;
+  v_[1] = seed + P2;
+  v_[2] = seed;
+  v_[3] = seed - P1;
+  total_ = 0;
+  bufLen_ = 0;
+}
+
+void Xxh32::update(const uint8_t *data, size_t len) {
+  total_ += static_cast<uint32_t>(len);
+  if (bufLen_ + len < sizeof(buf_)) {
+    memcpy(buf_ + bufLen_, data, len);
+    bufLen_ += static_cast<uint8_t>(len);
+    return;
+  }
+  if (bufLen_) {
+    size_t fill = sizeof(buf_) - bufLen_;
+    memcpy(buf_ + bufLen_, data, fill);
+    for (int i = 0; i < 4; ++i) {
+      v_[i] = round32(v_[i], read32(buf_ + 4 * i));
+    }
+    data += fill;
+    len -= fill;
+    bufLen_ = 0;
+  }
+  uint32_t v0 = v_[0], v1 = v_[1], v2 = v_[2], v3 = v_[3];
+  for (; len >= 16; data += 16, len -= 16) {
+    v0 = round32(v0, read32(data));
+    v1 = round32(v1, read32(data + 4));
+    v2 = round32(v2, read32(data + 8));
+    v3 = round32(v3, read32(data + 12));
+  }
+  v_[0] = v0;
+  v_[1] = v1;
+  v_[2] = v2;
+  v_[3] = v3;
+  memcpy(buf_, data, len);
+  bufLen_ = static_cast<uint8_t>(len);
+}
+
+uint32_t Xxh32::digest() const {
+  uint32_t h;
+  if (total_ >= 16) {
+    h = rotl(v_[0], 1) + rotl(v_[1], 7) + rotl(v_[2], 12) + rotl(v_[3], 18);
+  } else {
+    h = seed_ + P5;
+  }
+  h += total_;
+  const uint8_t *p = buf_;
+  size_t n = bufLen_;
+  for (; n >= 4; p += 4, n -= 4) {
+    h = rotl(h + read32(p) * P3, 17) * P4;
+  }
+  for (; n > 0; ++p, --n) {
+    h = rotl(h + *p * P5, 11) * P1;
+  }
+  h ^= h >> 15;
+  h *= P2;
+  h ^= h >> 13;
+  h *= P3;
+  h ^= h >> 16;
+  return h;
+}
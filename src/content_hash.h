@@ -0,0 +1,44 @@
+/*
+  -----------------------------------------------------------------------------
+  content_hash.h — Incremental xxHash32 of streamed payloads
+
+  Many sources answer every poll with the same bytes, and few of them
+  support conditional requests.  Hashing the body while it is received
+  lets the caller recognise a repeated answer without keeping the previous
+  one: a 32-bit digest is all that has to be stored.
+
+  XXH32 consumes four 32-bit lanes per 16 bytes and runs at several bytes
+  per cycle, so hashing costs far less than receiving the data.  The
+  digest is identical to the reference implementation for any split of
+  the input into ``update()`` calls.
+
+  The code is plain C++ so it can be checked on a host.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class Xxh32 {
+public:
+  explicit Xxh32(uint32_t seed = 0) { reset(seed); }
+
+  // Start a new digest.
+  void reset(uint32_t seed = 0);
+
+  // Add ``len`` bytes.
+  void update(const uint8_t *data, size_t len);
+
+  // Digest of everything added since ``reset()``.  Does not change the
+  // state, so more bytes may follow.
+  uint32_t digest() const;
+
+private:
+  uint32_t v_[4];
+  uint32_t seed_;
+  uint32_t total_;
+  uint8_t buf_[16];
+  uint8_t bufLen_;
+};
@@ -0,0 +1,107 @@
+#include "dashboard.h"
+
+#include <ArduinoJson.h>
+#include <memory>
+
+#include "web_assets.h"
+#include "web_server.h"
+
+// The serialised snapshot.  Handlers take a reference under the spinlock
+// and send the body without holding it.
+struct PublishedSnapshot {
+  String body;
+  String etag;
+};
+
+static portMUX_TYPE snapshotMux = portMUX_INITIALIZER_UNLOCKED;
+static std::shared_ptr<const PublishedSnapshot> current;
+static uint32_t sequence = 0;
+
+static bool notModified(WebServer &server, const char *etag) {
+  return server.hasHeader("If-None-Match") &&
+         server.header("If-None-Match") == etag;
+}
+
+static void sendAsset(WebServer &server, const WebAsset &asset) {
+  server.sendHeader("ETag", asset.etag);
+  server.sendHeader("Cache-Control", asset.immutable
+                                         ? "public, max-age=31536000, immutable"
+                                         : "no-cache");
+  if (notModified(server, asset.etag)) {
+    server.send(304);
+    return;
+  }
+  server.sendHeader("Content-Encoding", "gzip");
+  server.send_P(200, asset.type, reinterpret_cast<const char *>(asset.gzip),
+                asset.length);
+}
+
+static void sendSnapshot(WebServer &server) {
+  portENTER_CRITICAL(&snapshotMux);
+  std::shared_ptr<const PublishedSnapshot> snap = current;
+  portEXIT_CRITICAL(&snapshotMux);
+  if (!snap) {
+    server.send(503, "text/plain", "No data yet\n");
+    return;
+  }
+  server.sendHeader("ETag", snap->etag);
+  server.sendHeader("Cache-Control", "no-cache");
+  if (notModified(server, snap->etag.c_str())) {
+    server.send(304);
+    return;
+  }
+  server.send(200, "application/json", snap->body);
+}
+
+void registerDashboardRoutes(WebServer &server) {
+  collectRequestHeader("If-None-Match");
+  WebServer *srv = &server;
+  for (const WebAsset &asset : WEB_ASSETS) {
+    const WebAsset *a = &asset;
+    srv->on(a->path, HTTP_GET, [srv, a]() { sendAsset(*srv, *a); });
+  }
+  srv->on("/api/now", HTTP_GET, [srv]() { sendSnapshot(*srv); });
+}
+
+// NaN is not valid JSON; missing values are sent as null.
+static void setValue(JsonVariant v, float value) {
+  if (isnan(value)) {
+    v.set(nullptr);
+  } else {
+    v.set(value);
+  }
+}
+
+void publishDashboard(const DashboardSnapshot &s) {
+  std::shared_ptr<PublishedSnapshot> next(new (std::nothrow) PublishedSnapshot);
+  if (!next) {
+    return;
+  }
+  JsonDocument doc;
+  doc["seq"] = ++sequence;
+  doc["time"] = s.time;
+  doc["updated"] = s.updated;
+  setValue(doc["battery"], s.batteryPercent);
+  setValue(doc["generation"], s.dailyGeneration);
+  setValue(doc["consumption"], s.dailyConsumption);
+  doc["live"] = s.live;
+  setValue(doc["power"], s.powerW);
+  JsonArray gen = doc["gen"].to<JsonArray>();
+  JsonArray cons = doc["cons"].to<JsonArray>();
+  for (size_t i = 0; i < s.points; ++i) {
+    setValue(gen.add<JsonVariant>(), s.gen[i]);
+    setValue(cons.add<JsonVariant>(), s.cons[i]);
+  }
+  if (s.alarm) {
+    doc["alarm"] = s.alarm;
+  }
+  serializeJson(doc, next->body);
+  next->etag = String("\"") + sequence + "\"";
+
+  std::shared_ptr<const PublishedSnapshot> previous = next;
+  portENTER_CRITICAL(&snapshotMux);
+  current.swap(previous);
+  portEXIT_CRITICAL(&snapshotMux);
+  // ``previous`` now holds the old snapshot and is released here, outside
+  // the spinlock
+}
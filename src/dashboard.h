@@ -0,0 +1,39 @@
+/*
+  -----------------------------------------------------------------------------
+  dashboard.h — Browser dashboard for phones on the LAN
+
+  ``/`` serves a page that shows the same values and curves as the TFT.  Its
+  files live gzip-compressed in flash (``src/web_assets.h``, generated from
+  ``web/`` by ``tools/embed_assets.py``) and are sent as they are with
+  ``Content-Encoding: gzip``.  Scripts and style sheets carry their content
+  hash in the name and may be cached for a year.
+
+  The page polls ``/api/now``.  loop() serialises the values once per change
+  with ``publishDashboard()``; requests only send the finished buffer, or
+  304 if the client already has it, so many clients cost the display loop
+  nothing.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <WebServer.h>
+
+struct DashboardSnapshot {
+  float batteryPercent;
+  float dailyGeneration;
+  float dailyConsumption;
+  float powerW;            // NaN without a live source
+  bool live;               // the source delivers instantaneous power
+  const float *gen;        // hourly curve of today, ``points`` values
+  const float *cons;
+  size_t points;
+  const char *updated;     // time of the last successful fetch
+  uint32_t time;           // UNIX time of the snapshot, 0 if unknown
+  const char *alarm;       // banner text, nullptr without active alarms
+};
+
+void registerDashboardRoutes(WebServer &server);
+
+// Replace the data served by ``/api/now``.
+void publishDashboard(const DashboardSnapshot &snapshot);
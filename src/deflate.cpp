@@ -0,0 +1,199 @@
+#include "deflate.h"
+
+#include <string.h>
+
+// Base lengths and extra bits of the length symbols 257..285.
+static const uint16_t LEN_BASE[29] = {3,  4,  5,  6,   7,   8,   9,   10,  11, 13,
+                                      15, 17, 19, 23,  27,  31,  35,  43,  51, 59,
+                                      67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LEN_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+// Base distances and extra bits of the distance codes 0..29.
+static const uint16_t DIST_BASE[30] = {
+    1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+    33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145,  8193,  12289, 16385, 24577};
+static const uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2,  2,  3,  3,
+                                       4, 4, 5, 5, 6, 6, 7,  7,  8,  8,
+                                       9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static const uint32_t CRC32_NIBBLE[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4,
+    0x4db26158, 0x5005713c, 0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c};
+
+static constexpr uint32_t NO_POS = 0xffffffff;
+static constexpr uint32_t MAX_DIST = 32768;
+static constexpr uint16_t MAX_MATCH = 258;
+static constexpr uint32_t ADLER_MOD = 65521;
+
+uint32_t crc32Update(uint32_t crc, const uint8_t *data, size_t len) {
+  crc = ~crc;
+  for (size_t i = 0; i < len; ++i) {
+    crc = (crc >> 4) ^ CRC32_NIBBLE[(crc ^ data[i]) & 0x0f];
+    crc = (crc >> 4) ^ CRC32_NIBBLE[(crc ^ (data[i] >> 4)) & 0x0f];
+  }
+  return ~crc;
+}
+
+void DeflateWriter::begin(DeflateSink sink, void *ctx, Format format) {
+  sink_ = sink;
+  ctx_ = ctx;
+  format_ = format;
+  bitBuf_ = 0;
+  bitCount_ = 0;
+  outLen_ = 0;
+  crc_ = 0;
+  adlerA_ = 1;
+  adlerB_ = 0;
+  totalIn_ = 0;
+  if (format_ == Format::GZIP) {
+    static const uint8_t GZIP_HEADER[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+    for (uint8_t b : GZIP_HEADER) {
+      putByte(b);
+    }
+  } else if (format_ == Format::ZLIB) {
+    putByte(0x78); // 32 KiB window, deflate
+    putByte(0x01); // fastest compression, check bits
+  }
+  // One final block with the fixed Huffman tables: BFINAL=1, BTYPE=01.
+  putBits(1, 1);
+  putBits(1, 2);
+}
+
+void DeflateWriter::putByte(uint8_t b) {
+  out_[outLen_++] = b;
+  if (outLen_ == OUT_BUF) {
+    flushOut();
+  }
+}
+
+void DeflateWriter::flushOut() {
+  if (outLen_ > 0) {
+    sink_(ctx_, out_, outLen_);
+    outLen_ = 0;
+  }
+}
+
+// Append ``count`` bits, least significant bit first.
+void DeflateWriter::putBits(uint32_t bits, uint8_t count) {
+  bitBuf_ |= bits << bitCount_;
+  bitCount_ += count;
+  while (bitCount_ >= 8) {
+    putByte(static_cast<uint8_t>(bitBuf_));
+    bitBuf_ >>= 8;
+    bitCount_ -= 8;
+  }
+}
+
+// Huffman codes are defined most significant bit first.
+void DeflateWriter::putCode(uint16_t code, uint8_t len) {
+  uint16_t rev = 0;
+  for (uint8_t i = 0; i < len; ++i) {
+    rev = (rev << 1) | ((code >> i) & 1);
+  }
+  putBits(rev, len);
+}
+
+void DeflateWriter::putLiteral(uint8_t lit) {
+  if (lit < 144) {
+    putCode(0x30 + lit, 8);
+  } else {
+    putCode(0x190 + (lit - 144), 9);
+  }
+}
+
+void DeflateWriter::putMatch(uint16_t len, uint16_t dist) {
+  uint8_t li = 28;
+  while (LEN_BASE[li] > len) {
+    --li;
+  }
+  uint16_t sym = 257 + li;
+  if (sym < 280) {
+    putCode(sym - 256, 7);
+  } else {
+    putCode(0xc0 + (sym - 280), 8);
+  }
+  putBits(len - LEN_BASE[li], LEN_EXTRA[li]);
+
+  uint8_t di = 29;
+  while (DIST_BASE[di] > dist) {
+    --di;
+  }
+  putCode(di, 5);
+  putBits(dist - DIST_BASE[di], DIST_EXTRA[di]);
+}
+
+static inline uint32_t hash3(const uint8_t *p, int bits) {
+  uint32_t v = (static_cast<uint32_t>(p[0]) << 16) | (p[1] << 8) | p[2];
+  return (v * 2654435761u) >> (32 - bits);
+}
+
+void DeflateWriter::write(const uint8_t *data, size_t len) {
+  if (format_ == Format::GZIP) {
+    crc_ = crc32Update(crc_, data, len);
+  } else if (format_ == Format::ZLIB) {
+    // Defer the modulo as long as the sums cannot overflow.
+    size_t i = 0;
+    while (i < len) {
+      size_t n = len - i < 5552 ? len - i : 5552;
+      for (size_t k = 0; k < n; ++k) {
+        adlerA_ += data[i + k];
+        adlerB_ += adlerA_;
+      }
+      adlerA_ %= ADLER_MOD;
+      adlerB_ %= ADLER_MOD;
+      i += n;
+    }
+  }
+  totalIn_ += len;
+
+  memset(head_, 0xff, sizeof(head_));
+  size_t i = 0;
+  while (i < len) {
+    if (i + 3 <= len) {
+      uint32_t h = hash3(data + i, HASH_BITS);
+      uint32_t cand = head_[h];
+      head_[h] = i;
+      if (cand != NO_POS && i - cand <= MAX_DIST &&
+          memcmp(data + cand, data + i, 3) == 0) {
+        size_t maxLen = len - i < MAX_MATCH ? len - i : MAX_MATCH;
+        size_t l = 3;
+        while (l < maxLen && data[cand + l] == data[i + l]) {
+          ++l;
+        }
+        putMatch(static_cast<uint16_t>(l), static_cast<uint16_t>(i - cand));
+        // Index the positions inside the match so later repeats find them.
+        for (size_t j = i + 1; j < i + l && j + 3 <= len; ++j) {
+          head_[hash3(data + j, HASH_BITS)] = j;
+        }
+        i += l;
+        continue;
+      }
+    }
+    putLiteral(data[i]);
+    ++i;
+  }
+}
+
+void DeflateWriter::finish() {
+  putCode(0, 7); // end of block
+  if (bitCount_ > 0) {
+    putBits(0, 8 - bitCount_);
+  }
+  if (format_ == Format::GZIP) {
+    for (int s = 0; s < 32; s += 8) {
+      putByte(static_cast<uint8_t>(crc_ >> s));
+    }
+    for (int s = 0; s < 32; s += 8) {
+      putByte(static_cast<uint8_t>(totalIn_ >> s));
+    }
+  } else if (format_ == Format::ZLIB) {
+    uint32_t adler = (adlerB_ << 16) | adlerA_;
+    for (int s = 24; s >= 0; s -= 8) {
+      putByte(static_cast<uint8_t>(adler >> s));
+    }
+  }
+  flushOut();
+}
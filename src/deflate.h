@@ -0,0 +1,71 @@
+/*
+  -----------------------------------------------------------------------------
+  deflate.h — Small streaming DEFLATE / gzip compressor
+
+  A compact RFC 1951 encoder for payloads produced on the device (line
+  protocol batches, screenshots).  It emits a single block with the fixed
+  Huffman tables and finds matches with a one-entry hash table over the
+  buffer passed to each ``write()`` call, so it needs only a few kilobytes
+  of RAM and no dynamic allocation.  The ratio is below zlib's, but
+  repetitive text such as line protocol still shrinks about threefold.
+
+  Compressed bytes are handed to a sink callback in small pieces so the
+  output can be streamed straight into a buffer or a socket.
+
+  The code is plain C++ so it can be checked against zlib on a host.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Receives compressed output.  ``ctx`` is the pointer given to ``begin()``.
+typedef void (*DeflateSink)(void *ctx, const uint8_t *data, size_t len);
+
+class DeflateWriter {
+public:
+  enum class Format : uint8_t { RAW, GZIP, ZLIB };
+
+  // Start a new stream.  GZIP and ZLIB add the respective header and
+  // trailer around the raw DEFLATE data.
+  void begin(DeflateSink sink, void *ctx, Format format = Format::GZIP);
+
+  // Compress ``len`` bytes.  Matches are only searched within this buffer,
+  // so larger calls compress better.
+  void write(const uint8_t *data, size_t len);
+
+  // Terminate the block, flush pending bits and append the trailer.
+  void finish();
+
+  // Uncompressed bytes consumed so far.
+  uint32_t totalIn() const { return totalIn_; }
+
+private:
+  static constexpr int HASH_BITS = 10;
+  static constexpr size_t OUT_BUF = 128;
+
+  void putBits(uint32_t bits, uint8_t count);
+  void putCode(uint16_t code, uint8_t len);
+  void putLiteral(uint8_t lit);
+  void putMatch(uint16_t len, uint16_t dist);
+  void putByte(uint8_t b);
+  void flushOut();
+
+  DeflateSink sink_;
+  void *ctx_;
+  Format format_;
+  uint32_t bitBuf_;
+  uint8_t bitCount_;
+  uint8_t out_[OUT_BUF];
+  size_t outLen_;
+  uint32_t crc_;
+  uint32_t adlerA_;
+  uint32_t adlerB_;
+  uint32_t totalIn_;
+  uint32_t head_[1 << HASH_BITS];
+};
+
+// CRC-32 (IEEE 802.3) as used by gzip and PNG.  Start with 0.
+uint32_t crc32Update(uint32_t crc, const uint8_t *data, size_t len);
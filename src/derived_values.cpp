@@ -0,0 +1,450 @@
+#include "derived_values.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+enum Op : uint8_t {
+  OP_CONST,  // operand: index into the constants
+  OP_INPUT,  // operand: Input
+  OP_CURVE,  // operand: curve; pops the hour, pushes its value
+  OP_ADD,
+  OP_SUB,
+  OP_MUL,
+  OP_DIV,
+  OP_NEG,
+  OP_LT,
+  OP_GT,
+  OP_LE,
+  OP_GE,
+  OP_EQ,
+  OP_NE,
+  OP_MIN,
+  OP_MAX,
+  OP_ABS,
+  OP_IF,
+};
+
+enum Input : uint8_t { IN_BATTERY, IN_GEN, IN_CONS, IN_POWER, IN_HOUR };
+constexpr uint8_t NO_CURVE = 0xFF;
+
+struct NameDesc {
+  const char *name;
+  uint8_t input;
+  uint8_t curve;  // curve read by name[i], NO_CURVE if none
+  uint8_t use;
+};
+
+const NameDesc NAMES[] = {
+    {"battery", IN_BATTERY, NO_CURVE, DERIVED_BATTERY},
+    {"gen", IN_GEN, 0, DERIVED_GEN},
+    {"cons", IN_CONS, 1, DERIVED_CONS},
+    {"power", IN_POWER, NO_CURVE, DERIVED_POWER},
+    {"hour", IN_HOUR, NO_CURVE, DERIVED_HOUR},
+};
+
+struct FunctionDesc {
+  const char *name;
+  uint8_t args;
+  uint8_t op;
+};
+
+const FunctionDesc FUNCTIONS[] = {
+    {"min", 2, OP_MIN}, {"max", 2, OP_MAX}, {"abs", 1, OP_ABS}, {"if", 3, OP_IF}};
+
+const char *skipSpaces(const char *p) {
+  while (*p == ' ' || *p == '\t') {
+    ++p;
+  }
+  return p;
+}
+
+// Recursive descent compiler for one expression.  Precedence from low to
+// high: comparisons, + -, * /, unary minus.
+class Compiler {
+public:
+  enum Error : uint8_t { NONE, SYNTAX, NAME, CODE, CONSTS, STACK };
+
+  Compiler(const char *text, uint8_t *code, size_t codeLen, float *constPool,
+           size_t consts)
+      : p(text), len(codeLen), constCount(consts), code_(code),
+        consts_(constPool) {}
+
+  void expression() {
+    sum();
+    for (;;) {
+      p = skipSpaces(p);
+      uint8_t op;
+      if (p[0] == '<' && p[1] == '=') {
+        op = OP_LE;
+      } else if (p[0] == '>' && p[1] == '=') {
+        op = OP_GE;
+      } else if (p[0] == '=' && p[1] == '=') {
+        op = OP_EQ;
+      } else if (p[0] == '!' && p[1] == '=') {
+        op = OP_NE;
+      } else if (*p == '<' || *p == '>') {
+        op = *p++ == '<' ? OP_LT : OP_GT;
+        sum();
+        emit(op, -1);
+        continue;
+      } else {
+        return;
+      }
+      p += 2;
+      sum();
+      emit(op, -1);
+    }
+  }
+
+  const char *p;
+  Error error = NONE;
+  const char *errorAt = nullptr;
+  size_t errorLen = 0;
+  uint8_t uses = 0;
+  size_t len;
+  size_t constCount;
+
+private:
+  void sum() {
+    term();
+    for (p = skipSpaces(p); *p == '+' || *p == '-'; p = skipSpaces(p)) {
+      uint8_t op = *p++ == '+' ? OP_ADD : OP_SUB;
+      term();
+      emit(op, -1);
+    }
+  }
+
+  void term() {
+    unary();
+    for (p = skipSpaces(p); *p == '*' || *p == '/'; p = skipSpaces(p)) {
+      uint8_t op = *p++ == '*' ? OP_MUL : OP_DIV;
+      unary();
+      emit(op, -1);
+    }
+  }
+
+  void unary() {
+    p = skipSpaces(p);
+    if (*p == '-') {
+      ++p;
+      unary();
+      emit(OP_NEG, 0);
+    } else {
+      primary();
+    }
+  }
+
+  void primary() {
+    if (error) {
+      return;
+    }
+    p = skipSpaces(p);
+    if (isdigit(static_cast<unsigned char>(*p)) || *p == '.') {
+      char *end;
+      float v = strtof(p, &end);
+      if (end == p) {
+        fail(SYNTAX);
+        return;
+      }
+      p = end;
+      constant(v);
+    } else if (*p == '(') {
+      ++p;
+      expression();
+      expect(')');
+    } else if (isalpha(static_cast<unsigned char>(*p))) {
+      const char *name = p;
+      while (isalnum(static_cast<unsigned char>(*p)) || *p == '_') {
+        ++p;
+      }
+      size_t n = p - name;
+      p = skipSpaces(p);
+      if (*p == '(') {
+        call(name, n);
+      } else {
+        variable(name, n);
+      }
+    } else {
+      fail(SYNTAX);
+    }
+  }
+
+  void call(const char *name, size_t n) {
+    for (const FunctionDesc &f : FUNCTIONS) {
+      if (strlen(f.name) == n && strncmp(f.name, name, n) == 0) {
+        ++p;
+        for (uint8_t i = 0; i < f.args; ++i) {
+          if (i) {
+            expect(',');
+          }
+          expression();
+        }
+        expect(')');
+        emit(f.op, 1 - f.args);
+        return;
+      }
+    }
+    p = name;
+    errorLen = n;
+    fail(NAME);
+  }
+
+  void variable(const char *name, size_t n) {
+    for (const NameDesc &d : NAMES) {
+      if (strlen(d.name) != n || strncmp(d.name, name, n) != 0) {
+        continue;
+      }
+      if (*p == '[' && d.curve != NO_CURVE) {
+        ++p;
+        expression();
+        expect(']');
+        emit(OP_CURVE, 0, d.curve);
+        uses |= DERIVED_CURVES;
+      } else {
+        emit(OP_INPUT, 1, d.input);
+        uses |= d.use;
+      }
+      return;
+    }
+    p = name;
+    errorLen = n;
+    fail(NAME);
+  }
+
+  void constant(float v) {
+    size_t i = 0;
+    while (i < constCount && memcmp(&consts_[i], &v, sizeof(v)) != 0) {
+      ++i;
+    }
+    if (i == constCount) {
+      if (constCount == DerivedValues::MAX_CONSTS) {
+        fail(CONSTS);
+        return;
+      }
+      consts_[constCount++] = v;
+    }
+    emit(OP_CONST, 1, static_cast<uint8_t>(i));
+  }
+
+  void expect(char c) {
+    p = skipSpaces(p);
+    if (*p != c) {
+      fail(SYNTAX);
+      return;
+    }
+    ++p;
+  }
+
+  // Append an instruction whose net effect on the stack is ``delta``.
+  void emit(uint8_t op, int delta) {
+    if (error) {
+      return;
+    }
+    if (len == DerivedValues::MAX_CODE) {
+      fail(CODE);
+      return;
+    }
+    code_[len++] = op;
+    depth += delta;
+    if (depth > static_cast<int>(DerivedValues::MAX_STACK)) {
+      fail(STACK);
+    }
+  }
+
+  void emit(uint8_t op, int delta, uint8_t operand) {
+    emit(op, delta);
+    if (error) {
+      return;
+    }
+    if (len == DerivedValues::MAX_CODE) {
+      fail(CODE);
+      return;
+    }
+    code_[len++] = operand;
+  }
+
+  void fail(Error e) {
+    if (!error) {
+      error = e;
+      errorAt = p;
+    }
+  }
+
+  uint8_t *code_;
+  float *consts_;
+  int depth = 0;
+};
+
+// Copy the text between ``from`` and ``to`` without surrounding blanks.
+bool copyTrimmed(const char *from, const char *to, char *out, size_t max) {
+  from = skipSpaces(from);
+  while (to > from && (to[-1] == ' ' || to[-1] == '\t')) {
+    --to;
+  }
+  size_t n = to - from;
+  if (n > max) {
+    return false;
+  }
+  memcpy(out, from, n);
+  out[n] = '\0';
+  return true;
+}
+
+}  // namespace
+
+DerivedValues::DerivedValues() : count_(0), uses_(0) {}
+
+bool DerivedValues::compile(const char *text, char *err, size_t errCap) {
+  Value values[MAX_VALUES];
+  uint8_t code[MAX_CODE];
+  float consts[MAX_CONSTS];
+  size_t n = 0;
+  size_t codeLen = 0;
+  size_t constCount = 0;
+  uint8_t uses = 0;
+  const char *p = skipSpaces(text);
+  while (*p) {
+    if (n == MAX_VALUES) {
+      snprintf(err, errCap, "more than %u values", static_cast<unsigned>(MAX_VALUES));
+      return false;
+    }
+    const char *eq = strchr(p, '=');
+    const char *semi = strchr(p, ';');
+    Value &v = values[n];
+    if (!eq || (semi && semi < eq) || eq == p ||
+        !copyTrimmed(p, eq, v.label, LABEL_MAX)) {
+      snprintf(err, errCap, "expected label= at \"%.16s\"", p);
+      return false;
+    }
+    Compiler c(eq + 1, code, codeLen, consts, constCount);
+    c.expression();
+    const char *end = c.p;
+    if (!c.error) {
+      // Whatever follows the expression up to the next ';' is the unit
+      const char *unitEnd = strchr(end, ';');
+      if (!unitEnd) {
+        unitEnd = end + strlen(end);
+      }
+      const char *unit = skipSpaces(end);
+      if (unit == unitEnd || !strchr("<>=!+-*/(),[]", *unit)) {
+        end = unitEnd;
+        if (!copyTrimmed(unit, unitEnd, v.unit, UNIT_MAX)) {
+          snprintf(err, errCap, "unit longer than %u characters",
+                   static_cast<unsigned>(UNIT_MAX));
+          return false;
+        }
+      } else {
+        c.errorAt = unit;
+        c.error = Compiler::SYNTAX;
+      }
+    }
+    switch (c.error) {
+    case Compiler::NONE:
+      break;
+    case Compiler::NAME:
+      snprintf(err, errCap, "unknown name \"%.*s\"", static_cast<int>(c.errorLen),
+               c.errorAt);
+      return false;
+    case Compiler::CODE:
+    case Compiler::CONSTS:
+      snprintf(err, errCap, "expressions too long");
+      return false;
+    case Compiler::STACK:
+      snprintf(err, errCap, "expression nested too deeply");
+      return false;
+    default:
+      snprintf(err, errCap, "syntax error at \"%.16s\"", c.errorAt);
+      return false;
+    }
+    v.start = static_cast<uint8_t>(codeLen);
+    v.length = static_cast<uint8_t>(c.len - codeLen);
+    codeLen = c.len;
+    constCount = c.constCount;
+    uses |= c.uses;
+    ++n;
+    p = skipSpaces(*end ? end + 1 : end);
+  }
+
+  memcpy(values_, values, n * sizeof(Value));
+  memcpy(code_, code, codeLen);
+  memcpy(consts_, consts, constCount * sizeof(float));
+  count_ = static_cast<uint8_t>(n);
+  uses_ = uses;
+  return true;
+}
+
+float DerivedValues::evaluate(size_t i, const DerivedInputs &in) const {
+  // compile() bounds the depth of every expression by MAX_STACK
+  float stack[MAX_STACK];
+  size_t sp = 0;
+  const uint8_t *pc = code_ + values_[i].start;
+  const uint8_t *end = pc + values_[i].length;
+  while (pc < end) {
+    uint8_t op = *pc++;
+    float b = sp ? stack[sp - 1] : 0.0f;
+    float a = sp > 1 ? stack[sp - 2] : 0.0f;
+    switch (op) {
+    case OP_CONST:
+      stack[sp++] = consts_[*pc++];
+      break;
+    case OP_INPUT: {
+      static_assert(IN_HOUR == 4, "inputs must match DerivedInputs");
+      const float inputs[] = {in.battery, in.gen, in.cons, in.power, in.hour};
+      stack[sp++] = inputs[*pc++];
+      break;
+    }
+    case OP_CURVE: {
+      const float *curve = *pc++ ? in.consCurve : in.genCurve;
+      float v = NAN;
+      if (curve && b >= 0.0f && b < static_cast<float>(in.curveLength)) {
+        v = curve[static_cast<size_t>(b)];
+      }
+      stack[sp - 1] = v;
+      break;
+    }
+    case OP_NEG:
+      stack[sp - 1] = -b;
+      break;
+    case OP_ABS:
+      stack[sp - 1] = fabsf(b);
+      break;
+    case OP_IF: {
+      float cond = sp > 2 ? stack[sp - 3] : 0.0f;
+      sp -= 2;
+      stack[sp - 1] = isnan(cond) ? NAN : cond != 0.0f ? a : b;
+      break;
+    }
+    default: {
+      float r;
+      switch (op) {
+      case OP_ADD: r = a + b; break;
+      case OP_SUB: r = a - b; break;
+      case OP_MUL: r = a * b; break;
+      case OP_DIV: r = b != 0.0f ? a / b : NAN; break;
+      case OP_LT: r = a < b; break;
+      case OP_GT: r = a > b; break;
+      case OP_LE: r = a <= b; break;
+      case OP_GE: r = a >= b; break;
+      case OP_EQ: r = a == b; break;
+      case OP_NE: r = a != b; break;
+      // NaN (a missing input) wins, unlike fminf/fmaxf
+      case OP_MIN: r = isnan(a) || isnan(b) ? NAN : a < b ? a : b; break;
+      case OP_MAX: r = isnan(a) || isnan(b) ? NAN : a > b ? a : b; break;
+      default: return NAN;
+      }
+      // A comparison with a missing input is missing, not false
+      if ((op >= OP_LT && op <= OP_NE) && (isnan(a) || isnan(b))) {
+        r = NAN;
+      }
+      stack[--sp - 1] = r;
+      break;
+    }
+    }
+  }
+  return sp ? stack[sp - 1] : NAN;
+}
@@ -0,0 +1,96 @@
+/*
+  -----------------------------------------------------------------------------
+  derived_values.h — User-defined rows computed from the current values
+
+  Every installation wants a few numbers of its own below the graph.  They
+  are written as a list of ``label=expression [unit]`` entries, e.g.
+
+      Export=max(gen-cons,0) kWh; Self use=min(gen,cons)/cons*100 %
+
+  An expression combines the current values with + - * /, comparisons
+  (< > <= >= == !=, giving 1 or 0), parentheses and the functions min(a,b),
+  max(a,b), abs(a) and if(cond,a,b).  It can read
+
+    battery   battery charge in %
+    gen cons  today's generation and consumption in kWh
+    power     live grid power in W (import > 0), NaN without a live source
+    hour      current hour of day, NaN while the clock is not set
+    gen[i]    generation of hour i of today's curve in W
+    cons[i]   consumption of hour i of today's curve in W
+
+  The list is compiled once, when the configuration is loaded, into a
+  compact bytecode for a small stack machine.  Evaluating a row then walks
+  a few bytes with a fixed stack on the C stack: no parsing and no
+  allocation per sample.  A missing input yields NaN, shown as "--".
+
+  The code is plain C++ without Arduino dependencies so that expressions
+  can be tried on a host.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Inputs of the expressions.  ``genCurve`` and ``consCurve`` may be null.
+struct DerivedInputs {
+  float battery;
+  float gen;
+  float cons;
+  float power;
+  float hour;
+  const float *genCurve;
+  const float *consCurve;
+  size_t curveLength;
+};
+
+// Bits of ``DerivedValues::uses()``.
+enum DerivedInput : uint8_t {
+  DERIVED_BATTERY = 1u << 0,
+  DERIVED_GEN = 1u << 1,
+  DERIVED_CONS = 1u << 2,
+  DERIVED_POWER = 1u << 3,
+  DERIVED_HOUR = 1u << 4,
+  DERIVED_CURVES = 1u << 5,
+};
+
+class DerivedValues {
+public:
+  static constexpr size_t MAX_VALUES = 4;
+  static constexpr size_t MAX_CODE = 160;
+  static constexpr size_t MAX_CONSTS = 16;
+  static constexpr size_t MAX_STACK = 8;
+  static constexpr size_t LABEL_MAX = 12;
+  static constexpr size_t UNIT_MAX = 4;
+
+  DerivedValues();
+
+  // Replace the list.  On an error the previous list is kept and a message
+  // is written to ``err``.
+  bool compile(const char *text, char *err, size_t errCap);
+
+  size_t count() const { return count_; }
+  const char *label(size_t i) const { return values_[i].label; }
+  const char *unit(size_t i) const { return values_[i].unit; }
+
+  // Inputs read by any of the expressions, as DerivedInput bits.
+  uint8_t uses() const { return uses_; }
+
+  // Evaluate expression ``i``.
+  float evaluate(size_t i, const DerivedInputs &in) const;
+
+private:
+  struct Value {
+    uint8_t start;
+    uint8_t length;
+    char label[LABEL_MAX + 1];
+    char unit[UNIT_MAX + 1];
+  };
+
+  Value values_[MAX_VALUES];
+  uint8_t code_[MAX_CODE];
+  float consts_[MAX_CONSTS];
+  uint8_t count_;
+  uint8_t uses_;
+};
@@ -0,0 +1,253 @@
+#include "display_mirror.h"
+
+#include <new>
+
+#include "png_writer.h"
+#include "websocket.h"
+
+constexpr uint32_t MIRROR_INTERVAL_MS = 100;  // live view frame period
+constexpr size_t MIRROR_MAX_RECTS = 8;
+constexpr size_t MIRROR_HTTP_BUFFER = 1024;
+
+// Viewer page.  The first frame is an ordinary screenshot; every WebSocket
+// message afterwards is an 8-byte header (x, y, w, h as little-endian
+// uint16) followed by a PNG of that region.
+static const char MIRROR_PAGE[] PROGMEM = R"HTML(<!DOCTYPE html>
+<html><head><meta charset="utf-8"><title>Display</title>
+<style>body{background:#222;margin:16px}canvas{image-rendering:pixelated;width:640px}</style>
+</head><body><canvas id="c"></canvas><p id="s" style="color:#aaa;font:12px sans-serif"></p>
+<script>
+const c=document.getElementById('c'),g=c.getContext('2d'),s=document.getElementById('s');
+const img=new Image();
+img.onload=()=>{c.width=img.width;c.height=img.height;g.drawImage(img,0,0);live();};
+img.src='/screen.png?'+Date.now();
+function live(){
+  const ws=new WebSocket('ws://'+location.hostname+':%PORT%/');
+  ws.binaryType='arraybuffer';
+  ws.onopen=()=>{s.textContent='live';};
+  ws.onclose=()=>{s.textContent='disconnected, retrying';setTimeout(live,2000);};
+  ws.onmessage=async(e)=>{
+    const h=new DataView(e.data,0,8);
+    const b=await createImageBitmap(new Blob([e.data.slice(8)],{type:'image/png'}));
+    g.drawImage(b,h.getUint16(0,true),h.getUint16(2,true));
+  };
+}
+</script></body></html>)HTML";
+
+struct DirtyRect {
+  int16_t x0;
+  int16_t y0;
+  int16_t x1;  // exclusive
+  int16_t y1;  // exclusive
+};
+
+static TFT_eSPI *display = nullptr;
+static SemaphoreHandle_t displayMutex = nullptr;
+static SemaphoreHandle_t captureMutex = nullptr;
+static WebSocketServer wsServer(MIRROR_WS_PORT);
+static TaskHandle_t mirrorTaskHandle = nullptr;
+
+static portMUX_TYPE dirtyMux = portMUX_INITIALIZER_UNLOCKED;
+static DirtyRect dirty[MIRROR_MAX_RECTS];
+static size_t dirtyCount = 0;
+static volatile bool viewerConnected = false;
+
+void lockDisplay() {
+  if (displayMutex) {
+    xSemaphoreTake(displayMutex, portMAX_DELAY);
+  }
+}
+
+void unlockDisplay() {
+  if (displayMutex) {
+    xSemaphoreGive(displayMutex);
+  }
+}
+
+static int32_t area(const DirtyRect &r) {
+  return static_cast<int32_t>(r.x1 - r.x0) * (r.y1 - r.y0);
+}
+
+static DirtyRect unite(const DirtyRect &a, const DirtyRect &b) {
+  return {std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1),
+          std::max(a.y1, b.y1)};
+}
+
+void markDisplayDirty(int32_t x, int32_t y, int32_t w, int32_t h) {
+  if (!viewerConnected || !display) {
+    return;
+  }
+  int32_t x1 = std::min<int32_t>(x + w, display->width());
+  int32_t y1 = std::min<int32_t>(y + h, display->height());
+  x = std::max<int32_t>(x, 0);
+  y = std::max<int32_t>(y, 0);
+  if (x1 <= x || y1 <= y) {
+    return;
+  }
+  DirtyRect r = {static_cast<int16_t>(x), static_cast<int16_t>(y),
+                 static_cast<int16_t>(x1), static_cast<int16_t>(y1)};
+  portENTER_CRITICAL(&dirtyMux);
+  // Join a rectangle it touches; when the list is full, grow the one whose
+  // area increases least.
+  size_t best = dirtyCount;
+  int32_t bestGrowth = INT32_MAX;
+  for (size_t i = 0; i < dirtyCount; ++i) {
+    const DirtyRect &d = dirty[i];
+    if (r.x0 <= d.x1 && d.x0 <= r.x1 && r.y0 <= d.y1 && d.y0 <= r.y1) {
+      best = i;
+      break;
+    }
+    int32_t growth = area(unite(d, r)) - area(d);
+    if (dirtyCount == MIRROR_MAX_RECTS && growth < bestGrowth) {
+      best = i;
+      bestGrowth = growth;
+    }
+  }
+  if (best < dirtyCount) {
+    dirty[best] = unite(dirty[best], r);
+  } else {
+    dirty[dirtyCount++] = r;
+  }
+  portEXIT_CRITICAL(&dirtyMux);
+}
+
+/*
+ * Read a rectangle back from the panel and encode it as PNG into ``sink``.
+ * Only one capture runs at a time; it holds the encoder (about 12.5 KB) and
+ * one band of pixels, both freed again afterwards.  The display lock is
+ * taken per band, so loop() is never blocked for a whole frame.
+ */
+static bool capture(int32_t x, int32_t y, int32_t w, int32_t h,
+                    DeflateSink sink, void *ctx) {
+  xSemaphoreTake(captureMutex, portMAX_DELAY);
+  PngWriter *png = new (std::nothrow) PngWriter;
+  uint16_t *band = static_cast<uint16_t *>(
+      malloc(static_cast<size_t>(w) * PngWriter::MAX_BAND_ROWS * sizeof(uint16_t)));
+  bool ok = png && band && png->begin(w, h, sink, ctx);
+  if (ok) {
+    for (int32_t row = 0; row < h; row += PngWriter::MAX_BAND_ROWS) {
+      int32_t rows = std::min<int32_t>(PngWriter::MAX_BAND_ROWS, h - row);
+      lockDisplay();
+      display->readRect(x, y + row, w, rows, band);
+      unlockDisplay();
+      // readRect() returns the bytes swapped for pushImage()
+      for (int32_t i = 0; i < w * rows; ++i) {
+        band[i] = (band[i] >> 8) | (band[i] << 8);
+      }
+      png->writeRows(band, rows);
+    }
+    png->finish();
+  } else {
+    Serial.println("Not enough memory for screenshot");
+  }
+  free(band);
+  delete png;
+  xSemaphoreGive(captureMutex);
+  return ok;
+}
+
+// Collects the PNG into chunks of a useful size for the HTTP response.
+struct HttpOutput {
+  WebServer *server;
+  size_t len;
+  char buf[MIRROR_HTTP_BUFFER];
+};
+
+static void httpSink(void *ctx, const uint8_t *data, size_t len) {
+  HttpOutput *out = static_cast<HttpOutput *>(ctx);
+  while (len > 0) {
+    size_t n = std::min(len, sizeof(out->buf) - out->len);
+    memcpy(out->buf + out->len, data, n);
+    out->len += n;
+    data += n;
+    len -= n;
+    if (out->len == sizeof(out->buf)) {
+      out->server->sendContent(out->buf, out->len);
+      out->len = 0;
+    }
+  }
+}
+
+static void socketSink(void *, const uint8_t *data, size_t len) {
+  wsServer.write(data, len);
+}
+
+static bool sendRegion(const DirtyRect &r) {
+  const uint16_t values[4] = {static_cast<uint16_t>(r.x0), static_cast<uint16_t>(r.y0),
+                              static_cast<uint16_t>(r.x1 - r.x0),
+                              static_cast<uint16_t>(r.y1 - r.y0)};
+  uint8_t head[8];
+  for (int i = 0; i < 4; ++i) {
+    head[2 * i] = values[i] & 0xff;
+    head[2 * i + 1] = values[i] >> 8;
+  }
+  wsServer.beginMessage();
+  wsServer.write(head, sizeof(head));
+  capture(r.x0, r.y0, r.x1 - r.x0, r.y1 - r.y0, socketSink, nullptr);
+  return wsServer.endMessage();
+}
+
+static void mirrorTask(void *) {
+  wsServer.begin();
+  for (;;) {
+    if (wsServer.poll()) {
+      // Anything drawn since the viewer's screenshot was taken is unknown,
+      // so a new connection starts with the whole screen.
+      viewerConnected = true;
+      markDisplayDirty(0, 0, display->width(), display->height());
+    }
+    viewerConnected = wsServer.connected();
+    DirtyRect pending[MIRROR_MAX_RECTS];
+    portENTER_CRITICAL(&dirtyMux);
+    size_t count = dirtyCount;
+    memcpy(pending, dirty, count * sizeof(DirtyRect));
+    dirtyCount = 0;
+    portEXIT_CRITICAL(&dirtyMux);
+    for (size_t i = 0; i < count && viewerConnected; ++i) {
+      viewerConnected = sendRegion(pending[i]);
+    }
+    vTaskDelay(pdMS_TO_TICKS(MIRROR_INTERVAL_MS));
+  }
+}
+
+void beginDisplayMirror(TFT_eSPI &tft, WebServer &server) {
+  if (display) {
+    return;
+  }
+  display = &tft;
+  displayMutex = xSemaphoreCreateMutex();
+  captureMutex = xSemaphoreCreateMutex();
+  WebServer *srv = &server;
+
+  srv->on("/screen.png", HTTP_GET, [srv]() {
+    HttpOutput *out = new (std::nothrow) HttpOutput;
+    if (!out) {
+      srv->send(503, "text/plain", "Out of memory\n");
+      return;
+    }
+    out->server = srv;
+    out->len = 0;
+    srv->sendHeader("Cache-Control", "no-store");
+    srv->setContentLength(CONTENT_LENGTH_UNKNOWN);
+    srv->send(200, "image/png", "");
+    capture(0, 0, display->width(), display->height(), httpSink, out);
+    if (out->len > 0) {
+      srv->sendContent(out->buf, out->len);
+    }
+    srv->sendContent("");
+    delete out;
+  });
+
+  srv->on("/screen", HTTP_GET, [srv]() {
+    String page = MIRROR_PAGE;
+    page.replace("%PORT%", String(MIRROR_WS_PORT));
+    srv->send(200, "text/html", page);
+  });
+
+  if (xTaskCreatePinnedToCore(mirrorTask, "mirror", 4096, nullptr,
+                              tskIDLE_PRIORITY + 1, &mirrorTaskHandle,
+                              0) != pdPASS) {
+    mirrorTaskHandle = nullptr;
+    Serial.println("Failed to start display mirror task");
+  }
+}
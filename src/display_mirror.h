@@ -0,0 +1,43 @@
+/*
+  -----------------------------------------------------------------------------
+  display_mirror.h — Screenshots and a live remote view of the TFT
+
+  The panel contents are read back from the display controller in bands of
+  a few rows and encoded as PNG on the fly, so no copy of the framebuffer is
+  ever held in RAM:
+
+    • GET /screen.png   returns a screenshot of the whole display;
+    • GET /screen       is a small page that shows the display live.  It
+                        loads one screenshot and then receives only the
+                        regions that were redrawn over a WebSocket on port
+                        ``MIRROR_WS_PORT``.
+
+  Drawing code reports what it changed with ``markDisplayDirty()``.  Since
+  the readback shares the SPI bus with drawing, loop() takes the display
+  lock around each block of drawing, but never while it waits for the
+  network (see ``lockDisplay()``).
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <TFT_eSPI.h>
+#include <WebServer.h>
+
+#ifndef MIRROR_WS_PORT
+#define MIRROR_WS_PORT 81
+#endif
+
+// Register the HTTP routes and start the live view task.  Call before
+// ``beginWebServer()``.
+void beginDisplayMirror(TFT_eSPI &tft, WebServer &server);
+
+// Exclusive access to the display.  Taken by loop() around each block of
+// drawing and by the mirror for each band it reads back.  Not recursive.
+void lockDisplay();
+void unlockDisplay();
+
+// Record that a rectangle of the screen has been redrawn.  Cheap enough to
+// call for every drawing operation; does nothing while no viewer is
+// connected.
+void markDisplayDirty(int32_t x, int32_t y, int32_t w, int32_t h);
@@ -0,0 +1,457 @@
+#include "endpoint_probe.h"
+
+#include <ArduinoJson.h>
+#include <WebServer.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <atomic>
+
+#include "config_store.h"
+#include "console.h"
+
+#ifndef ENDPOINT_PROBE_INTERVAL_MS
+#define ENDPOINT_PROBE_INTERVAL_MS (10UL * 60UL * 1000UL)
+#endif
+
+constexpr size_t ENDPOINT_MAX = 4;
+constexpr size_t ENDPOINT_HOST_MAX = 64;
+constexpr uint32_t ENDPOINT_TIMEOUT_MS = 3000;
+// Weight of a new probe in the smoothed score.
+constexpr float ENDPOINT_SMOOTHING = 0.3f;
+// A faster host takes over only below this share of the current score.
+constexpr float ENDPOINT_SWITCH_RATIO = 0.8f;
+
+struct Endpoint {
+  char host[ENDPOINT_HOST_MAX]; // as written in the URL, with ":port"
+  uint16_t port;
+  bool healthy;
+  uint32_t dnsMs;
+  uint32_t connectMs;
+  uint32_t tlsMs;
+  uint32_t responseMs;
+  float scoreMs;     // smoothed total, NaN until a probe succeeded
+  uint32_t probes;
+  uint32_t failures; // failed probes and requests
+  uint32_t probedAt; // millis() of the last probe, 0 if never probed
+};
+
+// Requests from other tasks, handled by the probe task between rounds.
+// The task turns a stop into EP_EXIT when it acts on it; from then on it
+// can no longer be cancelled.
+enum EndpointRequest : uint8_t { EP_RUN, EP_RELOAD, EP_STOP, EP_EXIT };
+
+// Written by the probe task and by failure reports, read by the fetchers
+// and the metrics; all under ``endpointMux``.
+static Endpoint endpoints[ENDPOINT_MAX];
+static size_t endpointCount = 0;
+static size_t selected = 0;
+static portMUX_TYPE endpointMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Probe settings, only used by the probe task.
+static bool probeTls = false;
+static char probePath[CONFIG_STR_MAX];
+static std::atomic<uint8_t> probeRequest(EP_RUN);
+static std::atomic<TaskHandle_t> probeTaskHandle(nullptr);
+
+// Locate the host part of ``url``.  ``rest`` points behind it.
+static bool splitUrl(const char *url, bool &tls, const char *&host,
+                     size_t &hostLen, const char *&rest) {
+  const char *sep = strstr(url, "://");
+  if (!sep) {
+    return false;
+  }
+  tls = strncmp(url, "https", 5) == 0;
+  host = sep + 3;
+  hostLen = strcspn(host, "/?#");
+  rest = host + hostLen;
+  return hostLen > 0;
+}
+
+static void addEndpoint(Endpoint *list, size_t &n, const char *host,
+                        size_t len, bool tls) {
+  if (n == ENDPOINT_MAX || len == 0 || len >= ENDPOINT_HOST_MAX) {
+    return;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    if (strlen(list[i].host) == len && strncmp(list[i].host, host, len) == 0) {
+      return;
+    }
+  }
+  Endpoint &e = list[n++];
+  memset(&e, 0, sizeof(e));
+  memcpy(e.host, host, len);
+  e.host[len] = '\0';
+  const char *colon = strchr(e.host, ':');
+  e.port = colon ? static_cast<uint16_t>(atoi(colon + 1)) : (tls ? 443 : 80);
+  e.healthy = true;
+  e.scoreMs = NAN;
+}
+
+// Build the host list from the host of the auth URL and ``anker_hosts``.
+static void loadEndpoints() {
+  char url[CONFIG_STR_MAX];
+  char hosts[CONFIG_STR_MAX];
+  configString(ConfigKey::AnkerAuthUrl, url, sizeof(url));
+  configString(ConfigKey::AnkerHosts, hosts, sizeof(hosts));
+  Endpoint list[ENDPOINT_MAX];
+  size_t n = 0;
+  const char *host;
+  size_t hostLen;
+  const char *rest;
+  if (splitUrl(url, probeTls, host, hostLen, rest)) {
+    addEndpoint(list, n, host, hostLen, probeTls);
+    strlcpy(probePath, *rest ? rest : "/", sizeof(probePath));
+    for (const char *p = hosts; *p;) {
+      p += strspn(p, ", ");
+      size_t len = strcspn(p, ", ");
+      addEndpoint(list, n, p, len, probeTls);
+      p += len;
+    }
+  }
+  portENTER_CRITICAL(&endpointMux);
+  memcpy(endpoints, list, n * sizeof(Endpoint));
+  endpointCount = n;
+  selected = 0;
+  portEXIT_CRITICAL(&endpointMux);
+  Serial.printf("Probing %u cloud endpoints\n", static_cast<unsigned>(n));
+}
+
+/*
+ * Wait for the status line of a HEAD request on ``client``.  Any answer
+ * other than a server error counts as healthy: the probe only asks for
+ * the auth path and carries no credentials.
+ */
+static bool measureResponse(WiFiClient &client, const char *host, Endpoint &r) {
+  uint32_t start = millis();
+  client.printf("HEAD %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n",
+                probePath, host);
+  while (!client.available()) {
+    if (!client.connected() || millis() - start >= ENDPOINT_TIMEOUT_MS) {
+      return false;
+    }
+    vTaskDelay(1);
+  }
+  r.responseMs = millis() - start;
+  char status[13];
+  size_t n = 0;
+  while (n < sizeof(status) - 1 && millis() - start < ENDPOINT_TIMEOUT_MS) {
+    int c = client.read();
+    if (c < 0) {
+      vTaskDelay(1);
+      continue;
+    }
+    status[n++] = static_cast<char>(c);
+  }
+  status[n] = '\0';
+  return strncmp(status, "HTTP/1.", 7) == 0 && atoi(status + 9) < 500;
+}
+
+// Measure one endpoint.  Returns false if any step fails or times out.
+static bool probeEndpoint(const char *host, uint16_t port, Endpoint &r) {
+  char name[ENDPOINT_HOST_MAX];
+  strlcpy(name, host, sizeof(name));
+  char *colon = strchr(name, ':');
+  if (colon) {
+    *colon = '\0';
+  }
+  uint32_t t0 = millis();
+  IPAddress ip;
+  if (!WiFi.hostByName(name, ip)) {
+    return false;
+  }
+  uint32_t t1 = millis();
+  r.dnsMs = t1 - t0;
+  WiFiClient tcp;
+  if (!tcp.connect(ip, port, ENDPOINT_TIMEOUT_MS)) {
+    return false;
+  }
+  r.connectMs = millis() - t1;
+  r.tlsMs = 0;
+  if (!probeTls) {
+    bool ok = measureResponse(tcp, host, r);
+    tcp.stop();
+    return ok;
+  }
+  tcp.stop();
+  // The handshake needs its own connection; its TCP part is taken to cost
+  // what the plain connect just did.  Certificates are not checked because
+  // nothing but the HEAD request is sent.
+  WiFiClientSecure tls;
+  tls.setInsecure();
+  tls.setHandshakeTimeout(ENDPOINT_TIMEOUT_MS / 1000);
+  uint32_t t2 = millis();
+  if (!tls.connect(name, port)) {
+    return false;
+  }
+  uint32_t total = millis() - t2;
+  r.tlsMs = total > r.connectMs ? total - r.connectMs : 0;
+  bool ok = measureResponse(tls, host, r);
+  tls.stop();
+  return ok;
+}
+
+// Pick the endpoint for the next requests.  Call with ``endpointMux`` held.
+static size_t chooseEndpoint() {
+  size_t best = ENDPOINT_MAX;
+  for (size_t i = 0; i < endpointCount; ++i) {
+    const Endpoint &e = endpoints[i];
+    if (e.healthy && !isnan(e.scoreMs) &&
+        (best == ENDPOINT_MAX || e.scoreMs < endpoints[best].scoreMs)) {
+      best = i;
+    }
+  }
+  const Endpoint &current = endpoints[selected];
+  if (best == ENDPOINT_MAX) {
+    // Nothing measured yet: stay, or take any host not known to be down
+    for (size_t k = 0; k < endpointCount && !endpoints[selected].healthy; ++k) {
+      size_t i = (selected + k) % endpointCount;
+      if (endpoints[i].healthy) {
+        return i;
+      }
+    }
+    return selected;
+  }
+  if (current.healthy && !isnan(current.scoreMs) &&
+      endpoints[best].scoreMs > current.scoreMs * ENDPOINT_SWITCH_RATIO) {
+    return selected;
+  }
+  return best;
+}
+
+static void probeRound() {
+  for (size_t i = 0;; ++i) {
+    portENTER_CRITICAL(&endpointMux);
+    bool more = i < endpointCount;
+    Endpoint r;
+    if (more) {
+      r = endpoints[i];
+    }
+    portEXIT_CRITICAL(&endpointMux);
+    if (!more) {
+      break;
+    }
+    bool ok = probeEndpoint(r.host, r.port, r);
+    uint32_t total = r.dnsMs + r.connectMs + r.tlsMs + r.responseMs;
+    portENTER_CRITICAL(&endpointMux);
+    Endpoint &e = endpoints[i];
+    e.dnsMs = r.dnsMs;
+    e.connectMs = r.connectMs;
+    e.tlsMs = r.tlsMs;
+    e.responseMs = r.responseMs;
+    e.healthy = ok;
+    ++e.probes;
+    e.probedAt = millis();
+    if (!ok) {
+      ++e.failures;
+    } else if (isnan(e.scoreMs)) {
+      e.scoreMs = total;
+    } else {
+      e.scoreMs += ENDPOINT_SMOOTHING * (total - e.scoreMs);
+    }
+    portEXIT_CRITICAL(&endpointMux);
+  }
+  char host[ENDPOINT_HOST_MAX];
+  portENTER_CRITICAL(&endpointMux);
+  size_t previous = selected;
+  selected = chooseEndpoint();
+  strlcpy(host, endpoints[selected].host, sizeof(host));
+  portEXIT_CRITICAL(&endpointMux);
+  if (selected != previous) {
+    Serial.printf("Switching cloud endpoint to %s\n", host);
+  }
+}
+
+static void probeTask(void *) {
+  loadEndpoints();
+  for (;;) {
+    // Take the pending request; a stop becomes EP_EXIT in the same step,
+    // so beginEndpointProbe() either cancels it or knows the task is ending
+    uint8_t request = probeRequest.load();
+    while (request != EP_RUN &&
+           !probeRequest.compare_exchange_weak(
+               request, request == EP_STOP ? EP_EXIT : EP_RUN)) {
+    }
+    if (request == EP_STOP) {
+      break;
+    }
+    if (request == EP_RELOAD) {
+      loadEndpoints();
+    }
+    if (WiFi.status() == WL_CONNECTED) {
+      probeRound();
+    }
+    // Woken early by reloads, stops and failed requests
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ENDPOINT_PROBE_INTERVAL_MS));
+  }
+  portENTER_CRITICAL(&endpointMux);
+  endpointCount = 0;
+  selected = 0;
+  portEXIT_CRITICAL(&endpointMux);
+  probeTaskHandle.store(nullptr);
+  vTaskDelete(nullptr);
+}
+
+// Pass ``request`` to the task and wake it.  Returns false if there is no
+// task or it is already ending.
+static bool wakeProbeTask(uint8_t request) {
+  TaskHandle_t task = probeTaskHandle.load();
+  if (!task) {
+    return false;
+  }
+  uint8_t current = probeRequest.load();
+  do {
+    if (current == EP_EXIT) {
+      return false;
+    }
+  } while (request != EP_RUN &&
+           !probeRequest.compare_exchange_weak(current, request));
+  xTaskNotifyGive(task);
+  return true;
+}
+
+bool beginEndpointProbe() {
+  // Cancels a stop that the task has not acted on yet
+  if (wakeProbeTask(EP_RELOAD)) {
+    return true;
+  }
+  // A task that is ending only has its last steps left
+  while (probeTaskHandle.load()) {
+    vTaskDelay(1);
+  }
+  if (configString(ConfigKey::AnkerHosts).length() == 0) {
+    return false;
+  }
+  probeRequest.store(EP_RUN);
+  // TLS handshakes need a large stack
+  TaskHandle_t task = nullptr;
+  if (xTaskCreatePinnedToCore(probeTask, "probe", 8192, nullptr,
+                              tskIDLE_PRIORITY + 1, &task, 0) != pdPASS) {
+    Serial.println("Failed to start endpoint probe task");
+    return false;
+  }
+  probeTaskHandle.store(task);
+  return true;
+}
+
+void restartEndpointProbe() {
+  beginEndpointProbe();
+}
+
+void stopEndpointProbe() {
+  wakeProbeTask(EP_STOP);
+}
+
+String endpointUrl(const String &url) {
+  bool tls;
+  const char *host;
+  size_t hostLen;
+  const char *rest;
+  if (!splitUrl(url.c_str(), tls, host, hostLen, rest)) {
+    return url;
+  }
+  // Only URLs on the configured host are routed
+  char chosen[ENDPOINT_HOST_MAX];
+  portENTER_CRITICAL(&endpointMux);
+  bool route = endpointCount > 1 && selected != 0 &&
+               strlen(endpoints[0].host) == hostLen &&
+               strncmp(endpoints[0].host, host, hostLen) == 0;
+  if (route) {
+    strlcpy(chosen, endpoints[selected].host, sizeof(chosen));
+  }
+  portEXIT_CRITICAL(&endpointMux);
+  if (!route) {
+    return url;
+  }
+  String out = url.substring(0, host - url.c_str());
+  out += chosen;
+  out += rest;
+  return out;
+}
+
+void reportEndpointFailure() {
+  char failed[ENDPOINT_HOST_MAX];
+  char next[ENDPOINT_HOST_MAX];
+  portENTER_CRITICAL(&endpointMux);
+  bool failover = endpointCount > 1;
+  if (failover) {
+    Endpoint &e = endpoints[selected];
+    e.healthy = false;
+    ++e.failures;
+    strlcpy(failed, e.host, sizeof(failed));
+    selected = chooseEndpoint();
+    strlcpy(next, endpoints[selected].host, sizeof(next));
+  }
+  portEXIT_CRITICAL(&endpointMux);
+  if (failover) {
+    Serial.printf("Cloud endpoint %s failed, using %s\n", failed, next);
+    wakeProbeTask(EP_RUN);
+  }
+}
+
+// Copy the table for reporting.
+static size_t snapshotEndpoints(Endpoint *out, size_t &current) {
+  portENTER_CRITICAL(&endpointMux);
+  size_t n = endpointCount;
+  memcpy(out, endpoints, n * sizeof(Endpoint));
+  current = selected;
+  portEXIT_CRITICAL(&endpointMux);
+  return n;
+}
+
+// ``endpoints`` lists the last probe of every host.
+static void endpointsCommand(char *) {
+  Endpoint list[ENDPOINT_MAX];
+  size_t current;
+  size_t n = snapshotEndpoints(list, current);
+  if (n == 0) {
+    Serial.println("No alternative cloud endpoints configured");
+    return;
+  }
+  Serial.println("  host                             dns  conn   tls  resp  score  fail");
+  for (size_t i = 0; i < n; ++i) {
+    const Endpoint &e = list[i];
+    Serial.printf("%c %-30s %5u %5u %5u %5u %6.0f %5u%s\n", i == current ? '*' : ' ',
+                  e.host, static_cast<unsigned>(e.dnsMs),
+                  static_cast<unsigned>(e.connectMs), static_cast<unsigned>(e.tlsMs),
+                  static_cast<unsigned>(e.responseMs), e.scoreMs,
+                  static_cast<unsigned>(e.failures), e.healthy ? "" : "  DOWN");
+  }
+}
+
+void registerEndpointRoutes(WebServer &server) {
+  registerConsoleCommand("endpoints", "show cloud endpoint latencies",
+                         endpointsCommand);
+  WebServer *srv = &server;
+  server.on("/api/endpoints", HTTP_GET, [srv]() {
+    Endpoint list[ENDPOINT_MAX];
+    size_t current;
+    size_t n = snapshotEndpoints(list, current);
+    uint32_t now = millis();
+    JsonDocument doc;
+    JsonArray arr = doc["endpoints"].to<JsonArray>();
+    for (size_t i = 0; i < n; ++i) {
+      const Endpoint &e = list[i];
+      JsonObject o = arr.add<JsonObject>();
+      o["host"] = e.host;
+      o["selected"] = i == current;
+      o["healthy"] = e.healthy;
+      o["dns_ms"] = e.dnsMs;
+      o["connect_ms"] = e.connectMs;
+      o["tls_ms"] = e.tlsMs;
+      o["response_ms"] = e.responseMs;
+      if (isnan(e.scoreMs)) {
+        o["score_ms"] = nullptr;
+      } else {
+        o["score_ms"] = e.scoreMs;
+      }
+      o["probes"] = e.probes;
+      o["failures"] = e.failures;
+      if (e.probedAt) {
+        o["age_s"] = (now - e.probedAt) / 1000;
+      }
+    }
+    String body;
+    serializeJson(doc, body);
+    srv->send(200, "application/json", body);
+  });
+}
@@ -0,0 +1,51 @@
+/*
+  -----------------------------------------------------------------------------
+  endpoint_probe.h — Latency probing and failover between cloud endpoints
+
+  The Anker cloud is served from several regional hosts, and a unit that
+  ends up on a distant or overloaded one pays for it on every fetch.  When
+  ``anker_hosts`` lists alternatives (``host[:port]``, comma separated;
+  default ``ANKER_HOSTS``), a background task probes the host of the
+  configured URLs and every alternative each ``ENDPOINT_PROBE_INTERVAL_MS``:
+
+    dns       – name resolution
+    connect   – TCP handshake
+    tls       – TLS handshake (https URLs only)
+    response  – first byte of the answer to a HEAD request
+
+  The sum is smoothed per host, and requests are routed to the healthy host
+  with the lowest score.  Another host only takes over when it is clearly
+  faster, so two similar hosts do not alternate.  A failed request marks
+  its host unhealthy and switches to the next best one at once; a new
+  probe round brings it back when it answers again.
+
+  The results are listed by ``endpoints`` on the console and as JSON by
+  ``GET /api/endpoints``.  ``tools/endpoint_standin.py`` runs local
+  stand-ins with configurable delays and failure rates to try it out.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+class WebServer;
+
+// Start the probe task if alternative hosts are configured.
+bool beginEndpointProbe();
+
+// Re-read the hosts and probe them again, e.g. after ``anker_hosts`` or
+// the cloud URLs changed.
+void restartEndpointProbe();
+
+// End the probe task; requests then go to the configured URLs again.
+void stopEndpointProbe();
+
+// ``url`` with its host replaced by the selected endpoint.
+String endpointUrl(const String &url);
+
+// Report that a request to the selected endpoint failed.
+void reportEndpointFailure();
+
+// Register ``GET /api/endpoints``.
+void registerEndpointRoutes(WebServer &server);
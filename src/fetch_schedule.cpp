@@ -0,0 +1,32 @@
+#include "fetch_schedule.h"
+
+void FetchSchedule::configure(uint32_t refreshMs, uint32_t retryMs) {
+  refresh_ = refreshMs;
+  retry_ = retryMs;
+  interval_ = retrying_ ? retry_ : refresh_;
+}
+
+bool FetchSchedule::prewarmDue(uint32_t now) {
+  if (!started_ || prewarmed_ || interval_ <= PREWARM_LEAD_MS ||
+      now - last_ < interval_ - PREWARM_LEAD_MS) {
+    return false;
+  }
+  prewarmed_ = true;
+  return true;
+}
+
+void FetchSchedule::begin(uint32_t now) {
+  last_ = now;
+  started_ = true;
+  prewarmed_ = false;
+}
+
+void FetchSchedule::succeeded() {
+  retrying_ = false;
+  interval_ = refresh_;
+}
+
+void FetchSchedule::failed() {
+  retrying_ = true;
+  interval_ = retry_;
+}
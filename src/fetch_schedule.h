@@ -0,0 +1,58 @@
+/*
+  -----------------------------------------------------------------------------
+  fetch_schedule.h — When the next poll of the data source is due
+
+  After a successful fetch the next one follows ``refresh`` milliseconds
+  later, after a failure ``retry`` milliseconds later; the first fetch and
+  a forced one happen at once.  ``PREWARM_LEAD_MS`` before a scheduled
+  fetch the connection to the source is opened ahead of time.
+
+  Times are ``millis()`` values and all arithmetic wraps like them.  The
+  code is plain C++ so that ``tools/fleet_sim`` runs exactly this schedule
+  for its virtual devices.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+constexpr uint32_t PREWARM_LEAD_MS = 3000;  // connect this long before a scheduled fetch
+
+class FetchSchedule {
+public:
+  // Set the intervals.  A pending retry keeps its start but moves to the
+  // new retry interval.
+  void configure(uint32_t refreshMs, uint32_t retryMs);
+
+  // Whether a fetch is due at ``now``.
+  bool due(uint32_t now) const {
+    return !started_ || now - last_ >= interval_;
+  }
+
+  // Whether the connection of the next fetch should be opened now; true
+  // at most once per interval.
+  bool prewarmDue(uint32_t now);
+
+  // Record that a fetch starts at ``now`` and its outcome.
+  void begin(uint32_t now);
+  void succeeded();
+  void failed();
+
+  // Fetch again at once, e.g. after the source settings changed.
+  void reset() { started_ = false; }
+
+  // Time of the next retry after a failure, 0 if the last fetch succeeded.
+  uint32_t retryAt() const { return retrying_ ? last_ + interval_ : 0; }
+
+  uint32_t interval() const { return interval_; }
+
+private:
+  uint32_t refresh_ = 5UL * 60UL * 1000UL;
+  uint32_t retry_ = 3UL * 60UL * 1000UL;
+  uint32_t interval_ = refresh_;
+  uint32_t last_ = 0;
+  bool started_ = false;
+  bool retrying_ = false;
+  bool prewarmed_ = false;
+};
@@ -0,0 +1,241 @@
+/* --- glyph_cache.cpp — Anti-aliased (VLW) fonts drawn from a RAM glyph cache --- */
+
+#include "glyph_cache.h"
+
+#include <TFT_eSPI.h>
+#include <algorithm>
+
+namespace {
+
+constexpr size_t VLW_HEADER_BYTES = 24;
+constexpr size_t VLW_METRICS_BYTES = 28;
+constexpr uint16_t VLW_MAX_GLYPH = 255;
+
+int32_t readBigEndian(const uint8_t *p) {
+  return static_cast<int32_t>(static_cast<uint32_t>(p[0]) << 24 |
+                              static_cast<uint32_t>(p[1]) << 16 |
+                              static_cast<uint32_t>(p[2]) << 8 | p[3]);
+}
+
+// Decode the next UTF-8 sequence; malformed bytes are taken as Latin-1.
+uint32_t nextCodepoint(const char *&s) {
+  uint8_t c = static_cast<uint8_t>(*s++);
+  int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+  uint32_t code = extra ? c & (0x3F >> extra) : c;
+  for (int i = 0; i < extra; ++i) {
+    if ((static_cast<uint8_t>(s[i]) & 0xC0) != 0x80) {
+      return c;
+    }
+  }
+  for (int i = 0; i < extra; ++i) {
+    code = code << 6 | (static_cast<uint8_t>(*s++) & 0x3F);
+  }
+  return code;
+}
+
+// Blend two RGB565 colours; ``alpha`` 255 gives ``fg``.
+uint16_t blend(uint8_t alpha, uint16_t fg, uint16_t bg) {
+  uint32_t a = alpha, b = 255 - alpha;
+  uint32_t r = (((fg >> 11) & 0x1F) * a + ((bg >> 11) & 0x1F) * b + 127) / 255;
+  uint32_t g = (((fg >> 5) & 0x3F) * a + ((bg >> 5) & 0x3F) * b + 127) / 255;
+  uint32_t bl = ((fg & 0x1F) * a + (bg & 0x1F) * b + 127) / 255;
+  return static_cast<uint16_t>(r << 11 | g << 5 | bl);
+}
+
+// The display takes pixels high byte first.
+uint16_t displayOrder(uint16_t c) { return static_cast<uint16_t>(c << 8 | c >> 8); }
+
+}  // namespace
+
+bool CachedFont::load(fs::FS &fs, const char *path) {
+  unload();
+  file_ = fs.open(path, FILE_READ);
+  if (!file_) {
+    Serial.printf("Font %s not found\n", path);
+    return false;
+  }
+  uint8_t header[VLW_HEADER_BYTES];
+  bool ok = file_.read(header, sizeof(header)) == sizeof(header);
+  int32_t count = ok ? readBigEndian(header) : 0;
+  size_t bitmaps = VLW_HEADER_BYTES + static_cast<size_t>(count) * VLW_METRICS_BYTES;
+  ok = ok && count > 0 && bitmaps <= file_.size();
+  if (ok) {
+    glyphs_.reserve(count);
+  }
+  uint32_t offset = bitmaps;
+  for (int32_t i = 0; ok && i < count; ++i) {
+    uint8_t m[VLW_METRICS_BYTES];
+    if (file_.read(m, sizeof(m)) != sizeof(m)) {
+      ok = false;
+      break;
+    }
+    Glyph g;
+    g.code = static_cast<uint32_t>(readBigEndian(m));
+    int32_t height = readBigEndian(m + 4);
+    int32_t width = readBigEndian(m + 8);
+    int32_t advance = readBigEndian(m + 12);
+    g.dY = static_cast<int16_t>(readBigEndian(m + 16));
+    g.dX = static_cast<int16_t>(readBigEndian(m + 20));
+    if (height < 0 || width < 0 || advance < 0 || height > VLW_MAX_GLYPH ||
+        width > VLW_MAX_GLYPH || advance > VLW_MAX_GLYPH) {
+      ok = false;
+      break;
+    }
+    g.width = static_cast<uint16_t>(width);
+    g.height = static_cast<uint16_t>(height);
+    g.advance = static_cast<uint16_t>(advance);
+    g.offset = offset;
+    g.slot = -1;
+    offset += g.width * g.height;
+    // Same line metrics as TFT_eSPI, so both place text alike
+    ascent_ = std::max<int16_t>(ascent_, g.dY);
+    descent_ = std::max<int16_t>(descent_, g.height - g.dY);
+    glyphs_.push_back(g);
+  }
+  if (!ok || offset > file_.size()) {
+    Serial.printf("Font %s is not a valid VLW font\n", path);
+    unload();
+    return false;
+  }
+  std::sort(glyphs_.begin(), glyphs_.end(),
+            [](const Glyph &a, const Glyph &b) { return a.code < b.code; });
+  return true;
+}
+
+void CachedFont::unload() {
+  if (file_) {
+    file_.close();
+  }
+  std::vector<Glyph>().swap(glyphs_);
+  std::vector<Slot>().swap(slots_);
+  std::vector<uint8_t>().swap(alpha_);
+  bytes_ = 0;
+  ascent_ = 0;
+  descent_ = 0;
+}
+
+void CachedFont::setColors(uint16_t fg, uint16_t bg) {
+  if (fg == fg_ && bg == bg_) {
+    return;
+  }
+  fg_ = fg;
+  bg_ = bg;
+  for (Slot &s : slots_) {
+    glyphs_[s.glyph].slot = -1;
+  }
+  slots_.clear();
+  bytes_ = 0;
+}
+
+int CachedFont::find(uint32_t code) const {
+  auto it = std::lower_bound(
+      glyphs_.begin(), glyphs_.end(), code,
+      [](const Glyph &g, uint32_t c) { return g.code < c; });
+  return it != glyphs_.end() && it->code == code
+             ? static_cast<int>(it - glyphs_.begin())
+             : -1;
+}
+
+// Drop the least recently used cell.
+void CachedFont::evict() {
+  size_t oldest = 0;
+  for (size_t i = 1; i < slots_.size(); ++i) {
+    if (slots_[i].used < slots_[oldest].used) {
+      oldest = i;
+    }
+  }
+  bytes_ -= slots_[oldest].cell.size() * sizeof(uint16_t);
+  glyphs_[slots_[oldest].glyph].slot = -1;
+  if (oldest + 1 != slots_.size()) {
+    slots_[oldest] = std::move(slots_.back());
+    glyphs_[slots_[oldest].glyph].slot = static_cast<int16_t>(oldest);
+  }
+  slots_.pop_back();
+}
+
+// Cell of glyph ``index``, rendered and cached on first use.
+const std::vector<uint16_t> *CachedFont::cell(int index) {
+  Glyph &g = glyphs_[index];
+  if (g.slot >= 0) {
+    slots_[g.slot].used = ++tick_;
+    return &slots_[g.slot].cell;
+  }
+  int16_t lineHeight = height();
+  size_t pixels = static_cast<size_t>(g.advance) * lineHeight;
+  size_t need = pixels * sizeof(uint16_t);
+  if (pixels == 0 || need > GLYPH_CACHE_BYTES) {
+    return nullptr;
+  }
+  while (!slots_.empty() && bytes_ + need > GLYPH_CACHE_BYTES) {
+    evict();
+  }
+
+  size_t mapBytes = static_cast<size_t>(g.width) * g.height;
+  alpha_.resize(mapBytes);
+  if (mapBytes && (!file_.seek(g.offset) ||
+                   file_.read(alpha_.data(), mapBytes) != mapBytes)) {
+    return nullptr;
+  }
+  Slot s;
+  s.glyph = static_cast<uint16_t>(index);
+  s.used = ++tick_;
+  s.cell.assign(pixels, displayOrder(bg_));
+  int top = ascent_ - g.dY;
+  for (int y = 0; y < g.height; ++y) {
+    int cy = top + y;
+    if (cy < 0 || cy >= lineHeight) {
+      continue;
+    }
+    for (int x = 0; x < g.width; ++x) {
+      int cx = g.dX + x;
+      uint8_t a = alpha_[static_cast<size_t>(y) * g.width + x];
+      if (cx >= 0 && cx < g.advance && a) {
+        s.cell[static_cast<size_t>(cy) * g.advance + cx] =
+            displayOrder(blend(a, fg_, bg_));
+      }
+    }
+  }
+  bytes_ += need;
+  g.slot = static_cast<int16_t>(slots_.size());
+  slots_.push_back(std::move(s));
+  return &slots_.back().cell;
+}
+
+int16_t CachedFont::textWidth(const char *text) const {
+  int32_t width = 0;
+  while (*text) {
+    int index = find(nextCodepoint(text));
+    if (index >= 0) {
+      width += glyphs_[index].advance;
+    }
+  }
+  return static_cast<int16_t>(width);
+}
+
+int16_t CachedFont::drawString(TFT_eSPI &tft, const char *text, int32_t x,
+                               int32_t y, uint8_t datum) {
+  if (!loaded()) {
+    return 0;
+  }
+  int16_t width = textWidth(text);
+  int16_t lineHeight = height();
+  // TFT_eSPI's nine datums: column = datum % 3, row = datum / 3
+  if (datum <= BR_DATUM) {
+    x -= (datum % 3) * width / 2;
+    y -= (datum / 3) * lineHeight / 2;
+  }
+  while (*text) {
+    int index = find(nextCodepoint(text));
+    if (index < 0) {
+      continue;
+    }
+    const std::vector<uint16_t> *pixels = cell(index);
+    uint16_t advance = glyphs_[index].advance;
+    if (pixels) {
+      tft.pushImage(x, y, advance, lineHeight,
+                    const_cast<uint16_t *>(pixels->data()));
+    }
+    x += advance;
+  }
+  return width;
+}
@@ -0,0 +1,81 @@
+/*
+  -----------------------------------------------------------------------------
+  glyph_cache.h — Anti-aliased (VLW) fonts drawn from a RAM glyph cache
+
+  TFT_eSPI renders a smooth font by reading every glyph's alpha map from
+  the file system and blending it into the display pixel by pixel, which
+  is far slower than the built-in bitmap fonts.  ``CachedFont`` reads the
+  glyph metrics of a VLW font once and keeps the most recently used glyphs
+  as complete character cells in RAM: ``xAdvance`` by the line height,
+  already blended between the current foreground and background colours
+  and stored in the display's byte order.  Drawing a cached character is
+  then a single ``pushImage()`` of its cell, and since the cell covers the
+  whole advance it also erases the text it overwrites.
+
+  The cache holds at most ``GLYPH_CACHE_BYTES`` of cells and evicts the
+  least recently used glyph when full.  Changing the colours empties it.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <vector>
+
+class TFT_eSPI;
+
+#ifndef GLYPH_CACHE_BYTES
+#define GLYPH_CACHE_BYTES 16384
+#endif
+
+class CachedFont {
+public:
+  // Load the metrics of the VLW font at ``path``; the alpha maps stay in
+  // the file and are read when a glyph enters the cache.
+  bool load(fs::FS &fs, const char *path);
+  void unload();
+  bool loaded() const { return !glyphs_.empty(); }
+
+  void setColors(uint16_t fg, uint16_t bg);
+
+  int16_t height() const { return ascent_ + descent_; }
+  int16_t textWidth(const char *text) const;
+
+  // Draw UTF-8 ``text`` aligned to (x, y) by a TFT_eSPI datum such as
+  // TL_DATUM or MR_DATUM; returns the width drawn.
+  int16_t drawString(TFT_eSPI &tft, const char *text, int32_t x, int32_t y,
+                     uint8_t datum);
+
+private:
+  struct Glyph {
+    uint32_t code;
+    uint32_t offset;   // of the alpha map in the file
+    uint16_t width;
+    uint16_t height;
+    uint16_t advance;
+    int16_t dX;
+    int16_t dY;
+    int16_t slot;      // index into slots_, -1 if not cached
+  };
+  struct Slot {
+    uint16_t glyph;
+    uint32_t used;
+    std::vector<uint16_t> cell;
+  };
+
+  int find(uint32_t code) const;
+  const std::vector<uint16_t> *cell(int glyph);
+  void evict();
+
+  fs::File file_;
+  std::vector<Glyph> glyphs_;
+  std::vector<Slot> slots_;
+  std::vector<uint8_t> alpha_;
+  size_t bytes_ = 0;
+  uint32_t tick_ = 0;
+  int16_t ascent_ = 0;
+  int16_t descent_ = 0;
+  uint16_t fg_ = 0xFFFF;
+  uint16_t bg_ = 0x0000;
+};
@@ -0,0 +1,322 @@
+#include "history.h"
+
+#include <math.h>
+
+static constexpr uint32_t SECONDS_PER_HOUR = 3600;
+static constexpr uint32_t SECONDS_PER_MINUTE = 60;
+static constexpr uint32_t SECONDS_PER_DAY = 86400;
+
+static constexpr uint32_t MINUTE_GROUP_SLOTS =
+    EnergyHistory::MINUTE_SLOTS / EnergyHistory::MINUTE_GROUP;
+static constexpr uint32_t HOUR_GROUP_SLOTS =
+    EnergyHistory::HOUR_SLOTS / EnergyHistory::HOUR_GROUP;
+
+void EnergyHistory::Aggregate::clear() {
+  genSum = 0.0f;
+  consSum = 0.0f;
+  genMin = INFINITY;
+  genMax = -INFINITY;
+  consMin = INFINITY;
+  consMax = -INFINITY;
+  count = 0;
+}
+
+void EnergyHistory::Aggregate::add(float gen, float cons) {
+  genSum += gen;
+  consSum += cons;
+  genMin = fminf(genMin, gen);
+  genMax = fmaxf(genMax, gen);
+  consMin = fminf(consMin, cons);
+  consMax = fmaxf(consMax, cons);
+  ++count;
+}
+
+void EnergyHistory::Aggregate::add(const Aggregate &other) {
+  if (other.count == 0) {
+    return;
+  }
+  genSum += other.genSum;
+  consSum += other.consSum;
+  genMin = fminf(genMin, other.genMin);
+  genMax = fmaxf(genMax, other.genMax);
+  consMin = fminf(consMin, other.consMin);
+  consMax = fmaxf(consMax, other.consMax);
+  count += other.count;
+}
+
+EnergyHistory::EnergyHistory() : hourHead_(0), minuteHead_(0) {
+  for (uint32_t i = 0; i < HOUR_SLOTS; ++i) {
+    hours_[i].gen = NAN;
+    hours_[i].cons = NAN;
+  }
+  for (uint32_t i = 0; i < MINUTE_SLOTS; ++i) {
+    minutes_[i].gen = NAN;
+    minutes_[i].cons = NAN;
+    minuteCount_[i] = 0;
+  }
+  for (uint32_t i = 0; i < HOUR_GROUP_SLOTS; ++i) {
+    hourGroups_[i].clear();
+  }
+  for (uint32_t i = 0; i < MINUTE_GROUP_SLOTS; ++i) {
+    minuteGroups_[i].clear();
+  }
+}
+
+bool EnergyHistory::hourValid(uint32_t hour) const {
+  return hourHead_ != 0 && hour <= hourHead_ && hourHead_ - hour < HOUR_SLOTS;
+}
+
+bool EnergyHistory::minuteValid(uint32_t minute) const {
+  return minuteHead_ != 0 && minute <= minuteHead_ &&
+         minuteHead_ - minute < MINUTE_SLOTS;
+}
+
+// Move the head forward, clearing the slots that are reused.  The clearing
+// runs to the end of the head's group, so the group never mixes new values
+// with the ones from one ring length ago that shared its position.
+void EnergyHistory::advanceHours(uint32_t hour) {
+  if (hour <= hourHead_) {
+    return;
+  }
+  uint32_t end = hour - hour % HOUR_GROUP + HOUR_GROUP - 1;
+  uint32_t steps = end - hourHead_;
+  if (hourHead_ == 0 || steps > HOUR_SLOTS) {
+    steps = HOUR_SLOTS;
+  }
+  for (uint32_t h = end - steps + 1; h <= end; ++h) {
+    hours_[h % HOUR_SLOTS].gen = NAN;
+    hours_[h % HOUR_SLOTS].cons = NAN;
+  }
+  for (uint32_t g = (end - steps + 1) / HOUR_GROUP, n = 0;
+       g <= end / HOUR_GROUP && n < HOUR_GROUP_SLOTS; ++g, ++n) {
+    updateHourGroup(g);
+  }
+  hourHead_ = hour;
+}
+
+void EnergyHistory::advanceMinutes(uint32_t minute) {
+  if (minute <= minuteHead_) {
+    return;
+  }
+  uint32_t end = minute - minute % MINUTE_GROUP + MINUTE_GROUP - 1;
+  uint32_t steps = end - minuteHead_;
+  if (minuteHead_ == 0 || steps > MINUTE_SLOTS) {
+    steps = MINUTE_SLOTS;
+  }
+  for (uint32_t m = end - steps + 1; m <= end; ++m) {
+    minutes_[m % MINUTE_SLOTS].gen = NAN;
+    minutes_[m % MINUTE_SLOTS].cons = NAN;
+    minuteCount_[m % MINUTE_SLOTS] = 0;
+  }
+  for (uint32_t g = (end - steps + 1) / MINUTE_GROUP, n = 0;
+       g <= end / MINUTE_GROUP && n < MINUTE_GROUP_SLOTS; ++g, ++n) {
+    updateMinuteGroup(g);
+  }
+  minuteHead_ = minute;
+}
+
+void EnergyHistory::updateHourGroup(uint32_t group) {
+  Aggregate &a = hourGroups_[group % HOUR_GROUP_SLOTS];
+  a.clear();
+  const Slot *child = &hours_[(group % HOUR_GROUP_SLOTS) * HOUR_GROUP];
+  for (uint32_t i = 0; i < HOUR_GROUP; ++i) {
+    if (!isnan(child[i].gen) && !isnan(child[i].cons)) {
+      a.add(child[i].gen, child[i].cons);
+    }
+  }
+}
+
+void EnergyHistory::updateMinuteGroup(uint32_t group) {
+  Aggregate &a = minuteGroups_[group % MINUTE_GROUP_SLOTS];
+  a.clear();
+  uint32_t first = (group % MINUTE_GROUP_SLOTS) * MINUTE_GROUP;
+  for (uint32_t i = first; i < first + MINUTE_GROUP; ++i) {
+    if (minuteCount_[i] > 0 && !isnan(minutes_[i].gen) &&
+        !isnan(minutes_[i].cons)) {
+      a.add(minutes_[i].gen, minutes_[i].cons);
+    }
+  }
+}
+
+void EnergyHistory::recordHours(uint32_t dayStart, const float *gen,
+                                const float *cons, size_t hours) {
+  if (hours == 0) {
+    return;
+  }
+  uint32_t first = dayStart / SECONDS_PER_HOUR;
+  uint32_t last = first + hours - 1;
+  advanceHours(last);
+  for (uint32_t h = first; h <= last; ++h) {
+    if (hourValid(h)) {
+      hours_[h % HOUR_SLOTS].gen = gen[h - first];
+      hours_[h % HOUR_SLOTS].cons = cons[h - first];
+    }
+  }
+  for (uint32_t g = first / HOUR_GROUP; g <= last / HOUR_GROUP; ++g) {
+    updateHourGroup(g);
+  }
+}
+
+void EnergyHistory::recordPower(uint32_t t, float powerW) {
+  if (isnan(powerW)) {
+    return;
+  }
+  uint32_t minute = t / SECONDS_PER_MINUTE;
+  advanceMinutes(minute);
+  if (!minuteValid(minute)) {
+    return;
+  }
+  Slot &s = minutes_[minute % MINUTE_SLOTS];
+  uint16_t &n = minuteCount_[minute % MINUTE_SLOTS];
+  float gen = powerW < 0.0f ? -powerW : 0.0f;
+  float cons = powerW > 0.0f ? powerW : 0.0f;
+  if (n == 0) {
+    s.gen = gen;
+    s.cons = cons;
+  } else {
+    // Running mean, so no sums need to be kept per slot.
+    s.gen += (gen - s.gen) / (n + 1);
+    s.cons += (cons - s.cons) / (n + 1);
+  }
+  if (n < UINT16_MAX) {
+    ++n;
+  }
+  updateMinuteGroup(minute / MINUTE_GROUP);
+}
+
+uint32_t EnergyHistory::oldest() const {
+  if (hourHead_ == 0) {
+    return 0;
+  }
+  uint32_t first = hourHead_ >= HOUR_SLOTS ? hourHead_ - HOUR_SLOTS + 1 : 0;
+  return first * SECONDS_PER_HOUR;
+}
+
+// Add slot ``index`` of ``level`` to ``acc`` if it holds data.
+void EnergyHistory::accumulate(Level level, uint32_t index,
+                               Aggregate &acc) const {
+  switch (level) {
+  case Level::MINUTES:
+    if (minuteValid(index) && minuteCount_[index % MINUTE_SLOTS] > 0) {
+      const Slot &s = minutes_[index % MINUTE_SLOTS];
+      if (!isnan(s.gen) && !isnan(s.cons)) {
+        acc.add(s.gen, s.cons);
+      }
+    }
+    break;
+  case Level::MINUTE_GROUPS:
+    if (minuteHead_ != 0 && index <= minuteHead_ / MINUTE_GROUP &&
+        minuteHead_ / MINUTE_GROUP - index < MINUTE_GROUP_SLOTS) {
+      acc.add(minuteGroups_[index % MINUTE_GROUP_SLOTS]);
+    }
+    break;
+  case Level::HOURS:
+    if (hourValid(index)) {
+      const Slot &s = hours_[index % HOUR_SLOTS];
+      if (!isnan(s.gen) && !isnan(s.cons)) {
+        acc.add(s.gen, s.cons);
+      }
+    }
+    break;
+  case Level::HOUR_GROUPS:
+    if (hourHead_ != 0 && index <= hourHead_ / HOUR_GROUP &&
+        hourHead_ / HOUR_GROUP - index < HOUR_GROUP_SLOTS) {
+      acc.add(hourGroups_[index % HOUR_GROUP_SLOTS]);
+    }
+    break;
+  }
+}
+
+// True if some minutes of [from, to) are still held.
+bool EnergyHistory::minutesCover(uint32_t from, uint32_t to) const {
+  if (minuteHead_ == 0) {
+    return false;
+  }
+  uint32_t first = from / SECONDS_PER_MINUTE;
+  uint32_t last = (to - 1) / SECONDS_PER_MINUTE;
+  uint32_t oldestMinute =
+      minuteHead_ >= MINUTE_SLOTS ? minuteHead_ - MINUTE_SLOTS + 1 : 0;
+  return first <= minuteHead_ && last >= oldestMinute;
+}
+
+size_t EnergyHistory::render(uint32_t from, uint32_t to, size_t maxColumns,
+                             float *gen, float *cons,
+                             Envelope *envelope) const {
+  if (to <= from || maxColumns == 0) {
+    return 0;
+  }
+  uint32_t span = to - from;
+  bool useMinutes = span <= SECONDS_PER_DAY && minutesCover(from, to);
+  uint32_t unit = useMinutes ? SECONDS_PER_MINUTE : SECONDS_PER_HOUR;
+  size_t points = span / unit;
+  size_t n = points < 1 ? 1 : points < maxColumns ? points : maxColumns;
+
+  // Read the groups once a column is at least one group wide.
+  Level level = useMinutes ? Level::MINUTES : Level::HOURS;
+  uint32_t groupUnit = unit * (useMinutes ? MINUTE_GROUP : HOUR_GROUP);
+  if (span / n >= groupUnit) {
+    level = useMinutes ? Level::MINUTE_GROUPS : Level::HOUR_GROUPS;
+  }
+  reduce(level, from, span, n, gen, cons, envelope);
+  return n;
+}
+
+void EnergyHistory::query(uint32_t from, uint32_t step, size_t count,
+                          float *gen, float *cons, Envelope *envelope) const {
+  if (step == 0 || count == 0) {
+    return;
+  }
+  uint32_t span = step * count;
+  Level level;
+  if (step >= SECONDS_PER_HOUR * HOUR_GROUP) {
+    level = Level::HOUR_GROUPS;
+  } else if (step >= SECONDS_PER_HOUR || !minutesCover(from, from + span)) {
+    level = Level::HOURS;
+  } else if (step >= SECONDS_PER_MINUTE * MINUTE_GROUP) {
+    level = Level::MINUTE_GROUPS;
+  } else {
+    level = Level::MINUTES;
+  }
+  reduce(level, from, span, count, gen, cons, envelope);
+}
+
+// Average [from, from + span) into ``n`` equal columns from ``level``.
+void EnergyHistory::reduce(Level level, uint32_t from, uint32_t span,
+                           size_t n, float *gen, float *cons,
+                           Envelope *envelope) const {
+  static const uint32_t UNITS[] = {
+      SECONDS_PER_MINUTE, SECONDS_PER_MINUTE * MINUTE_GROUP, SECONDS_PER_HOUR,
+      SECONDS_PER_HOUR * HOUR_GROUP};
+  const uint32_t unit = UNITS[static_cast<uint8_t>(level)];
+  const bool useMinutes = level == Level::MINUTES || level == Level::MINUTE_GROUPS;
+  for (size_t c = 0; c < n; ++c) {
+    uint32_t colFrom = from + static_cast<uint32_t>(
+                                  static_cast<uint64_t>(span) * c / n);
+    uint32_t colTo = from + static_cast<uint32_t>(
+                                static_cast<uint64_t>(span) * (c + 1) / n);
+    Aggregate acc;
+    acc.clear();
+    // Every slot whose start falls into the column contributes; a column
+    // narrower than one slot takes the slot it starts in.
+    uint32_t first = (colFrom + unit - 1) / unit;
+    uint32_t last = colTo > 0 ? (colTo - 1) / unit : 0;
+    if (first > last) {
+      first = last = colFrom / unit;
+    }
+    for (uint32_t k = first; k <= last; ++k) {
+      accumulate(level, k, acc);
+    }
+    // Minutes before the live source started fall back to the hour.
+    if (acc.count == 0 && useMinutes) {
+      accumulate(Level::HOURS, colFrom / SECONDS_PER_HOUR, acc);
+    }
+    gen[c] = acc.count ? acc.genSum / acc.count : NAN;
+    cons[c] = acc.count ? acc.consSum / acc.count : NAN;
+    if (envelope) {
+      envelope[c].genMin = acc.count ? acc.genMin : NAN;
+      envelope[c].genMax = acc.count ? acc.genMax : NAN;
+      envelope[c].consMin = acc.count ? acc.consMin : NAN;
+      envelope[c].consMax = acc.count ? acc.consMax : NAN;
+    }
+  }
+}
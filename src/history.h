@@ -0,0 +1,123 @@
+/*
+  -----------------------------------------------------------------------------
+  history.h — RAM cache of past generation and consumption
+
+  The display only receives today's 24 hourly values from the data sources.
+  To let the graph be panned and zoomed without going back to the network
+  or the flash, every fetched day and every live reading is also kept here:
+
+    • hourly values for the last 31 days, filled from the fetched curves;
+    • one-minute averages for the last 24 hours, filled from live readings
+      (optical and RPC meters only).
+
+  Above each of them sits a coarser level of aggregates (sum, minimum and
+  maximum): 8-minute groups over the minutes and quarter days over the
+  hours.  A group is recomputed from its children whenever one of them is
+  written, so the levels are always current.  ``render()`` reduces any time
+  window to at most a few dozen columns and reads the coarsest level that
+  is still finer than one column, so every column touches at most a handful
+  of slots and a frame costs O(columns) whatever the zoom level.
+
+  Times are UNIX seconds (UTC).  The code is plain C++ without Arduino
+  dependencies so it can be exercised on a host.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class EnergyHistory {
+public:
+  static constexpr uint32_t HOUR_SLOTS = 31 * 24;
+  static constexpr uint32_t MINUTE_SLOTS = 24 * 60;
+  // Children per slot of the aggregate levels.
+  static constexpr uint32_t MINUTE_GROUP = 8;
+  static constexpr uint32_t HOUR_GROUP = 6;
+
+  // Range of the values that went into one rendered column.
+  struct Envelope {
+    float genMin;
+    float genMax;
+    float consMin;
+    float consMax;
+  };
+
+  EnergyHistory();
+
+  // Store hourly values (W) for the hours [0, hours) of the day starting at
+  // ``dayStart``.  Existing values for these hours are replaced.
+  void recordHours(uint32_t dayStart, const float *gen, const float *cons,
+                   size_t hours);
+
+  // Add an instantaneous grid power reading (import > 0) at time ``t``.
+  void recordPower(uint32_t t, float powerW);
+
+  // Average the window [from, to) into at most ``maxColumns`` equal
+  // columns.  Minute data is used for windows of up to a day if any is
+  // available, hourly data otherwise and for minutes without readings.
+  // Columns without data are NaN.  If ``envelope`` is given it receives
+  // the smallest and largest value of each column.
+  // Returns the number of columns written.
+  size_t render(uint32_t from, uint32_t to, size_t maxColumns, float *gen,
+                float *cons, Envelope *envelope = nullptr) const;
+
+  // Average the ``count`` intervals [from + i * step, from + (i + 1) * step)
+  // like ``render()``.  The coarsest level whose slots fit into ``step``
+  // is read, so a query costs O(count) for any step.  ``envelope`` may be
+  // null.
+  void query(uint32_t from, uint32_t step, size_t count, float *gen,
+             float *cons, Envelope *envelope) const;
+
+  // Start of the oldest hour still held, 0 while the history is empty.
+  uint32_t oldest() const;
+
+private:
+  struct Slot {
+    float gen;
+    float cons;
+  };
+
+  struct Aggregate {
+    float genSum;
+    float consSum;
+    float genMin;
+    float genMax;
+    float consMin;
+    float consMax;
+    uint16_t count;
+
+    void clear();
+    void add(float gen, float cons);
+    void add(const Aggregate &other);
+  };
+
+  enum class Level : uint8_t { MINUTES, MINUTE_GROUPS, HOURS, HOUR_GROUPS };
+
+  static_assert(MINUTE_SLOTS % MINUTE_GROUP == 0, "groups must tile the ring");
+  static_assert(HOUR_SLOTS % HOUR_GROUP == 0, "groups must tile the ring");
+
+  // Each level is a ring indexed by the absolute hour or minute number; a
+  // group occupies the same ring position as its children divided by the
+  // group size.  ``*Head_`` is the newest number written; slots older than
+  // one ring length are stale.
+  bool hourValid(uint32_t hour) const;
+  bool minuteValid(uint32_t minute) const;
+  void advanceHours(uint32_t hour);
+  void advanceMinutes(uint32_t minute);
+  void updateHourGroup(uint32_t group);
+  void updateMinuteGroup(uint32_t group);
+  void accumulate(Level level, uint32_t index, Aggregate &acc) const;
+  bool minutesCover(uint32_t from, uint32_t to) const;
+  void reduce(Level level, uint32_t from, uint32_t span, size_t n, float *gen,
+              float *cons, Envelope *envelope) const;
+
+  Slot hours_[HOUR_SLOTS];
+  Slot minutes_[MINUTE_SLOTS];
+  uint16_t minuteCount_[MINUTE_SLOTS];
+  Aggregate hourGroups_[HOUR_SLOTS / HOUR_GROUP];
+  Aggregate minuteGroups_[MINUTE_SLOTS / MINUTE_GROUP];
+  uint32_t hourHead_;
+  uint32_t minuteHead_;
+};
@@ -0,0 +1,303 @@
+#include "influx_export.h"
+
+#include <HTTPClient.h>
+#include <LittleFS.h>
+#include <WiFi.h>
+#include <stdarg.h>
+
+#include "config_store.h"
+#include "deflate.h"
+#include "secrets.h"
+
+// Tag identifying this display in the database.
+#ifndef INFLUX_DEVICE_TAG
+#define INFLUX_DEVICE_TAG "solix-display"
+#endif
+
+constexpr size_t INFLUX_RING_CAPACITY = 256;
+constexpr size_t INFLUX_BATCH_SAMPLES = 64;
+constexpr uint32_t INFLUX_FLUSH_INTERVAL_MS = 30UL * 1000UL;
+constexpr uint32_t INFLUX_BACKOFF_MIN_MS = 5UL * 1000UL;
+constexpr uint32_t INFLUX_BACKOFF_MAX_MS = 5UL * 60UL * 1000UL;
+constexpr size_t INFLUX_LINE_MAX = 160;
+constexpr size_t INFLUX_SPILL_MAX_BYTES = 64UL * 1024UL;
+constexpr const char *INFLUX_SPILL_PATH = "/influx.spill";
+
+// Ring buffer shared between producers and the export task.
+static ExportSample ring[INFLUX_RING_CAPACITY];
+static size_t ringHead = 0; // index of the oldest sample
+static size_t ringCount = 0;
+static uint32_t droppedSamples = 0;
+static portMUX_TYPE ringMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Export task state.
+static TaskHandle_t exportTaskHandle = nullptr;
+static bool spillAvailable = false;
+static size_t spillOffset = 0; // bytes of the spill file already sent
+static char *textBuf = nullptr;
+static uint8_t *gzBuf = nullptr;
+static size_t gzLen = 0;
+static size_t gzCapacity = 0;
+
+// Sink collecting compressed output into ``gzBuf``.  The buffer is sized
+// for the worst case (uncompressed text plus framing) so it never grows.
+static void gzSink(void *, const uint8_t *data, size_t len) {
+  if (gzLen + len <= gzCapacity) {
+    memcpy(gzBuf + gzLen, data, len);
+    gzLen += len;
+  }
+}
+
+// Fields beyond this magnitude are not plausible readings and are skipped,
+// which also bounds the width of every "%.3f".
+constexpr float INFLUX_FIELD_LIMIT = 1e9f;
+
+// Append to the line being formatted in ``out``.  Returns false, leaving
+// ``n`` unchanged, if the text does not fit in ``cap``.
+static bool appendLine(char *out, size_t cap, size_t &n, const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  int len = vsnprintf(out + n, cap - n, fmt, args);
+  va_end(args);
+  if (len < 0 || static_cast<size_t>(len) >= cap - n) {
+    return false;
+  }
+  n += len;
+  return true;
+}
+
+// Format one sample as a line of line protocol.  Returns 0 if the sample
+// has no fields or the line does not fit in ``cap``.
+static size_t formatLine(const ExportSample &s, char *out, size_t cap) {
+  size_t n = 0;
+  if (!appendLine(out, cap, n, "solix,device=%s ", INFLUX_DEVICE_TAG)) {
+    return 0;
+  }
+  size_t fieldsStart = n;
+  const struct {
+    const char *key;
+    float value;
+  } fields[] = {{"battery", s.batteryPercent},
+                {"gen_kwh", s.dailyGeneration},
+                {"cons_kwh", s.dailyConsumption},
+                {"power_w", s.powerW}};
+  for (const auto &f : fields) {
+    if (!isfinite(f.value) || fabsf(f.value) >= INFLUX_FIELD_LIMIT) {
+      continue;
+    }
+    if (!appendLine(out, cap, n, "%s%s=%.3f", n > fieldsStart ? "," : "", f.key,
+                    f.value)) {
+      return 0;
+    }
+  }
+  if (n == fieldsStart ||
+      !appendLine(out, cap, n, " %lu\n", static_cast<unsigned long>(s.time))) {
+    return 0;
+  }
+  return n;
+}
+
+/*
+ * Compress and post a batch.  Returns true if the server accepted it.
+ */
+static bool postBatch(const ExportSample *samples, size_t count) {
+  size_t textLen = 0;
+  for (size_t i = 0; i < count; ++i) {
+    textLen += formatLine(samples[i], textBuf + textLen, INFLUX_LINE_MAX);
+  }
+  if (textLen == 0) {
+    return true;
+  }
+  // About 4 KB of hash table and output buffer: kept off the task stack.
+  static DeflateWriter gz;
+  gzLen = 0;
+  gz.begin(gzSink, nullptr);
+  gz.write(reinterpret_cast<const uint8_t *>(textBuf), textLen);
+  gz.finish();
+
+  // The endpoint is re-read for every batch so configuration changes take
+  // effect without restarting the task.
+  String url = configString(ConfigKey::InfluxUrl);
+  String token = configString(ConfigKey::InfluxToken);
+  if (url.length() == 0) {
+    return false;
+  }
+  WiFiClient client;
+  HTTPClient http;
+  http.begin(client, url);
+  http.addHeader("Content-Type", "text/plain; charset=utf-8");
+  http.addHeader("Content-Encoding", "gzip");
+  if (token.length() > 0) {
+    http.addHeader("Authorization", String("Token ") + token);
+  }
+  int code = http.POST(gzBuf, gzLen);
+  http.end();
+  if (code != HTTP_CODE_OK && code != HTTP_CODE_NO_CONTENT) {
+    Serial.printf("Influx export failed: %d\n", code);
+    return false;
+  }
+  portENTER_CRITICAL(&ringMux);
+  uint32_t dropped = droppedSamples;
+  portEXIT_CRITICAL(&ringMux);
+  Serial.printf("Exported %u samples (%u -> %u bytes, %u dropped)\n",
+                static_cast<unsigned>(count), static_cast<unsigned>(textLen),
+                static_cast<unsigned>(gzLen), static_cast<unsigned>(dropped));
+  return true;
+}
+
+// Copy up to ``max`` of the oldest ring entries without removing them.
+static size_t peekRing(ExportSample *out, size_t max) {
+  portENTER_CRITICAL(&ringMux);
+  size_t n = min(ringCount, max);
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = ring[(ringHead + i) % INFLUX_RING_CAPACITY];
+  }
+  portEXIT_CRITICAL(&ringMux);
+  return n;
+}
+
+static void dropRing(size_t n) {
+  portENTER_CRITICAL(&ringMux);
+  n = min(ringCount, n);
+  ringHead = (ringHead + n) % INFLUX_RING_CAPACITY;
+  ringCount -= n;
+  portEXIT_CRITICAL(&ringMux);
+}
+
+// Move the oldest batch from the ring to the spill file.
+static void spillOldest(ExportSample *batch) {
+  size_t n = peekRing(batch, INFLUX_BATCH_SAMPLES);
+  if (n == 0) {
+    return;
+  }
+  File f = LittleFS.open(INFLUX_SPILL_PATH, FILE_APPEND);
+  if (f && f.size() + n * sizeof(ExportSample) <= INFLUX_SPILL_MAX_BYTES) {
+    f.write(reinterpret_cast<const uint8_t *>(batch), n * sizeof(ExportSample));
+  } else {
+    portENTER_CRITICAL(&ringMux);
+    droppedSamples += n;
+    portEXIT_CRITICAL(&ringMux);
+  }
+  if (f) {
+    f.close();
+  }
+  dropRing(n);
+}
+
+// Send the next batch from the spill file.  Returns false on failure.
+static bool drainSpill(ExportSample *batch) {
+  File f = LittleFS.open(INFLUX_SPILL_PATH, FILE_READ);
+  if (!f) {
+    return true;
+  }
+  size_t size = f.size();
+  f.seek(spillOffset);
+  size_t bytes = f.read(reinterpret_cast<uint8_t *>(batch),
+                        INFLUX_BATCH_SAMPLES * sizeof(ExportSample));
+  f.close();
+  size_t n = bytes / sizeof(ExportSample);
+  if (n > 0 && !postBatch(batch, n)) {
+    return false;
+  }
+  spillOffset += n * sizeof(ExportSample);
+  if (n == 0 || spillOffset + sizeof(ExportSample) > size) {
+    LittleFS.remove(INFLUX_SPILL_PATH);
+    spillOffset = 0;
+  }
+  return true;
+}
+
+static void exportTask(void *) {
+  static ExportSample batch[INFLUX_BATCH_SAMPLES];
+  uint32_t lastFlush = millis();
+  uint32_t backoff = 0;
+  uint32_t retryAt = 0;
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    uint32_t now = millis();
+    if (backoff != 0 && static_cast<int32_t>(now - retryAt) < 0) {
+      continue;
+    }
+    portENTER_CRITICAL(&ringMux);
+    size_t pending = ringCount;
+    portEXIT_CRITICAL(&ringMux);
+    bool due = pending >= INFLUX_BATCH_SAMPLES ||
+               (pending > 0 && now - lastFlush >= INFLUX_FLUSH_INTERVAL_MS);
+    bool spilled = spillAvailable && LittleFS.exists(INFLUX_SPILL_PATH);
+    if (!due && !(spilled && backoff == 0)) {
+      continue;
+    }
+    bool ok = WiFi.status() == WL_CONNECTED;
+    if (ok && due) {
+      size_t n = peekRing(batch, INFLUX_BATCH_SAMPLES);
+      ok = postBatch(batch, n);
+      if (ok) {
+        dropRing(n);
+        lastFlush = now;
+      }
+    }
+    if (ok && spilled) {
+      ok = drainSpill(batch);
+    }
+    if (ok) {
+      backoff = 0;
+      continue;
+    }
+    backoff = backoff == 0 ? INFLUX_BACKOFF_MIN_MS
+                           : min(backoff * 2, INFLUX_BACKOFF_MAX_MS);
+    retryAt = now + backoff;
+    portENTER_CRITICAL(&ringMux);
+    pending = ringCount;
+    portEXIT_CRITICAL(&ringMux);
+    if (spillAvailable && pending > INFLUX_RING_CAPACITY * 3 / 4) {
+      spillOldest(batch);
+    }
+  }
+}
+
+bool beginInfluxExport() {
+  if (exportTaskHandle) {
+    return true;
+  }
+  if (configString(ConfigKey::InfluxUrl).length() == 0) {
+    return false;
+  }
+  size_t textCap = INFLUX_BATCH_SAMPLES * INFLUX_LINE_MAX;
+  textBuf = static_cast<char *>(malloc(textCap));
+  // Fixed Huffman coding expands incompressible input by at most 1/8.
+  gzCapacity = textCap + textCap / 8 + 64;
+  gzBuf = static_cast<uint8_t *>(malloc(gzCapacity));
+  if (!textBuf || !gzBuf) {
+    Serial.println("Influx export: out of memory");
+    return false;
+  }
+  spillAvailable = LittleFS.begin(true);
+  if (!spillAvailable) {
+    Serial.println("Influx export: flash spill unavailable");
+  }
+  // Just above idle: exports must never delay drawing or fetching.
+  if (xTaskCreatePinnedToCore(exportTask, "influx", 6144, nullptr,
+                              tskIDLE_PRIORITY + 1, &exportTaskHandle,
+                              0) != pdPASS) {
+    exportTaskHandle = nullptr;
+    return false;
+  }
+  return true;
+}
+
+void exportSample(const ExportSample &sample) {
+  if (!exportTaskHandle) {
+    return;
+  }
+  portENTER_CRITICAL(&ringMux);
+  if (ringCount < INFLUX_RING_CAPACITY) {
+    ring[(ringHead + ringCount) % INFLUX_RING_CAPACITY] = sample;
+    ++ringCount;
+  } else {
+    // Only the export task removes entries, so a batch it is sending can
+    // never be overwritten.  The task spills early enough that this only
+    // happens when flash is unavailable or full.
+    ++droppedSamples;
+  }
+  portEXIT_CRITICAL(&ringMux);
+}
@@ -0,0 +1,44 @@
+/*
+  -----------------------------------------------------------------------------
+  influx_export.h — Batched InfluxDB line-protocol export
+
+  Samples are queued in a bounded ring buffer and never block the caller.
+  A low-priority task flushes them in batches, either every
+  ``INFLUX_FLUSH_INTERVAL_MS`` or as soon as ``INFLUX_BATCH_SAMPLES`` have
+  accumulated, as gzip-compressed line protocol in a single HTTP request.
+
+  When the database is unreachable the task backs off exponentially.  If
+  the ring fills up in the meantime the oldest samples are spilled to a
+  file on the internal flash and sent once the server is back.  Replaying
+  a spilled batch twice (e.g. after a reboot) is harmless because InfluxDB
+  overwrites points with identical series and timestamp.
+
+  The endpoint is part of the runtime settings (``config_store.h``), with
+  defaults from ``secrets.h``:
+    influx_url   – full write URL including org, bucket and precision,
+                   e.g. "http://192.168.0.10:8086/api/v2/write?org=home&bucket=solar&precision=s"
+                   (INFLUX_WRITE_URL)
+    influx_token – API token with write access, may be empty (INFLUX_TOKEN)
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+// One exported data point.  Fields that are NaN are omitted.
+struct ExportSample {
+  uint32_t time;          // UNIX time in seconds
+  float batteryPercent;   // %
+  float dailyGeneration;  // kWh
+  float dailyConsumption; // kWh
+  float powerW;           // instantaneous grid power, import > 0
+};
+
+// Mount the spill storage and start the export task.  Returns false if no
+// write URL is configured.
+bool beginInfluxExport();
+
+// Queue a sample for export.  Never blocks; the sample is dropped if the
+// ring is full because neither the server nor the flash spill can keep up.
+void exportSample(const ExportSample &sample);
@@ -0,0 +1,469 @@
+#include "json_mapping.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char *const DEFAULT_FIELD_MAP =
+    "battery=battery_percent; generation=daily_generation; "
+    "consumption=daily_consumption; gen_curve=generation_curve[*]; "
+    "cons_curve=consumption_curve[*]";
+
+static const char *const TARGET_NAMES[] = {"battery", "generation", "consumption",
+                                           "gen_curve", "cons_curve"};
+static_assert(sizeof(TARGET_NAMES) / sizeof(TARGET_NAMES[0]) ==
+                  static_cast<size_t>(FieldTarget::COUNT),
+              "TARGET_NAMES must list every FieldTarget");
+
+const char *JsonFieldMap::targetName(FieldTarget target) {
+  return TARGET_NAMES[static_cast<size_t>(target)];
+}
+
+static constexpr uint32_t FNV_OFFSET = 2166136261u;
+static constexpr uint32_t FNV_PRIME = 16777619u;
+
+static inline uint32_t fnvUpdate(uint32_t h, uint8_t b) {
+  return (h ^ b) * FNV_PRIME;
+}
+
+static inline bool isSpace(uint8_t b) {
+  return b == ' ' || b == '\t' || b == '\n' || b == '\r';
+}
+
+static const char *skipSpaces(const char *p) {
+  while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+    ++p;
+  }
+  return p;
+}
+
+JsonFieldMap::JsonFieldMap() : nodeCount_(0) {
+  char err[8];
+  compile(DEFAULT_FIELD_MAP, err, sizeof(err));
+  begin();
+}
+
+int8_t JsonFieldMap::childFor(const Node *nodes, int8_t node, Node::Kind kind,
+                              uint32_t key, uint16_t len) {
+  for (int8_t c = nodes[node].firstChild; c >= 0; c = nodes[c].next) {
+    const Node &n = nodes[c];
+    if (n.kind == kind && n.key == key && (kind != Node::KEY || n.keyLen == len)) {
+      return c;
+    }
+  }
+  return -1;
+}
+
+// Find the child of ``node`` matching ``seg`` or append it.  Returns -1
+// when the table is full.
+int8_t JsonFieldMap::addChild(Node *nodes, uint8_t &count, int8_t node,
+                              const Node &seg) {
+  int8_t child = childFor(nodes, node, seg.kind, seg.key, seg.keyLen);
+  if (child >= 0 || count == MAX_NODES) {
+    return child;
+  }
+  child = static_cast<int8_t>(count++);
+  nodes[child] = seg;
+  nodes[child].next = nodes[node].firstChild;
+  nodes[node].firstChild = child;
+  return child;
+}
+
+bool JsonFieldMap::compile(const char *text, char *err, size_t errCap) {
+  // Build into a copy so a bad mapping leaves the current one in place.
+  Node nodes[MAX_NODES];
+  nodes[0] = Node{Node::ROOT, NO_TARGET, -1, -1, 0, 0, 1.0f};
+  uint8_t count = 1;
+  uint32_t seen = 0;
+
+  const char *p = skipSpaces(text);
+  while (*p) {
+    const char *entry = p;
+    size_t t = 0;
+    size_t nameLen = 0;
+    for (; t < static_cast<size_t>(FieldTarget::COUNT); ++t) {
+      nameLen = strlen(TARGET_NAMES[t]);
+      if (strncmp(p, TARGET_NAMES[t], nameLen) == 0 &&
+          *skipSpaces(p + nameLen) == '=') {
+        break;
+      }
+    }
+    if (t == static_cast<size_t>(FieldTarget::COUNT)) {
+      snprintf(err, errCap, "unknown target at \"%.16s\"", entry);
+      return false;
+    }
+    if (seen & (1u << t)) {
+      snprintf(err, errCap, "%s mapped twice", TARGET_NAMES[t]);
+      return false;
+    }
+    seen |= 1u << t;
+    p = skipSpaces(skipSpaces(p + nameLen) + 1);
+
+    // Walk the path, adding the segments that are not in the trie yet.
+    int8_t node = 0;
+    bool wildcard = false;
+    bool bad = false;
+    do {
+      Node seg{Node::KEY, NO_TARGET, -1, -1, 0, FNV_OFFSET, 1.0f};
+      if (*p == '[') {
+        ++p;
+        if (*p == '*') {
+          seg.kind = Node::ANY;
+          seg.key = 0;
+          wildcard = true;
+          ++p;
+        } else {
+          char *end;
+          unsigned long index = strtoul(p, &end, 10);
+          bad = end == p || index > 0xffff;
+          seg.kind = Node::INDEX;
+          seg.key = static_cast<uint32_t>(index);
+          p = end;
+        }
+        bad = bad || *p++ != ']';
+      } else {
+        if (node != 0 && *p++ != '.') {
+          bad = true;
+        }
+        while (*p && !strchr(".[*;, \t\r\n", *p)) {
+          seg.key = fnvUpdate(seg.key, static_cast<uint8_t>(*p++));
+          ++seg.keyLen;
+        }
+        bad = bad || seg.keyLen == 0;
+      }
+      if (bad) {
+        snprintf(err, errCap, "bad path at \"%.16s\"", entry);
+        return false;
+      }
+      node = addChild(nodes, count, node, seg);
+    } while (node >= 0 && (*p == '.' || *p == '['));
+
+    // A curve mapped to the array itself means each of its elements.
+    bool curve = t == static_cast<size_t>(FieldTarget::GEN_CURVE) ||
+                 t == static_cast<size_t>(FieldTarget::CONS_CURVE);
+    if (node >= 0 && curve && !wildcard) {
+      node = addChild(nodes, count, node,
+                      Node{Node::ANY, NO_TARGET, -1, -1, 0, 0, 1.0f});
+    }
+    if (node < 0) {
+      snprintf(err, errCap, "more than %u path segments",
+               static_cast<unsigned>(MAX_NODES - 1));
+      return false;
+    }
+    if (nodes[node].target != NO_TARGET) {
+      snprintf(err, errCap, "path of %s used twice", TARGET_NAMES[t]);
+      return false;
+    }
+    nodes[node].target = static_cast<uint8_t>(t);
+
+    p = skipSpaces(p);
+    if (*p == '*') {
+      char *end;
+      nodes[node].scale = strtof(++p, &end);
+      if (end == p) {
+        snprintf(err, errCap, "bad factor at \"%.16s\"", entry);
+        return false;
+      }
+      p = skipSpaces(end);
+    }
+    if (*p && *p != ';' && *p != ',') {
+      snprintf(err, errCap, "syntax error at \"%.16s\"", entry);
+      return false;
+    }
+    p = skipSpaces(*p ? p + 1 : p);
+  }
+
+  memcpy(nodes_, nodes, count * sizeof(Node));
+  nodeCount_ = count;
+  begin();
+  return true;
+}
+
+void JsonFieldMap::begin() {
+  state_ = State::VALUE;
+  depth_ = 0;
+  valueNode_ = 0;
+  textLen_ = 0;
+  fields_.battery = NAN;
+  fields_.generation = NAN;
+  fields_.consumption = NAN;
+  for (size_t i = 0; i < CURVE_POINTS; ++i) {
+    fields_.gen[i] = NAN;
+    fields_.cons[i] = NAN;
+  }
+  fields_.genLength = 0;
+  fields_.consLength = 0;
+}
+
+int8_t JsonFieldMap::elementNode(const Frame &array) const {
+  if (array.node < 0) {
+    return -1;
+  }
+  int8_t any = -1;
+  for (int8_t c = nodes_[array.node].firstChild; c >= 0; c = nodes_[c].next) {
+    const Node &n = nodes_[c];
+    if (n.kind == Node::INDEX && n.key == array.index) {
+      return c;
+    }
+    if (n.kind == Node::ANY) {
+      any = c;
+    }
+  }
+  return any;
+}
+
+void JsonFieldMap::push(bool array) {
+  if (depth_ == MAX_DEPTH) {
+    state_ = State::ERROR;
+    return;
+  }
+  Frame &f = stack_[depth_++];
+  f.array = array;
+  f.node = valueNode_;
+  f.index = 0;
+  if (array) {
+    valueNode_ = elementNode(f);
+    state_ = State::VALUE_OR_END;
+  } else {
+    state_ = State::KEY_OR_END;
+  }
+}
+
+void JsonFieldMap::beginValue(uint8_t b) {
+  textLen_ = 0;
+  switch (b) {
+  case '{':
+    push(false);
+    break;
+  case '[':
+    push(true);
+    break;
+  case '"':
+    state_ = State::STRING;
+    break;
+  case 't':
+  case 'f':
+  case 'n':
+    text_[textLen_++] = static_cast<char>(b);
+    state_ = State::LITERAL;
+    break;
+  default:
+    if (b == '-' || (b >= '0' && b <= '9')) {
+      text_[textLen_++] = static_cast<char>(b);
+      state_ = State::NUMBER;
+    } else {
+      state_ = State::ERROR;
+    }
+    break;
+  }
+}
+
+void JsonFieldMap::endValue() {
+  state_ = depth_ == 0 ? State::DONE : State::AFTER_VALUE;
+}
+
+// Convert the text of a finished number, string or literal of a mapped
+// node.  Only numbers (also inside strings) and null reach the target.
+void JsonFieldMap::endScalar() {
+  if (valueNode_ < 0 || nodes_[valueNode_].target == NO_TARGET) {
+    return;
+  }
+  if (textLen_ == sizeof(text_)) {
+    store(NAN);  // too long to be a number
+    return;
+  }
+  text_[textLen_] = '\0';
+  if (strcmp(text_, "null") == 0) {
+    store(NAN);
+    return;
+  }
+  char *end;
+  float v = strtof(text_, &end);
+  if (end != text_ && *skipSpaces(end) == '\0') {
+    store(v);
+  }
+}
+
+void JsonFieldMap::store(float value) {
+  const Node &n = nodes_[valueNode_];
+  value *= n.scale;
+  switch (static_cast<FieldTarget>(n.target)) {
+  case FieldTarget::BATTERY:
+    fields_.battery = value;
+    return;
+  case FieldTarget::GENERATION:
+    fields_.generation = value;
+    return;
+  case FieldTarget::CONSUMPTION:
+    fields_.consumption = value;
+    return;
+  default:
+    break;
+  }
+  // Curve points are numbered by the innermost array
+  int d = depth_ - 1;
+  while (d >= 0 && !stack_[d].array) {
+    --d;
+  }
+  if (d < 0) {
+    return;
+  }
+  uint32_t i = stack_[d].index;
+  bool gen = static_cast<FieldTarget>(n.target) == FieldTarget::GEN_CURVE;
+  if (i < CURVE_POINTS) {
+    (gen ? fields_.gen : fields_.cons)[i] = value;
+  }
+  uint32_t &length = gen ? fields_.genLength : fields_.consLength;
+  if (i >= length) {
+    length = i + 1;
+  }
+}
+
+bool JsonFieldMap::feed(const uint8_t *data, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    if (!feed(data[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool JsonFieldMap::feed(uint8_t b) {
+  switch (state_) {
+  case State::VALUE:
+    if (!isSpace(b)) {
+      beginValue(b);
+    }
+    break;
+
+  case State::VALUE_OR_END:
+    if (b == ']') {
+      --depth_;
+      endValue();
+    } else if (!isSpace(b)) {
+      beginValue(b);
+    }
+    break;
+
+  case State::KEY_OR_END:
+  case State::KEY_START:
+    if (b == '"') {
+      keyHash_ = FNV_OFFSET;
+      keyLen_ = 0;
+      state_ = State::KEY;
+    } else if (b == '}' && state_ == State::KEY_OR_END) {
+      --depth_;
+      endValue();
+    } else if (!isSpace(b)) {
+      state_ = State::ERROR;
+    }
+    break;
+
+  case State::KEY:
+    if (b == '"') {
+      int8_t parent = stack_[depth_ - 1].node;
+      valueNode_ =
+          parent < 0 ? -1 : childFor(nodes_, parent, Node::KEY, keyHash_, keyLen_);
+      state_ = State::COLON;
+      break;
+    }
+    if (b == '\\') {
+      state_ = State::KEY_ESCAPE;
+      break;
+    }
+    keyHash_ = fnvUpdate(keyHash_, b);
+    ++keyLen_;
+    break;
+
+  case State::KEY_ESCAPE:
+    // An escape is matched by the escaped character, e.g. \" as "
+    keyHash_ = fnvUpdate(keyHash_, b);
+    ++keyLen_;
+    state_ = State::KEY;
+    break;
+
+  case State::COLON:
+    if (b == ':') {
+      state_ = State::VALUE;
+    } else if (!isSpace(b)) {
+      state_ = State::ERROR;
+    }
+    break;
+
+  case State::STRING:
+    if (b == '"') {
+      endScalar();
+      endValue();
+    } else if (b == '\\') {
+      state_ = State::STRING_ESCAPE;
+    } else if (textLen_ < sizeof(text_)) {
+      text_[textLen_++] = static_cast<char>(b);
+    }
+    break;
+
+  case State::STRING_ESCAPE:
+    state_ = State::STRING;
+    break;
+
+  case State::NUMBER:
+    if ((b >= '0' && b <= '9') || b == '.' || b == 'e' || b == 'E' ||
+        b == '+' || b == '-') {
+      if (textLen_ < sizeof(text_)) {
+        text_[textLen_++] = static_cast<char>(b);
+      }
+      break;
+    }
+    endScalar();
+    endValue();
+    return feed(b);
+
+  case State::LITERAL:
+    if (b >= 'a' && b <= 'z') {
+      if (textLen_ == 5) {
+        state_ = State::ERROR;
+      } else {
+        text_[textLen_++] = static_cast<char>(b);
+      }
+      break;
+    }
+    text_[textLen_] = '\0';
+    if (strcmp(text_, "true") != 0 && strcmp(text_, "false") != 0 &&
+        strcmp(text_, "null") != 0) {
+      state_ = State::ERROR;
+      break;
+    }
+    endScalar();
+    endValue();
+    return feed(b);
+
+  case State::AFTER_VALUE: {
+    Frame &top = stack_[depth_ - 1];
+    if (b == ',') {
+      if (top.array) {
+        ++top.index;
+        valueNode_ = elementNode(top);
+        state_ = State::VALUE;
+      } else {
+        state_ = State::KEY_START;
+      }
+    } else if (b == (top.array ? ']' : '}')) {
+      --depth_;
+      endValue();
+    } else if (!isSpace(b)) {
+      state_ = State::ERROR;
+    }
+    break;
+  }
+
+  case State::DONE:
+    if (!isSpace(b)) {
+      state_ = State::ERROR;
+    }
+    break;
+
+  case State::ERROR:
+    break;
+  }
+  return state_ != State::ERROR;
+}
@@ -0,0 +1,153 @@
+/*
+  -----------------------------------------------------------------------------
+  json_mapping.h — Configurable field mapping for energy JSON responses
+
+  Every cloud or meter API reports the same handful of values under its own
+  names.  Instead of hard-coded keys, the fetchers read them through a
+  mapping such as
+
+      battery=data.soc; generation=data.pv.today*0.001;
+      gen_curve=data.hours[*].pv; cons_curve=data.hours[*].load
+
+  Each entry assigns a target to a path.  Paths are object keys separated by
+  dots; ``[n]`` selects one array element and ``[*]`` every element, which
+  is what the two curve targets need (their values are stored by the index
+  of the innermost array).  An optional ``*factor`` scales the value, e.g.
+  from Wh to kWh.  Numbers given as strings are accepted as well.
+
+  The mapping is compiled once into a small trie of path segments.  The
+  response is then fed byte by byte through a JSON scanner that walks the
+  trie as keys and array elements go by: a key costs one hash update per
+  byte and one lookup among the children of the current node, and whole
+  subtrees that no path leads into are skipped by counting brackets.  No
+  document tree is built and nothing is allocated, so the response never
+  has to be held in RAM.
+
+  The code is plain C++ without Arduino dependencies so that mappings can
+  be tried on a host (see ``tools/json_map.cpp``).
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum class FieldTarget : uint8_t {
+  BATTERY,     // battery charge in %
+  GENERATION,  // energy generated today in kWh
+  CONSUMPTION, // energy consumed today in kWh
+  GEN_CURVE,   // hourly generation power in W
+  CONS_CURVE,  // hourly consumption power in W
+  COUNT
+};
+
+// The mapping used when none is configured: the flat format documented in
+// the README.
+extern const char *const DEFAULT_FIELD_MAP;
+
+class JsonFieldMap {
+public:
+  static constexpr size_t CURVE_POINTS = 24;
+  static constexpr size_t MAX_NODES = 32;
+  static constexpr size_t MAX_DEPTH = 16;
+
+  // Values extracted from one document.  Targets that were not found are
+  // NaN, and so are curve points the document did not contain.
+  struct Fields {
+    float battery;
+    float generation;
+    float consumption;
+    float gen[CURVE_POINTS];
+    float cons[CURVE_POINTS];
+    // Highest index seen + 1.  Counts elements beyond CURVE_POINTS too, so
+    // an over-long curve can be told apart from a complete one.
+    uint32_t genLength;
+    uint32_t consLength;
+  };
+
+  // Starts out with ``DEFAULT_FIELD_MAP``.
+  JsonFieldMap();
+
+  // Replace the mapping.  On a syntax error the previous mapping is kept
+  // and a message is written to ``err``.
+  bool compile(const char *text, char *err, size_t errCap);
+
+  // Start a new document.
+  void begin();
+
+  // Scan the next bytes of the document.  Returns false once the input
+  // is not valid JSON; further bytes are then ignored.
+  bool feed(const uint8_t *data, size_t len);
+  bool feed(uint8_t b);
+
+  // True once a complete top-level value has been scanned without error.
+  bool complete() const { return state_ == State::DONE; }
+
+  const Fields &fields() const { return fields_; }
+
+  // Name of a target as used in mappings.
+  static const char *targetName(FieldTarget target);
+
+private:
+  // A path segment: an object key (matched by hash and length), one array
+  // index or every array element.
+  struct Node {
+    enum Kind : uint8_t { ROOT, KEY, INDEX, ANY };
+    Kind kind;
+    uint8_t target;    // FieldTarget or NO_TARGET
+    int8_t firstChild; // -1 when none
+    int8_t next;       // next sibling
+    uint16_t keyLen;   // KEY
+    uint32_t key;      // KEY: FNV-1a hash, INDEX: element number
+    float scale;
+  };
+
+  struct Frame {
+    bool array;
+    int8_t node;    // node of the container, -1 outside every path
+    uint16_t index; // current element (arrays)
+  };
+
+  enum class State : uint8_t {
+    VALUE,        // expecting a value
+    VALUE_OR_END, // after '['
+    KEY_OR_END,   // after '{'
+    KEY_START,    // after ',' in an object
+    KEY,
+    KEY_ESCAPE,
+    COLON,
+    STRING,
+    STRING_ESCAPE,
+    NUMBER,
+    LITERAL,
+    AFTER_VALUE,
+    DONE,
+    ERROR
+  };
+
+  static constexpr uint8_t NO_TARGET = 0xff;
+
+  static int8_t childFor(const Node *nodes, int8_t node, Node::Kind kind,
+                         uint32_t key, uint16_t len);
+  static int8_t addChild(Node *nodes, uint8_t &count, int8_t node, const Node &seg);
+  int8_t elementNode(const Frame &array) const;
+  void beginValue(uint8_t b);
+  void endValue();
+  void endScalar();
+  void store(float value);
+  void push(bool array);
+
+  Node nodes_[MAX_NODES];
+  uint8_t nodeCount_;
+
+  State state_;
+  Frame stack_[MAX_DEPTH];
+  uint8_t depth_;
+  int8_t valueNode_;   // node of the value being scanned
+  uint32_t keyHash_;
+  uint16_t keyLen_;
+  char text_[24];       // number, string or literal of a mapped value
+  uint8_t textLen_;
+  Fields fields_;
+};
@@ -0,0 +1,144 @@
+#include "live_source.h"
+
+#include <time.h>
+
+// A reading older than this is considered stale (source unreachable).
+constexpr uint32_t LIVE_STALE_MS = 60UL * 1000UL;
+constexpr int HOURS_PER_DAY = 24;
+
+static SemaphoreHandle_t readingSem = nullptr;
+static portMUX_TYPE liveMux = portMUX_INITIALIZER_UNLOCKED;
+
+// State shared between the source tasks and the main loop; guarded by
+// ``liveMux``.
+static MeterReading latest = {NAN, NAN, NAN, 0};
+static uint32_t latestMillis = 0;
+static int dayOfYear = -1;
+static double dayImportWh = 0.0;
+static double dayExportWh = 0.0;
+static double hourImportWh[HOURS_PER_DAY];
+static double hourExportWh[HOURS_PER_DAY];
+
+/*
+ * Account the energy that flowed since the previous reading to the current
+ * day and hour.  Counter deltas are preferred; the instantaneous power is
+ * integrated only for sources that do not publish their registers.
+ * ``hour`` is -1 while the clock has not been synchronised.
+ */
+static void accumulate(const MeterReading &prev, const MeterReading &cur,
+                       uint32_t dtMs, int yday, int hour) {
+  double dImport = 0.0;
+  double dExport = 0.0;
+  bool haveImport = !isnan(cur.importWh) && !isnan(prev.importWh);
+  bool haveExport = !isnan(cur.exportWh) && !isnan(prev.exportWh);
+  if (haveImport || haveExport) {
+    if (haveImport) {
+      dImport = max(cur.importWh - prev.importWh, 0.0);
+    }
+    if (haveExport) {
+      dExport = max(cur.exportWh - prev.exportWh, 0.0);
+    }
+  } else if (!isnan(cur.powerW)) {
+    double wh = cur.powerW * (dtMs / 3600000.0);
+    dImport = max(wh, 0.0);
+    dExport = max(-wh, 0.0);
+  }
+
+  if (hour >= 0 && yday != dayOfYear) {
+    dayOfYear = yday;
+    dayImportWh = 0.0;
+    dayExportWh = 0.0;
+    memset(hourImportWh, 0, sizeof(hourImportWh));
+    memset(hourExportWh, 0, sizeof(hourExportWh));
+  }
+  dayImportWh += dImport;
+  dayExportWh += dExport;
+  if (hour >= 0) {
+    hourImportWh[hour] += dImport;
+    hourExportWh[hour] += dExport;
+  }
+}
+
+void beginLiveSource() {
+  if (!readingSem) {
+    readingSem = xSemaphoreCreateBinary();
+  }
+}
+
+void publishLiveReading(const MeterReading &reading) {
+  uint32_t now = millis();
+  time_t nowT = time(nullptr);
+  struct tm timeInfo;
+  int yday = -1;
+  int hour = -1;
+  if (nowT >= 100000 && gmtime_r(&nowT, &timeInfo)) {
+    yday = timeInfo.tm_yday;
+    hour = timeInfo.tm_hour;
+  }
+  portENTER_CRITICAL(&liveMux);
+  if (latest.sequence != 0) {
+    accumulate(latest, reading, now - latestMillis, yday, hour);
+  }
+  uint32_t seq = latest.sequence + 1;
+  latest = reading;
+  latest.sequence = seq;
+  latestMillis = now;
+  portEXIT_CRITICAL(&liveMux);
+  xSemaphoreGive(readingSem);
+}
+
+bool latestLiveReading(MeterReading &reading) {
+  portENTER_CRITICAL(&liveMux);
+  reading = latest;
+  portEXIT_CRITICAL(&liveMux);
+  return reading.sequence != 0;
+}
+
+bool waitForLiveReading(uint32_t timeoutMs) {
+  if (!readingSem) {
+    delay(timeoutMs);
+    return false;
+  }
+  return xSemaphoreTake(readingSem, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+}
+
+bool fetchLiveSourceData(float &batteryPercent, float &dailyGeneration,
+                         float &dailyConsumption,
+                         std::vector<float> &generationCurve,
+                         std::vector<float> &consumptionCurve) {
+  portENTER_CRITICAL(&liveMux);
+  bool fresh = latest.sequence != 0 && millis() - latestMillis < LIVE_STALE_MS;
+  double dayImport = dayImportWh;
+  double dayExport = dayExportWh;
+  double hourImport[HOURS_PER_DAY];
+  double hourExport[HOURS_PER_DAY];
+  memcpy(hourImport, hourImportWh, sizeof(hourImport));
+  memcpy(hourExport, hourExportWh, sizeof(hourExport));
+  portEXIT_CRITICAL(&liveMux);
+  if (!fresh) {
+    Serial.println("No recent reading from live source");
+    return false;
+  }
+
+  batteryPercent = NAN;
+  dailyGeneration = dayExport / 1000.0;
+  dailyConsumption = dayImport / 1000.0;
+
+  // Energy per hour in Wh equals the mean power in W.  The running hour is
+  // scaled by the fraction that has elapsed so far.
+  time_t nowT = time(nullptr);
+  struct tm timeInfo;
+  int curHour = HOURS_PER_DAY;
+  float elapsed = 1.0f;
+  if (nowT >= 100000 && gmtime_r(&nowT, &timeInfo)) {
+    curHour = timeInfo.tm_hour;
+    elapsed = max((timeInfo.tm_min * 60 + timeInfo.tm_sec) / 3600.0f, 1.0f / 60.0f);
+  }
+  size_t n = min<size_t>(generationCurve.size(), HOURS_PER_DAY);
+  for (size_t h = 0; h < n; ++h) {
+    float scale = (static_cast<int>(h) == curHour) ? 1.0f / elapsed : 1.0f;
+    generationCurve[h] = hourExport[h] * scale;
+    consumptionCurve[h] = hourImport[h] * scale;
+  }
+  return true;
+}
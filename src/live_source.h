@@ -0,0 +1,44 @@
+/*
+  -----------------------------------------------------------------------------
+  live_source.h — Shared pipeline for sources with instantaneous readings
+
+  Sources such as the optical meter head or a Shelly/Tasmota device deliver
+  a new reading every few hundred milliseconds instead of a finished daily
+  summary.  Each reading is published here from the source's own task; the
+  main loop is woken immediately to refresh the live power readout, and the
+  readings are integrated into the daily totals and hourly curves shown by
+  the regular display refresh.
+
+  Power is signed: positive values are drawn from the grid (consumption),
+  negative values are fed in (reported as generation).
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <vector>
+
+#include "meter_parsers.h"
+
+// Prepare the shared state.  Called by each source before its task starts.
+void beginLiveSource();
+
+// Publish a new reading.  Safe to call from any task.  The sequence number
+// of the stored reading is assigned here.
+void publishLiveReading(const MeterReading &reading);
+
+// Copy the most recent reading.  Returns false until the first reading has
+// been published.
+bool latestLiveReading(MeterReading &reading);
+
+// Block for at most ``timeoutMs`` or until a new reading is published.
+// Falls back to a plain delay when no live source has been started.
+bool waitForLiveReading(uint32_t timeoutMs);
+
+// Fill the display values from the accumulated readings.  Returns false if
+// no reading has been published recently.
+bool fetchLiveSourceData(float &batteryPercent, float &dailyGeneration,
+                         float &dailyConsumption,
+                         std::vector<float> &generationCurve,
+                         std::vector<float> &consumptionCurve);
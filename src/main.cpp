@@ -34,6 +34,15 @@
        configured in ``secrets.h``.  The smart-meter is expected to return
        JSON data with instantaneous and historical values.
 
+    3. Optical meter mode (``MODE_OPTICAL_METER``): an IR read head on a
+       spare UART receives SML or D0 telegrams directly from the meter.  The
+       telegrams are decoded as they arrive and the live power is shown
+       within milliseconds; no network is required.  See ``optical_meter.h``.
+
+    4. RPC meter mode (``MODE_RPC_METER``): a Shelly or Tasmota energy
+       meter on the LAN is polled several times per second over a
+       keep-alive connection.  See ``rpc_meter.h``.
+
   The code is thoroughly commented to explain each step.  To use this
   firmware you must install the following Arduino libraries:
     • ``TFT_eSPI`` by Bodmer — used for driving the ST7789 display.  In
@@ -43,7 +52,10 @@
       the cloud or smart-meter.
 
   Place your Wi-Fi and API credentials into ``src/secrets.h``.  The
-  ``secrets_example.h`` file is provided as a template.
+  ``secrets_example.h`` file is provided as a template.  These values are
+  factory defaults: every setting, including the operation mode, can be
+  changed at run time over the serial console or ``/api/config`` and is
+  then kept in NVS (see ``config_store.h``).
 
   -----------------------------------------------------------------------------
 */
@@ -57,12 +69,14 @@
 #include <FS.h>
 #include <SPI.h>
 #include <SD.h>
+#include <LittleFS.h>
 #include <PNGdec.h>
 
 // Optional touch support.  Define HAS_TOUCH to 1 and install a GT911 touch
 // library (e.g. https://github.com/alex-code/GT911) to enable on-screen
-// refresh via a capacitive touch button.  When HAS_TOUCH is 0 the button is
-// still drawn but no touch events are processed.
+// refresh via a capacitive touch button and pan/zoom gestures on the graph.
+// When HAS_TOUCH is 0 the button is still drawn but no touch events are
+// processed.
 #ifndef HAS_TOUCH
 #define HAS_TOUCH 0
 #endif
@@ -70,23 +84,57 @@
 #include <GT911.h>
 GT911 touch;
 #endif
+#include <new>
 #include <vector>
 #include <algorithm>
+#include <atomic>
 
 #include "secrets.h"
+#include "config_store.h"
+#include "console.h"
+#include "web_server.h"
+#include "alarms.h"
+#include "history.h"
+#include "range_api.h"
+#include "dashboard.h"
+#include "json_mapping.h"
+#include "content_hash.h"
+#include "endpoint_probe.h"
+#include "sd_card.h"
+#include "asset_pack.h"
+#include "glyph_cache.h"
+#include "derived_values.h"
+#include "fetch_schedule.h"
+#include "backfill.h"
+#include "overlay.h"
+#include "display_mirror.h"
+#include "profiling.h"
+#include "optical_meter.h"
+#include "rpc_meter.h"
+#include "influx_export.h"
 
 /*
  * Configuration constants.  Adjust these values to fine-tune the behaviour
  * of the display and data acquisition.
  */
-constexpr uint32_t REFRESH_INTERVAL_MS = 5UL * 60UL * 1000UL; // update every 5 minutes
-constexpr uint32_t RETRY_INTERVAL_MS = 3UL * 60UL * 1000UL;  // retry every 3 minutes on failure
 constexpr int POINTS_PER_DAY = 24;                            // number of samples per day (hourly)
+constexpr uint32_t LIVE_EXPORT_INTERVAL_MS = 10UL * 1000UL;    // export live power every 10 s
+constexpr uint32_t PREWARM_TIMEOUT_MS = 2000;
+// Refresh interval of the document source that is not shown.
+#ifndef STANDBY_REFRESH_MS
+#define STANDBY_REFRESH_MS (15UL * 60UL * 1000UL)
+#endif
+constexpr uint32_t DOUBLE_TAP_MS = 400;
 
 // Enumeration for operation mode.  Select MODE_ANKER_CLOUD to use the
 // Anker cloud API or MODE_LOCAL_SMARTMETER to fetch data from your local
-// smart-meter.  You can switch at run time by changing currentMode.
-enum class Mode { MODE_ANKER_CLOUD, MODE_LOCAL_SMARTMETER };
+// smart-meter.  The order matches the choices of the ``mode`` setting.
+enum class Mode {
+  MODE_ANKER_CLOUD,
+  MODE_LOCAL_SMARTMETER,
+  MODE_OPTICAL_METER,
+  MODE_RPC_METER
+};
 
 // Global objects
 TFT_eSPI tft = TFT_eSPI();
@@ -97,16 +145,35 @@ TFT_eSPI tft = TFT_eSPI();
 #ifndef TFT_BL
 #define TFT_BL 27
 #endif
-WiFiClient wifiClient;
-PNG png;
+
+// Boot-only resources.  The PNG decoder, its line buffer and the reader the
+// logo is streamed through are created for the boot logo and released by
+// releaseBootResources() once the splash has been shown; nothing after
+// setup() uses them.  The SD card itself stays mounted.
+PNG *png = nullptr;
+std::vector<uint16_t> logoLine;
+SdReader logoReader;
 constexpr const char *BOOT_LOGO_PATH = "/pictures/Boot Logo_GPT.png";
 const char *REQUIRED_SD_FILES[] = {BOOT_LOGO_PATH};
 constexpr size_t NUM_REQUIRED_SD_FILES =
     sizeof(REQUIRED_SD_FILES) / sizeof(REQUIRED_SD_FILES[0]);
 
-// Current operation mode; default to Anker cloud.  You may override this
-// value in setup() by reading from non-volatile storage or by using a
-// configuration button.
+// Image archive on the SD card, if there is one.  It stays open after boot
+// for the icons next to the values; read it with the display lock held.
+AssetPack assets;
+
+// Optional anti-aliased font for the values below the graph, uploaded to
+// LittleFS.  Without it the built-in font is used.
+#ifndef VALUE_FONT_PATH
+#define VALUE_FONT_PATH "/fonts/values.vlw"
+#endif
+CachedFont valueFont;
+
+// User-defined rows computed from the shown values (``derived`` setting).
+DerivedValues derivedValues;
+
+// Current operation mode; default to Anker cloud.  setup() replaces it with
+// the ``mode`` setting and applyConfigChanges() follows later changes.
 Mode currentMode = Mode::MODE_ANKER_CLOUD;
 
 // --- Layout configuration -------------------------------------------------
@@ -136,6 +203,21 @@ constexpr int valuesY = 150;
 // overlapping the refresh button.
 constexpr int valueLabelToValDist = 160;
 constexpr int rowHeight = 24;
+// Optional icons from the asset archive, in the gap between the values and
+// the live power readout.  Larger images are not drawn.
+constexpr int valueIconX = valuesX + valueLabelToValDist + 2;
+constexpr int valueIconSize = 16;
+
+// Live power readout to the right of the values block.  Only shown for
+// sources that deliver instantaneous power.
+constexpr int liveBoxX = 185;
+constexpr int liveBoxY = valuesY;
+constexpr int liveBoxW = 125;
+constexpr int liveBoxH = 2 * rowHeight - GAP;
+
+// User-defined rows in the same column, below the live power readout when
+// it is shown.  Rows that do not fit above the refresh button are skipped.
+constexpr int derivedRowH = 12;
 
 // Refresh button
 constexpr int refreshBtnW = 80;
@@ -148,42 +230,224 @@ constexpr int refreshTextOffsetY = -1;
 // Last update timestamp
 constexpr int updatedY = 220;
 
+// Maximum number of points drawn for a panned or zoomed graph window.  Three
+// pixels per point keep the curves smooth while bounding the cost of a
+// gesture frame.
+constexpr int graphColumns = graphW / 3;
+static_assert(graphColumns >= POINTS_PER_DAY, "graph must fit one day");
+
+// Crosshair tooltip
+constexpr int tooltipW = 100;
+constexpr int tooltipH = 24;
+
+// Alarm banner between the timestamp and the refresh button
+constexpr int bannerX = 112;
+constexpr int bannerY = updatedY - GAP;
+constexpr int bannerW = refreshBtnX - GAP - bannerX;
+constexpr int bannerH = 16;
+
 // Human readable timestamp of the last successful update.  It is
 // initialised with a placeholder and updated after each successful fetch.
 String lastUpdateStr = String("--:--:--");
 
-// Timestamp of the last connection attempt.  Exposed globally so that
-// setup() can schedule the next retry when Wi-Fi is unavailable.
-uint32_t lastUpdate = 0;
+// When the next fetch is due, with the refresh and retry intervals taken
+// from the runtime configuration.  Global so that setup() can schedule the
+// next retry when Wi-Fi is unavailable.
+FetchSchedule schedule;
+
+// Most recent instantaneous power from a live source (NaN if unknown) and
+// the sequence number of the reading it was taken from.
+float livePowerW = NAN;
+uint32_t lastLiveSequence = 0;
 
-// Current interval for refresh or retry; defaults to normal refresh interval.
-uint32_t currentInterval = REFRESH_INTERVAL_MS;
+// Time of the last live power sample queued for export.
+uint32_t lastLiveExport = 0;
 
-// Milliseconds when the next reconnect attempt should occur.  A value of
-// zero disables the on-screen countdown.
-uint32_t nextRetryTime = 0;
+// Values of the last successful fetch, republished to the web dashboard
+// whenever the live power or the alarms change.  Live readings update the
+// dashboard at most once per second.
+constexpr uint32_t DASHBOARD_LIVE_INTERVAL_MS = 1000;
+float shownBattery = NAN;
+float shownDailyGen = NAN;
+float shownDailyCons = NAN;
+std::vector<float> todayGen;
+std::vector<float> todayCons;
+uint32_t lastDashboardPublish = 0;
+
+// Session and last values of a document source.  The cloud and the smart
+// meter keep one each, so switching between them neither logs in nor waits
+// for a fetch: the values of the other source are refreshed every
+// ``STANDBY_REFRESH_MS`` by a background task and drawn right away on a
+// switch.
+struct SourceSession {
+  // Held by whoever fetches the source, loop() or the standby task, for
+  // the whole fetch; guards the fields up to ``reset``.
+  SemaphoreHandle_t busy = nullptr;
+  // Connection kept open between requests, by pre-warming or because the
+  // server allows keep-alive.  HTTPClient reuses whatever connection
+  // ``client`` holds, so ``target`` records the "host:port" it leads to
+  // and a request drops it if it goes elsewhere.
+  WiFiClient client;
+  String target;
+  String token;  // cloud login, reused until the cloud rejects it
+  // Hash of the last body, to tell when a fetch returns the same body again.
+  uint32_t bodyHash = 0;
+  bool bodyHashValid = false;
+  // The fetch in progress: the mapping it reads the body with, whether it
+  // went out over an open connection and whether the body was the last one.
+  JsonFieldMap *map = nullptr;
+  bool warm = false;
+  bool unchanged = false;
+  // Set when the settings of the source change; the next fetch then starts
+  // without connection, token and hash.
+  std::atomic<bool> reset{false};
+  // Set when the screen stops showing the last body; the next fetch then
+  // redraws even if the body is the same.
+  std::atomic<bool> bodyShown{true};
+  // Values of the last successful fetch, under ``snapshotMutex``.
+  bool valid = false;
+  uint32_t fetchedAt = 0;
+  String updated;
+  float battery = NAN;
+  float gen = NAN;
+  float cons = NAN;
+  std::vector<float> genCurve;
+  std::vector<float> consCurve;
+};
+SourceSession cloudSession;
+SourceSession meterSession;
+SemaphoreHandle_t snapshotMutex = nullptr;
+
+// Background refresh of the source that is not shown.  loop() keeps the
+// schedule and hands each fetch to ``standbyTask``.
+enum StandbyState : uint8_t { STANDBY_IDLE, STANDBY_RUNNING, STANDBY_OK, STANDBY_FAILED };
+FetchSchedule standbySchedule;
+TaskHandle_t standbyTaskHandle = nullptr;
+std::atomic<SourceSession *> standbyTarget(nullptr);
+std::atomic<uint8_t> standbyState(STANDBY_IDLE);
+
+// Duration of cloud and smart-meter fetches, over cold and warm
+// connections, to show what pre-warming saves.
+struct FetchTiming {
+  uint32_t count;
+  uint32_t totalMs;
+};
+FetchTiming fetchTimings[2];
+
+// Paths of the values in the cloud and smart-meter responses.  The
+// standby task compiles its own copy before each fetch.
+JsonFieldMap fieldMap;
+JsonFieldMap standbyMap;
+
+// Past values for panning and zooming the graph.
+EnergyHistory history;
+
+// Time window shown while the graph is panned or zoomed.  ``viewActive`` is
+// false while the graph shows today's curve from the last fetch.
+constexpr uint32_t VIEW_MIN_SPAN_S = 3UL * 3600UL;
+constexpr uint32_t VIEW_MAX_SPAN_S = EnergyHistory::HOUR_SLOTS * 3600UL;
+constexpr uint32_t VIEW_TIMEOUT_MS = 30UL * 1000UL;  // return to today after 30 s
+constexpr uint32_t GESTURE_FRAME_MS = 40;             // redraw at most 25 times per second
+bool viewActive = false;
+uint32_t viewFrom = 0;
+uint32_t viewTo = 0;
+uint32_t lastGesture = 0;
+
+// Samples currently shown in the graph, kept for the crosshair readout.
+float shownGen[graphColumns];
+float shownCons[graphColumns];
+int shownCount = 0;
+uint32_t shownFrom = 0;
+uint32_t shownTo = 0;
+float shownMax = 1.0f;
+
+// The crosshair is drawn on an overlay that holds the pixels under the
+// vertical line (5 px wide including the curve markers) and the tooltip.
+OverlayLayer overlay(tft, 5 * graphH + tooltipW * tooltipH);
+bool crosshairVisible = false;
+int crosshairIndex = 0;
+
+// Time of the last successful fetch and of the last data-age check for the
+// alarm rules.
+uint32_t lastDataTime = 0;
+uint32_t lastAlarmTick = 0;
 
 // Forward declarations for helper functions
+void loadScheduleConfig();
+void startSource();
+void connectWiFi();
+void applyConfigChanges();
 void updateTimestamp();
 void updateRetryCountdown();
 void showInfoScreen(const char *line1);
 bool initSDCard();
 bool hasRequiredSdFiles();
 void showBootLogo();
+void releaseBootResources();
+bool hasLivePower();
+void drawLivePower();
+void drawAlarmBanner();
+void feedAlarms(float batteryPercent, const std::vector<float> &genCurve);
+void queueExportSample(float batteryPercent, float dailyGeneration,
+                       float dailyConsumption);
+void updateDashboard();
+void loadFieldMap();
+void loadDerivedValues();
+void drawDerivedRows(float batteryPercent, float dailyGeneration,
+                     float dailyConsumption);
+void drawUpdated();
+String firstRequestUrl();
+void prewarmConnection();
+bool claimConnection(SourceSession &session, const String &url);
+void logFetchTime(uint32_t ms, bool warm);
+bool fetchDocument(SourceSession &session, JsonFieldMap &map, float &batteryPercent,
+                   float &dailyGeneration, float &dailyConsumption,
+                   std::vector<float> &generationCurve,
+                   std::vector<float> &consumptionCurve, bool &unchanged,
+                   bool &warm);
+SourceSession *sessionFor(Mode mode);
+SourceSession *standbySession();
+void storeSnapshot(SourceSession &session, float batteryPercent,
+                   float dailyGeneration, float dailyConsumption,
+                   const std::vector<float> &genCurve,
+                   const std::vector<float> &consCurve);
+bool claimSession(SourceSession &session, TickType_t wait);
+bool showSnapshot(SourceSession &session, uint32_t &fetchedAt);
+bool snapshotTime(SourceSession &session, uint32_t &fetchedAt);
+void invalidateSession(SourceSession &session);
+void beginStandby();
+void refreshStandby();
+void toggleSource();
+void formatTimestamp(String &out);
 
 // Forward declarations
-bool fetchAnkerData(float &batteryPercent, float &dailyGeneration,
-                    float &dailyConsumption,
+bool fetchAnkerData(SourceSession &session, float &batteryPercent,
+                    float &dailyGeneration, float &dailyConsumption,
                     std::vector<float> &generationCurve,
                     std::vector<float> &consumptionCurve);
-bool fetchSmartmeterData(float &batteryPercent, float &dailyGeneration,
-                         float &dailyConsumption,
+bool fetchSmartmeterData(SourceSession &session, float &batteryPercent,
+                         float &dailyGeneration, float &dailyConsumption,
                          std::vector<float> &generationCurve,
                          std::vector<float> &consumptionCurve);
+bool readMappedFields(HTTPClient &http, SourceSession &session, const char *source,
+                      float &batteryPercent, float &dailyGeneration,
+                      float &dailyConsumption, std::vector<float> &generationCurve,
+                      std::vector<float> &consumptionCurve);
 void drawGraph(const std::vector<float> &genData,
                const std::vector<float> &consData);
+void drawGraphSeries(const float *genData, const float *consData, int count,
+                     uint32_t from, uint32_t to,
+                     const EnergyHistory::Envelope *envelope = nullptr);
+void drawGraphWindow(uint32_t from, uint32_t to);
+void showCrosshair(int x);
+void hideCrosshair();
+void recordHistory(const std::vector<float> &genCurve,
+                   const std::vector<float> &consCurve);
+bool handleTouch();
 void drawNumbers(float batteryPercent, float dailyGeneration,
                  float dailyConsumption);
+void drawValueText(const char *text, int x, int y, uint8_t datum);
+void drawValueIcon(const char *name, int y);
 void showMessage(const char *msg);
 void showBootText(const char *line1, const char *line2 = nullptr);
 
@@ -196,6 +460,20 @@ void setup() {
   delay(100);
   Serial.println("Starting Setup");
 
+  // Load the runtime configuration before anything depends on it
+  beginConfig();
+  currentMode = static_cast<Mode>(configUInt(ConfigKey::Mode));
+  loadScheduleConfig();
+  loadFieldMap();
+  loadDerivedValues();
+  beginAlarms();
+  beginProfiling();
+  if (LittleFS.begin(true) && LittleFS.exists(VALUE_FONT_PATH)) {
+    valueFont.load(LittleFS, VALUE_FONT_PATH);
+  }
+  // Past days from the flash, before any other task reads the history
+  loadDayArchive(history);
+
   // Initialise the TFT display
   tft.init();
   tft.setRotation(1); // landscape orientation (320×240)
@@ -210,26 +488,52 @@ void setup() {
   digitalWrite(TFT_BL, HIGH);
   ledcSetup(0, 2000, 8);
   ledcAttachPin(TFT_BL, 0);
-  ledcWrite(0, 255); // full brightness
+  ledcWrite(0, configUInt(ConfigKey::Brightness));
 #endif
 
   // Attempt to show boot logo from SD card
-  if (initSDCard() && hasRequiredSdFiles()) {
+  bool sdCard = initSDCard();
+  if (sdCard && SD.exists(ASSET_PACK_PATH)) {
+    assets.open(ASSET_PACK_PATH);
+  }
+  if (sdCard && hasRequiredSdFiles()) {
+#if SD_SPEED_PROBE
+    probeSdSpeed();
+#endif
     showBootLogo();
     delay(2000);
   } else {
     showBootText("Starting...");
     delay(1000);
   }
+  releaseBootResources();
+
+  // The optical meter does not depend on Wi-Fi; start reading telegrams
+  // right away so the first values are ready when the screen is drawn.
+  if (currentMode == Mode::MODE_OPTICAL_METER) {
+    startSource();
+  }
 
   // Display splash screen
   tft.fillScreen(TFT_BLACK);
   tft.drawString("Anker Solix Monitor", tft.width() / 2, tft.height() / 2 - 20);
   tft.drawString("Connecting to WiFi ...", tft.width() / 2, tft.height() / 2 + 10);
 
-  // Connect to Wi-Fi
+  // Connect to Wi-Fi.  The web server can listen as soon as the network
+  // stack is up, so the configuration stays reachable even while the
+  // station is still associating.
   WiFi.mode(WIFI_STA);
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  connectWiFi();
+  registerConfigRoutes(webServer());
+  registerRangeRoute(webServer(), history);
+  registerDashboardRoutes(webServer());
+  registerEndpointRoutes(webServer());
+  beginDisplayMirror(tft, webServer());
+  beginWebServer();
+  beginBackfill();
+  beginStandby();
+  // From here on the mirror may read the panel from another task, so all
+  // drawing is done with the display lock held
   uint8_t attempt = 0;
   while (WiFi.status() != WL_CONNECTED && attempt < 20) {
     delay(500);
@@ -238,17 +542,21 @@ void setup() {
   }
   if (WiFi.status() != WL_CONNECTED) {
     // Schedule next retry and present informative screen with countdown
-    lastUpdate = millis();
-    currentInterval = RETRY_INTERVAL_MS;
-    nextRetryTime = lastUpdate + RETRY_INTERVAL_MS;
+    schedule.begin(millis());
+    schedule.failed();
+    lockDisplay();
     showInfoScreen("WiFi connection failed");
+    unlockDisplay();
     return;
   }
-  Serial.println("\nConnected to WiFi: '" WIFI_SSID "'");
+  String connectedMsg = "Connected to WiFi: '" + configString(ConfigKey::WifiSsid) + "'";
+  Serial.println("\n" + connectedMsg);
   
   // tft.fillScreen(TFT_BLACK);
-  // showMessage("Connected to WiFi: '" WIFI_SSID "'");
-  tft.drawString("Connected to WiFi: '" WIFI_SSID "'", tft.width() / 2, tft.height() / 2 + 10);
+  // showMessage(connectedMsg.c_str());
+  lockDisplay();
+  tft.drawString(connectedMsg, tft.width() / 2, tft.height() / 2 + 10);
+  unlockDisplay();
   delay(10000);
 
   // Configure SNTP to obtain the current time.  This is used to display
@@ -267,6 +575,11 @@ void setup() {
     ++waitCount;
   }
 
+  if (currentMode == Mode::MODE_RPC_METER || currentMode == Mode::MODE_ANKER_CLOUD) {
+    startSource();
+  }
+  beginInfluxExport();
+
 #if HAS_TOUCH
   // Initialise the GT911 capacitive touch controller.  The driver uses the
   // default I2C bus and will configure the INT and RST pins if available on
@@ -282,64 +595,301 @@ void setup() {
  * refresh timer prevents unnecessary network traffic.
  */
 void loop() {
+  // The display lock is only held while drawing, never across network
+  // requests, so the mirror can read the panel during a fetch
+  pollConsole();
+  applyConfigChanges();
   uint32_t now = millis();
-  bool forceRefresh = false;
-#if HAS_TOUCH
-  // Poll the touch controller; if a touch occurs within the refresh
-  // button area we schedule an immediate refresh
-  uint8_t touches = touch.touched(GT911_MODE_POLLING);
-  if (touches) {
-    GTPoint *points = touch.getPoints();
-    for (uint8_t i = 0; i < touches; ++i) {
-      // Convert portrait coordinates (x,y) to our landscape orientation
-      int16_t px = points[i].y;
-      int16_t py = 320 - points[i].x;
-      if (px >= refreshBtnX && px <= refreshBtnX + refreshBtnW &&
-          py >= refreshBtnY && py <= refreshBtnY + refreshBtnH) {
-        forceRefresh = true;
-        break;
-      }
-    }
+  // Touches on the refresh button schedule an immediate refresh; gestures
+  // on the graph are handled completely inside handleTouch()
+  bool forceRefresh = handleTouch();
+  if (schedule.prewarmDue(now)) {
+    prewarmConnection();
   }
-#endif
-  if (now - lastUpdate >= currentInterval || lastUpdate == 0 || forceRefresh) {
-    lastUpdate = now;
+  if (schedule.due(now) || forceRefresh) {
+    schedule.begin(now);
     float batteryPercent = NAN;
     float dailyGen = NAN;
     float dailyCons = NAN;
     std::vector<float> genCurve(POINTS_PER_DAY, 0.0f);
     std::vector<float> consCurve(POINTS_PER_DAY, 0.0f);
     bool ok = false;
-    if (WiFi.status() == WL_CONNECTED) {
-      if (currentMode == Mode::MODE_ANKER_CLOUD) {
-        ok = fetchAnkerData(batteryPercent, dailyGen, dailyCons, genCurve, consCurve);
+    // Same body as last time: the screen is still correct apart from the
+    // timestamp
+    bool unchanged = false;
+    bool warm = false;
+    SourceSession *session = sessionFor(currentMode);
+    if (currentMode == Mode::MODE_OPTICAL_METER) {
+      ok = fetchLiveSourceData(batteryPercent, dailyGen, dailyCons, genCurve, consCurve);
+    } else if (WiFi.status() == WL_CONNECTED) {
+      if (session) {
+        ok = fetchDocument(*session, fieldMap, batteryPercent, dailyGen, dailyCons,
+                           genCurve, consCurve, unchanged, warm);
+        if (ok) {
+          logFetchTime(millis() - now, warm);
+        }
       } else {
-        ok = fetchSmartmeterData(batteryPercent, dailyGen, dailyCons, genCurve, consCurve);
+        ok = fetchLiveSourceData(batteryPercent, dailyGen, dailyCons, genCurve, consCurve);
       }
     }
-    if (ok) {
+    if (ok && unchanged) {
+      updateTimestamp();
+      lastDataTime = now;
+      if (session) {
+        xSemaphoreTake(snapshotMutex, portMAX_DELAY);
+        session->fetchedAt = now;
+        session->updated = lastUpdateStr;
+        xSemaphoreGive(snapshotMutex);
+      }
+      alarmSample(AlarmMetric::AGE, 0.0f);
+      lockDisplay();
+      drawUpdated();
+      unlockDisplay();
+      queueExportSample(shownBattery, shownDailyGen, shownDailyCons);
+      updateDashboard();
+      schedule.succeeded();
+    } else if (ok) {
       // Update timestamp of last successful fetch
       updateTimestamp();
-      // Redraw the entire screen
+      lastDataTime = now;
+      feedAlarms(batteryPercent, genCurve);
+      recordHistory(genCurve, consCurve);
+      if (session) {
+        storeSnapshot(*session, batteryPercent, dailyGen, dailyCons, genCurve,
+                      consCurve);
+      }
+      // Redraw the entire screen, keeping a panned or zoomed window
+      lockDisplay();
       tft.fillScreen(TFT_BLACK);
-      drawGraph(genCurve, consCurve);
+      markDisplayDirty(0, 0, tft.width(), tft.height());
+      if (viewActive) {
+        drawGraphWindow(viewFrom, viewTo);
+      } else {
+        drawGraph(genCurve, consCurve);
+      }
+      shownBattery = batteryPercent;
+      shownDailyGen = dailyGen;
+      shownDailyCons = dailyCons;
+      todayGen.swap(genCurve);
+      todayCons.swap(consCurve);
       drawNumbers(batteryPercent, dailyGen, dailyCons);
-      currentInterval = REFRESH_INTERVAL_MS;
-      nextRetryTime = 0; // hide countdown after successful update
+      unlockDisplay();
+      queueExportSample(batteryPercent, dailyGen, dailyCons);
+      updateDashboard();
+      if (schedule.retryAt() != 0) {
+        // Back after an outage: fetch the days that were missed
+        wakeBackfill();
+      }
+      schedule.succeeded();  // also hides the retry countdown
     } else {
-      currentInterval = RETRY_INTERVAL_MS;
-      nextRetryTime = now + RETRY_INTERVAL_MS;
-      if (WiFi.status() != WL_CONNECTED) {
+      schedule.failed();
+      // The error screen replaces the values, so the same body must be
+      // drawn again once a fetch succeeds
+      if (session) {
+        session->bodyShown.store(false);
+      }
+      lockDisplay();
+      if (WiFi.status() != WL_CONNECTED && currentMode != Mode::MODE_OPTICAL_METER) {
         showInfoScreen("WiFi connection failed");
       } else {
         showInfoScreen("Data fetch error");
       }
+      unlockDisplay();
     }
   } else {
+    lockDisplay();
     updateRetryCountdown();
+    unlockDisplay();
+    refreshStandby();
+  }
+  // Show each new live reading as soon as it has been published
+  MeterReading reading;
+  if (hasLivePower() && latestLiveReading(reading) &&
+      reading.sequence != lastLiveSequence) {
+    lastLiveSequence = reading.sequence;
+    livePowerW = reading.powerW;
+    lockDisplay();
+    drawLivePower();
+    if (derivedValues.uses() & DERIVED_POWER) {
+      drawDerivedRows(shownBattery, shownDailyGen, shownDailyCons);
+    }
+    unlockDisplay();
+    time_t nowT = time(nullptr);
+    if (nowT > 100000) {
+      lockHistory();
+      history.recordPower(nowT, livePowerW);
+      unlockHistory();
+    }
+    if (alarmSample(AlarmMetric::POWER, livePowerW)) {
+      lockDisplay();
+      drawAlarmBanner();
+      unlockDisplay();
+      updateDashboard();
+    } else if (millis() - lastDashboardPublish >= DASHBOARD_LIVE_INTERVAL_MS) {
+      updateDashboard();
+    }
+    if (millis() - lastLiveExport >= LIVE_EXPORT_INTERVAL_MS) {
+      lastLiveExport = millis();
+      queueExportSample(NAN, NAN, NAN);
+    }
+  }
+  // Data age only changes with time, so it is checked once per second
+  if (millis() - lastAlarmTick >= 1000) {
+    lastAlarmTick = millis();
+    if (alarmSample(AlarmMetric::AGE, (lastAlarmTick - lastDataTime) / 1000.0f)) {
+      lockDisplay();
+      drawAlarmBanner();
+      unlockDisplay();
+      updateDashboard();
+    }
+  }
+  // Allow the CPU to rest between refreshes.  A live reading wakes the
+  // loop early so the live readout is not delayed by the idle period.
+  // While a gesture is in progress the touch controller is polled quickly
+  // to keep the graph responsive.
+  bool gesturing = viewActive && millis() - lastGesture < 500;
+  waitForLiveReading(gesturing ? 5 : 100);
+}
+
+void loadScheduleConfig() {
+  schedule.configure(configUInt(ConfigKey::RefreshS) * 1000UL,
+                     configUInt(ConfigKey::RetryS) * 1000UL);
+  standbySchedule.configure(STANDBY_REFRESH_MS, STANDBY_REFRESH_MS);
+}
+
+// Start the background task of the current mode, if it has one.
+void startSource() {
+  if (currentMode == Mode::MODE_OPTICAL_METER) {
+    beginOpticalMeter();
+  } else if (currentMode == Mode::MODE_RPC_METER) {
+    beginRpcMeter();
+  } else if (currentMode == Mode::MODE_ANKER_CLOUD) {
+    beginEndpointProbe();
+  }
+}
+
+void connectWiFi() {
+  WiFi.begin(configString(ConfigKey::WifiSsid).c_str(),
+             configString(ConfigKey::WifiPassword).c_str());
+}
+
+/*
+ * Re-apply the parts of the configuration that changed since the last
+ * call.  Only the affected subsystem is touched: a new brightness is a
+ * single PWM write, a new meter host restarts only that meter's task, and
+ * the screen is redrawn only when the data source itself changed.
+ */
+void applyConfigChanges() {
+  uint32_t changed = takeConfigChanges();
+  if (changed == 0) {
+    return;
+  }
+  if (changed & CFG_GROUP_DISPLAY) {
+#ifdef TFT_BL
+    ledcWrite(0, configUInt(ConfigKey::Brightness));
+#endif
+    // The number of rows decides the layout of the whole right column
+    loadDerivedValues();
+    lockDisplay();
+    tft.fillRect(liveBoxX, valuesY, liveBoxW, refreshBtnY - GAP - valuesY,
+                 TFT_BLACK);
+    markDisplayDirty(liveBoxX, valuesY, liveBoxW, refreshBtnY - GAP - valuesY);
+    if (hasLivePower()) {
+      drawLivePower();
+    }
+    drawDerivedRows(shownBattery, shownDailyGen, shownDailyCons);
+    unlockDisplay();
+  }
+  if (changed & CFG_GROUP_SCHEDULE) {
+    loadScheduleConfig();
+  }
+  if (changed & CFG_GROUP_WIFI) {
+    Serial.println("Wi-Fi settings changed, reconnecting");
+    WiFi.disconnect();
+    connectWiFi();
+  }
+  if (changed & CFG_GROUP_EXPORT) {
+    beginInfluxExport();
+  }
+  if (changed & CFG_GROUP_BACKFILL) {
+    beginBackfill();
+  }
+  if (changed & CFG_GROUP_ALARM) {
+    reloadAlarms();
+    lockDisplay();
+    drawAlarmBanner();
+    unlockDisplay();
+  }
+  if (changed & (CFG_GROUP_ANKER | CFG_GROUP_SMARTMETER)) {
+    loadFieldMap();
+  }
+  // New credentials, endpoints or mapping: the session and the values kept
+  // for a switch belong to the old ones
+  if (changed & CFG_GROUP_ANKER) {
+    invalidateSession(cloudSession);
+  }
+  if (changed & CFG_GROUP_SMARTMETER) {
+    invalidateSession(meterSession);
+  }
+  bool refresh = false;
+  if (changed & CFG_GROUP_MODE) {
+    Mode mode = static_cast<Mode>(configUInt(ConfigKey::Mode));
+    if (mode != currentMode) {
+      if (currentMode == Mode::MODE_OPTICAL_METER) {
+        stopOpticalMeter();
+      } else if (currentMode == Mode::MODE_RPC_METER) {
+        stopRpcMeter();
+      } else if (currentMode == Mode::MODE_ANKER_CLOUD) {
+        stopEndpointProbe();
+      }
+      SourceSession *previous = sessionFor(currentMode);
+      currentMode = mode;
+      livePowerW = NAN;
+      startSource();
+      // Between the cloud and the meter the other source's values are at
+      // hand: show them now and fetch when they are due
+      SourceSession *next = sessionFor(mode);
+      uint32_t fetchedAt;
+      lockDisplay();
+      bool shown = next && showSnapshot(*next, fetchedAt);
+      unlockDisplay();
+      if (shown) {
+        schedule.begin(fetchedAt);
+        schedule.succeeded();
+        Serial.printf("Switched to %s, values from %lu s ago\n",
+                      configText(ConfigKey::Mode, false).c_str(),
+                      static_cast<unsigned long>((millis() - fetchedAt) / 1000));
+      } else {
+        refresh = true;
+      }
+      if (previous && snapshotTime(*previous, fetchedAt)) {
+        standbySchedule.begin(fetchedAt);
+        standbySchedule.succeeded();
+      }
+    }
+  }
+  // A standby source without values is fetched as soon as possible
+  SourceSession *standby = standbySession();
+  uint32_t standbyAt;
+  if (standby && !snapshotTime(*standby, standbyAt)) {
+    standbySchedule.reset();
+  }
+  // Settings of the active source: reconnect or refetch right away.
+  // Settings of inactive sources are simply picked up when they are next
+  // used.
+  if (currentMode == Mode::MODE_RPC_METER && (changed & CFG_GROUP_RPC)) {
+    restartRpcMeter();
+    refresh = true;
+  } else if (currentMode == Mode::MODE_ANKER_CLOUD && (changed & CFG_GROUP_ANKER)) {
+    restartEndpointProbe();
+    refresh = true;
+  } else if (currentMode == Mode::MODE_LOCAL_SMARTMETER &&
+             (changed & CFG_GROUP_SMARTMETER)) {
+    refresh = true;
+  }
+  if (refresh) {
+    schedule.reset();
   }
-  // Allow the CPU to rest between refreshes
-  delay(100);
 }
 
 /*
@@ -348,6 +898,7 @@ void loop() {
  */
 void showMessage(const char *msg) {
   tft.fillScreen(TFT_BLACK);
+  markDisplayDirty(0, 0, tft.width(), tft.height());
   tft.setTextDatum(MC_DATUM);
   tft.setTextColor(TFT_WHITE, TFT_BLACK);
   tft.drawString(msg, tft.width() / 2, tft.height() / 2);
@@ -360,6 +911,7 @@ void showMessage(const char *msg) {
 void showInfoScreen(const char *line1) {
   std::vector<float> empty(POINTS_PER_DAY, 0.0f);
   tft.fillScreen(TFT_BLACK);
+  markDisplayDirty(0, 0, tft.width(), tft.height());
   drawGraph(empty, empty);
   drawNumbers(NAN, NAN, NAN);
   tft.setTextDatum(TC_DATUM);
@@ -375,17 +927,21 @@ void showInfoScreen(const char *line1) {
  * attempt will be made.
  */
 void updateRetryCountdown() {
-  if (nextRetryTime == 0) {
+  uint32_t retryAt = schedule.retryAt();
+  if (retryAt == 0) {
     return;
   }
-  uint32_t now = millis();
-  uint32_t remaining = (nextRetryTime > now) ? nextRetryTime - now : 0;
+  int32_t left = static_cast<int32_t>(retryAt - millis());
+  uint32_t remaining = left > 0 ? left : 0;
   char buf[24];
   sprintf(buf, "Retry in %02u:%02u", remaining / 60000, (remaining / 1000) % 60);
   tft.setTextDatum(TC_DATUM);
   tft.setTextColor(TFT_YELLOW, TFT_BLACK);
   tft.setTextSize(1);
-  tft.drawString(buf, tft.width() / 2, tft.fontHeight(2) + GAP * 2);
+  // Below the message line, which showInfoScreen() draws at text size 2
+  int y = 2 * tft.fontHeight(1) + GAP * 2;
+  tft.drawString(buf, tft.width() / 2, y);
+  markDisplayDirty(0, y, tft.width(), tft.fontHeight(1));
 }
 
 /*
@@ -394,6 +950,7 @@ void updateRetryCountdown() {
  */
 void showBootText(const char *line1, const char *line2) {
   tft.fillScreen(TFT_BLACK);
+  markDisplayDirty(0, 0, tft.width(), tft.height());
   tft.setTextDatum(MC_DATUM);
   tft.setTextColor(TFT_WHITE, TFT_BLACK);
   int centerY = tft.height() / 2;
@@ -405,22 +962,25 @@ void showBootText(const char *line1, const char *line2) {
   }
 }
 
-// Initialise the SD card and check that it is present.
+// Initialise the SD card and check that it is present.  Unless the display
+// has a bus of its own, the card shares the display's SPI object so both
+// drivers serialise on the same bus lock.  The card stays mounted; after
+// setup() it is read only with the display lock held, so a card transfer
+// never starts in the middle of a drawing sequence of another task.
 bool initSDCard() {
-  if (!SD.begin()) {
-    Serial.println("SD init failed");
-    return false;
-  }
-  if (SD.cardType() == CARD_NONE) {
-    Serial.println("No SD card attached");
-    return false;
-  }
-  Serial.println("SD card detected");
-  return true;
+#ifdef USE_HSPI_PORT
+  return mountSdCard(SPI);
+#else
+  return mountSdCard(tft.getSPIinstance());
+#endif
 }
 
 // Verify that all required repository files exist on the SD card.
 bool hasRequiredSdFiles() {
+  // The asset archive carries its own copy of the images
+  if (assets.isOpen()) {
+    return true;
+  }
   for (size_t i = 0; i < NUM_REQUIRED_SD_FILES; ++i) {
     if (!SD.exists(REQUIRED_SD_FILES[i])) {
       Serial.printf("Missing SD file: %s\n", REQUIRED_SD_FILES[i]);
@@ -432,52 +992,115 @@ bool hasRequiredSdFiles() {
 
 // Callback used by the PNG decoder to draw each line on the TFT.
 int pngDraw(PNGDRAW *pDraw) {
-  static std::vector<uint16_t> lineBuffer;
-  size_t requiredWidth = std::max<int>(png.getWidth(), tft.width());
-  if (lineBuffer.size() < requiredWidth) {
-    lineBuffer.resize(requiredWidth);
+  PROFILE_SCOPE("pngDraw");
+  size_t requiredWidth = std::max<int>(png->getWidth(), tft.width());
+  if (logoLine.size() < requiredWidth) {
+    logoLine.resize(requiredWidth);
   }
-  png.getLineAsRGB565(pDraw, lineBuffer.data(), PNG_RGB565_BIG_ENDIAN,
+  png->getLineAsRGB565(pDraw, logoLine.data(), PNG_RGB565_BIG_ENDIAN,
                        0xFFFFFFFF);
-  int16_t x = (tft.width() - png.getWidth()) / 2;
-  tft.pushImage(x, pDraw->y, png.getWidth(), 1, lineBuffer.data());
+  int16_t x = (tft.width() - png->getWidth()) / 2;
+  tft.pushImage(x, pDraw->y, png->getWidth(), 1, logoLine.data());
   return 1;  // Continue decoding
 }
 
-// Show the boot logo loaded from the SD card.
+// File callbacks that let the PNG decoder stream the logo through
+// ``logoReader`` instead of loading the whole file into RAM.
+void *pngOpen(const char *path, int32_t *size) {
+  if (!logoReader.open(path)) {
+    return nullptr;
+  }
+  *size = static_cast<int32_t>(logoReader.size());
+  return &logoReader;
+}
+
+void pngClose(void *handle) { static_cast<SdReader *>(handle)->close(); }
+
+int32_t pngRead(PNGFILE *file, uint8_t *buf, int32_t len) {
+  SdReader *reader = static_cast<SdReader *>(file->fHandle);
+  int32_t got = static_cast<int32_t>(reader->read(buf, len));
+  file->iPos = static_cast<int32_t>(reader->position());
+  return got;
+}
+
+int32_t pngSeek(PNGFILE *file, int32_t pos) {
+  SdReader *reader = static_cast<SdReader *>(file->fHandle);
+  if (!reader->seek(pos)) {
+    return -1;
+  }
+  file->iPos = pos;
+  return pos;
+}
+
+// Show the boot logo from the SD card: pre-converted from the asset
+// archive if it has one, otherwise decoded from the PNG.
 void showBootLogo() {
-  File f = SD.open(BOOT_LOGO_PATH);
-  if (!f) {
-    Serial.println("Boot logo not found");
+  int logo = assets.find("boot_logo");
+  if (logo >= 0) {
+    tft.fillScreen(TFT_BLACK);
+    if (!assets.draw(tft, logo, (tft.width() - assets.width(logo)) / 2,
+                     (tft.height() - assets.height(logo)) / 2)) {
+      Serial.println("Failed to read boot logo");
+    }
     return;
   }
 
-  size_t size = f.size();
-  std::vector<uint8_t> buffer(size);
-  if (f.read(buffer.data(), size) != size) {
-    Serial.println("Failed to read boot logo");
-    f.close();
+  png = new (std::nothrow) PNG;
+  if (!png) {
+    Serial.println("Not enough memory for boot logo decoder");
     return;
   }
-  f.close();
-
-  int16_t rc = png.openRAM(buffer.data(), size, pngDraw);
+  int16_t rc = png->open(BOOT_LOGO_PATH, pngOpen, pngClose, pngRead, pngSeek,
+                         pngDraw);
   if (rc == PNG_SUCCESS) {
     tft.fillScreen(TFT_BLACK);
-    png.decode(nullptr, 0);
+    png->decode(nullptr, 0);
   } else {
     Serial.printf("PNG decode error: %d\n", rc);
   }
-  png.close();
+  png->close();
+}
+
+/*
+ * Tear down everything that is only needed for the boot screen: the PNG
+ * decoder state, the decoder's line buffer and the logo reader.  The SD
+ * card stays mounted for later reads.  The reclaimed heap is logged.
+ */
+void releaseBootResources() {
+  uint32_t before = ESP.getFreeHeap();
+  delete png;
+  png = nullptr;
+  std::vector<uint16_t>().swap(logoLine);
+  logoReader.close();
+  uint32_t after = ESP.getFreeHeap();
+  Serial.printf("Boot resources released: %u bytes reclaimed, %u bytes free\n",
+                static_cast<unsigned>(after - before),
+                static_cast<unsigned>(after));
 }
 
 /*
  * Draw the daily generation and consumption curves on the screen.  The
- * function scales the values to fit within the graph area and draws axes
- * and legends.  The time axis spans 24 hours with one sample per hour.
+ * time axis spans 24 hours with one sample per hour.
  */
 void drawGraph(const std::vector<float> &genData,
                const std::vector<float> &consData) {
+  drawGraphSeries(genData.data(), consData.data(), POINTS_PER_DAY, 0,
+                  24UL * 3600UL);
+}
+
+/*
+ * Draw ``count`` evenly spaced samples covering the time window
+ * [from, to).  The function scales the values to fit within the graph area
+ * and draws axes, time labels for the window and the legend.  NaN samples
+ * leave a gap in the curve.  If ``envelope`` is given, the range of the
+ * values behind each sample is shaded underneath the curves, so short peaks
+ * stay visible when a wide window is averaged.  Only the graph area and its
+ * label strip are repainted, so the function can be called for every
+ * gesture frame.
+ */
+void drawGraphSeries(const float *genData, const float *consData, int count,
+                     uint32_t from, uint32_t to,
+                     const EnergyHistory::Envelope *envelope) {
   // Use precomputed layout values
   const int x0 = graphX;
   const int y0 = graphY;
@@ -486,31 +1109,77 @@ void drawGraph(const std::vector<float> &genData,
   const uint16_t colourGen = TFT_YELLOW;
   const uint16_t colourCons = TFT_RED;
 
-  // Draw background for graph
+  // The crosshair belongs to the previous contents
+  overlay.discard();
+  crosshairVisible = false;
+
+  // Draw background for graph and clear the time labels
   tft.fillRect(x0 - 2, y0 - 2, graphWidth + 4, graphHeight + 4, TFT_DARKGREY);
   tft.fillRect(x0, y0, graphWidth, graphHeight, TFT_BLACK);
+  tft.fillRect(x0 - 8, y0 + graphHeight + 2, graphWidth + 16, 10, TFT_BLACK);
+  // The y labels left of the graph are redrawn as well
+  markDisplayDirty(0, y0 - 6, tft.width(), graphHeight + 20);
 
   // Determine max value for scaling (avoid division by zero)
   float maxVal = 0.0f;
-  for (size_t i = 0; i < genData.size(); ++i) {
-    maxVal = max(maxVal, genData[i]);
-    maxVal = max(maxVal, consData[i]);
+  for (int i = 0; i < count; ++i) {
+    if (!isnan(genData[i])) {
+      maxVal = max(maxVal, genData[i]);
+    }
+    if (!isnan(consData[i])) {
+      maxVal = max(maxVal, consData[i]);
+    }
+    if (envelope && !isnan(envelope[i].genMax)) {
+      maxVal = max(maxVal, max(envelope[i].genMax, envelope[i].consMax));
+    }
   }
   if (maxVal < 1.0f) {
     maxVal = 1.0f;
   }
+  shownCount = std::min(count, graphColumns);
+  memcpy(shownGen, genData, shownCount * sizeof(float));
+  memcpy(shownCons, consData, shownCount * sizeof(float));
+  shownFrom = from;
+  shownTo = to;
+  shownMax = maxVal;
 
   // Draw axes
   tft.drawRect(x0, y0, graphWidth, graphHeight, TFT_LIGHTGREY);
-  // Draw vertical grid lines and time labels every 6 hours
-  for (int i = 0; i <= 24; i += 6) {
-    int x = x0 + (graphWidth * i) / (POINTS_PER_DAY);  // removed -1 to align graph
+  // Draw vertical grid lines and time labels.  The spacing is the
+  // smallest step that gives at most six labels across the window; hours
+  // are labelled for steps below a day, dates (day.month) otherwise.
+  static const uint32_t TICK_STEPS[] = {3600,  7200,   10800,  21600, 43200,
+                                        86400, 172800, 345600, 604800};
+  const uint32_t span = to - from;
+  uint32_t step = TICK_STEPS[0];
+  for (uint32_t s : TICK_STEPS) {
+    step = s;
+    if (span / s <= 6) {
+      break;
+    }
+  }
+  tft.setTextDatum(TC_DATUM);
+  tft.setTextColor(TFT_WHITE, TFT_BLACK);
+  for (uint32_t t = (from + step - 1) / step * step; t <= to; t += step) {
+    int x = x0 + static_cast<int>(static_cast<uint64_t>(t - from) * graphWidth / span);
     tft.drawLine(x, y0, x, y0 + graphHeight, TFT_DARKGREY);
-    tft.setTextColor(TFT_WHITE, TFT_BLACK);
-    char label[4];
-    sprintf(label, "%02d", i);
+    char label[8];
+    if (step < 86400) {
+      uint32_t hour = (t / 3600) % 24;
+      // The end of a day is labelled 24 rather than 00
+      if (hour == 0 && t == to && t != from) {
+        hour = 24;
+      }
+      sprintf(label, "%02u", static_cast<unsigned>(hour));
+    } else {
+      time_t tt = t;
+      struct tm tmDay;
+      gmtime_r(&tt, &tmDay);
+      sprintf(label, "%02d.%02d", tmDay.tm_mday, tmDay.tm_mon + 1);
+    }
     tft.drawString(label, x, y0 + graphHeight + 2);
   }
+  tft.setTextDatum(TL_DATUM);
   // Draw horizontal grid lines at 0%, 25%, 50%, 75%, 100%
   for (int i = 0; i <= 4; ++i) {
     int y = y0 + graphHeight - (graphHeight * i) / 4;
@@ -522,18 +1191,43 @@ void drawGraph(const std::vector<float> &genData,
     tft.drawString(label, x0 - 30, y - 5);
   }
   // Draw generation and consumption curves
-  int prevX = x0;
-  int prevYGen = y0 + graphHeight - (genData[0] / maxVal) * graphHeight;
-  int prevYCons = y0 + graphHeight - (consData[0] / maxVal) * graphHeight;
-  for (int i = 1; i < POINTS_PER_DAY; ++i) {
-    int x = x0 + (graphWidth * i) / (POINTS_PER_DAY);
-    int yGen = y0 + graphHeight - (genData[i] / maxVal) * graphHeight;
-    int yCons = y0 + graphHeight - (consData[i] / maxVal) * graphHeight;
-    tft.drawLine(prevX, prevYGen, x, yGen, colourGen);
-    tft.drawLine(prevX, prevYCons, x, yCons, colourCons);
-    prevX = x;
-    prevYGen = yGen;
-    prevYCons = yCons;
+  {
+    PROFILE_SCOPE("graph curves");
+    auto toY = [&](float v) {
+      return isnan(v) ? y0 + graphHeight
+                      : y0 + graphHeight - static_cast<int>((v / maxVal) * graphHeight);
+    };
+    if (envelope) {
+      for (int i = 0; i < count; ++i) {
+        const EnergyHistory::Envelope &e = envelope[i];
+        int x = x0 + (graphWidth * i) / count;
+        if (e.consMax > e.consMin) {
+          tft.drawFastVLine(x, toY(e.consMax), toY(e.consMin) - toY(e.consMax) + 1,
+                            TFT_MAROON);
+        }
+        if (e.genMax > e.genMin) {
+          tft.drawFastVLine(x, toY(e.genMax), toY(e.genMin) - toY(e.genMax) + 1,
+                            TFT_OLIVE);
+        }
+      }
+    }
+    int prevX = x0;
+    int prevYGen = toY(genData[0]);
+    int prevYCons = toY(consData[0]);
+    for (int i = 1; i < count; ++i) {
+      int x = x0 + (graphWidth * i) / count;
+      int yGen = toY(genData[i]);
+      int yCons = toY(consData[i]);
+      if (!isnan(genData[i - 1]) && !isnan(genData[i])) {
+        tft.drawLine(prevX, prevYGen, x, yGen, colourGen);
+      }
+      if (!isnan(consData[i - 1]) && !isnan(consData[i])) {
+        tft.drawLine(prevX, prevYCons, x, yCons, colourCons);
+      }
+      prevX = x;
+      prevYGen = yGen;
+      prevYCons = yCons;
+    }
   }
   // Legend box in the top-right corner of the graph
   int legendX = x0 + graphWidth - legendBoxW - legendBoxMarginX;
@@ -552,54 +1246,366 @@ void drawGraph(const std::vector<float> &genData,
                  boxY + legendColorBox + 2 + legendTextOffsetY);
 }
 
+// Draw the time window [from, to) from the cached history.
+void drawGraphWindow(uint32_t from, uint32_t to) {
+  float gen[graphColumns];
+  float cons[graphColumns];
+  EnergyHistory::Envelope envelope[graphColumns];
+  // The backfill task writes past days from the other core
+  lockHistory();
+  int count = history.render(from, to, graphColumns, gen, cons, envelope);
+  unlockHistory();
+  if (count > 0) {
+    drawGraphSeries(gen, cons, count, from, to, envelope);
+  }
+}
+
+// Keep the hours of today that have started so far in the history and in
+// the day archive.
+void recordHistory(const std::vector<float> &genCurve,
+                   const std::vector<float> &consCurve) {
+  time_t nowT = time(nullptr);
+  if (nowT < 100000) {
+    return;
+  }
+  uint32_t dayStart = nowT - nowT % 86400;
+  size_t hours = (nowT - dayStart) / 3600 + 1;
+  lockHistory();
+  history.recordHours(dayStart, genCurve.data(), consCurve.data(), hours);
+  unlockHistory();
+  archiveDay(dayStart, genCurve.data(), consCurve.data(), hours);
+}
+
+/*
+ * Draw the crosshair and value tooltip for the sample under screen column
+ * ``x`` on the overlay layer.  The previous crosshair is removed by
+ * restoring the pixels saved beneath it, so moving the crosshair only
+ * transfers its own rectangles instead of redrawing the graph.
+ */
+void showCrosshair(int x) {
+  if (shownCount == 0) {
+    return;
+  }
+  int i = (x - graphX) * shownCount / graphW;
+  i = std::max(0, std::min(i, shownCount - 1));
+  if (crosshairVisible && i == crosshairIndex) {
+    return;
+  }
+  overlay.restore();
+  crosshairIndex = i;
+  crosshairVisible = true;
+
+  // Vertical line through the sample plus the dots on both curves
+  int lineX = graphX + (graphW * i) / shownCount;
+  int top = graphY + 1;
+  int bottom = graphY + graphH - 1;
+  if (!overlay.save(lineX - 2, top, 5, bottom - top + 1)) {
+    return;
+  }
+  tft.drawFastVLine(lineX, top, bottom - top + 1, TFT_WHITE);
+  const float values[2] = {shownGen[i], shownCons[i]};
+  const uint16_t colours[2] = {TFT_YELLOW, TFT_RED};
+  for (int k = 0; k < 2; ++k) {
+    if (!isnan(values[k])) {
+      int y = graphY + graphH - static_cast<int>((values[k] / shownMax) * graphH);
+      tft.fillRect(lineX - 2, std::max(top, std::min(y - 2, bottom - 4)), 5, 5,
+                   colours[k]);
+    }
+  }
+
+  // Tooltip with the time and both values, beside the line and clear of
+  // the legend
+  char timeText[16];
+  uint32_t t = shownFrom + static_cast<uint32_t>(
+                               static_cast<uint64_t>(shownTo - shownFrom) * i /
+                               shownCount);
+  if (shownTo - shownFrom > 86400) {
+    time_t tt = t;
+    struct tm tmT;
+    gmtime_r(&tt, &tmT);
+    sprintf(timeText, "%02d.%02d. %02d:%02d", tmT.tm_mday, tmT.tm_mon + 1,
+            tmT.tm_hour, tmT.tm_min);
+  } else {
+    sprintf(timeText, "%02u:%02u", static_cast<unsigned>((t / 3600) % 24),
+            static_cast<unsigned>((t / 60) % 60));
+  }
+  char genText[16];
+  char consText[16];
+  if (isnan(shownGen[i])) {
+    strcpy(genText, "--");
+  } else {
+    sprintf(genText, "%.0f W", shownGen[i]);
+  }
+  if (isnan(shownCons[i])) {
+    strcpy(consText, "--");
+  } else {
+    sprintf(consText, "%.0f W", shownCons[i]);
+  }
+  int boxX = lineX + 6;
+  if (boxX + tooltipW > graphX + graphW) {
+    boxX = lineX - 6 - tooltipW;
+  }
+  int boxY = graphY + graphH - tooltipH - 2;
+  if (!overlay.save(boxX, boxY, tooltipW, tooltipH)) {
+    return;
+  }
+  tft.fillRect(boxX, boxY, tooltipW, tooltipH, TFT_DARKGREY);
+  tft.drawRect(boxX, boxY, tooltipW, tooltipH, TFT_LIGHTGREY);
+  tft.setTextDatum(TL_DATUM);
+  tft.setTextSize(1);
+  tft.setTextColor(TFT_WHITE, TFT_DARKGREY);
+  tft.drawString(timeText, boxX + 4, boxY + 3);
+  tft.setTextColor(TFT_YELLOW, TFT_DARKGREY);
+  tft.drawString(genText, boxX + 4, boxY + 13);
+  tft.setTextColor(TFT_RED, TFT_DARKGREY);
+  tft.drawString(consText, boxX + 4 + tooltipW / 2, boxY + 13);
+}
+
+// Remove the crosshair by restoring the pixels underneath.
+void hideCrosshair() {
+  overlay.restore();
+  crosshairVisible = false;
+}
+
+/*
+ * Poll the touch controller.  Returns true if the refresh button was
+ * touched.  On the graph a tap shows the crosshair with the values of the
+ * sample under the finger and a long press drags it along the curve; a
+ * quick drag pans the time window instead and two fingers pinch-zoom it.
+ * Gesture frames are rendered from ``history`` only, so they never wait for
+ * the network or the flash, and at most one frame is drawn every
+ * ``GESTURE_FRAME_MS``.  After ``VIEW_TIMEOUT_MS`` without a touch the
+ * crosshair disappears and the graph returns to today.  A double tap
+ * anywhere else switches between the cloud and the smart meter.
+ */
+bool handleTouch() {
+#if HAS_TOUCH
+  enum class Gesture : uint8_t { NONE, PENDING, CROSSHAIR, PAN, ZOOM };
+  // Finger positions and window when the current gesture started; the
+  // anchor is reset whenever the number of fingers changes.
+  static Gesture gesture = Gesture::NONE;
+  static int16_t anchorX[2];
+  static uint32_t anchorFrom = 0;
+  static uint32_t anchorTo = 0;
+  static uint32_t anchorTime = 0;
+  static uint32_t lastFrame = 0;
+  static bool otherDown = false;
+  static uint32_t lastOtherTap = 0;
+
+  uint32_t nowMs = millis();
+  uint8_t touches = touch.touched(GT911_MODE_POLLING);
+  GTPoint *points = touches ? touch.getPoints() : nullptr;
+  int16_t fingerX[2] = {0, 0};
+  uint8_t fingers = 0;
+  bool other = false;
+  for (uint8_t i = 0; i < touches; ++i) {
+    // Convert portrait coordinates (x,y) to our landscape orientation
+    int16_t px = points[i].y;
+    int16_t py = 320 - points[i].x;
+    if (px >= refreshBtnX && px <= refreshBtnX + refreshBtnW &&
+        py >= refreshBtnY && py <= refreshBtnY + refreshBtnH) {
+      return gesture == Gesture::NONE;
+    }
+    if (px >= graphX && px < graphX + graphW && py >= graphY &&
+        py < graphY + graphH) {
+      if (fingers < 2) {
+        fingerX[fingers++] = px;
+      }
+    } else {
+      other = true;
+    }
+  }
+  if (other && !otherDown) {
+    if (nowMs - lastOtherTap < DOUBLE_TAP_MS) {
+      toggleSource();
+      lastOtherTap = 0;
+    } else {
+      lastOtherTap = nowMs;
+    }
+  }
+  otherDown = other;
+
+  time_t nowT = time(nullptr);
+  bool clockSet = nowT >= 100000;
+  uint32_t dayEnd = nowT - nowT % 86400 + 86400;
+  if (fingers == 0) {
+    lockDisplay();
+    if (gesture == Gesture::PENDING) {
+      // A tap places the crosshair, or removes it when tapped again
+      if (crosshairVisible &&
+          (anchorX[0] - graphX) * shownCount / graphW == crosshairIndex) {
+        hideCrosshair();
+      } else {
+        showCrosshair(anchorX[0]);
+      }
+      lastGesture = nowMs;
+    }
+    gesture = Gesture::NONE;
+    if (nowMs - lastGesture >= VIEW_TIMEOUT_MS) {
+      if (crosshairVisible) {
+        hideCrosshair();
+      }
+      if (viewActive) {
+        viewActive = false;
+        if (clockSet) {
+          drawGraphWindow(dayEnd - 86400, dayEnd);
+        }
+      }
+    }
+    unlockDisplay();
+    return false;
+  }
+  lastGesture = nowMs;
+
+  Gesture wanted = fingers == 2 ? Gesture::ZOOM : gesture;
+  if (gesture == Gesture::NONE || (gesture == Gesture::ZOOM && fingers == 1)) {
+    wanted = Gesture::PENDING;
+  }
+  if (wanted != gesture) {
+    gesture = wanted;
+    anchorX[0] = fingerX[0];
+    anchorX[1] = fingerX[1];
+    anchorTime = nowMs;
+    anchorFrom = viewActive ? viewFrom : dayEnd - 86400;
+    anchorTo = viewActive ? viewTo : dayEnd;
+    return false;
+  }
+  if (gesture == Gesture::PENDING) {
+    // Holding still selects the crosshair, moving pans the graph
+    if (abs(fingerX[0] - anchorX[0]) > 8) {
+      gesture = Gesture::PAN;
+    } else if (nowMs - anchorTime >= 300) {
+      gesture = Gesture::CROSSHAIR;
+    } else {
+      return false;
+    }
+  }
+  if (gesture == Gesture::CROSSHAIR) {
+    lockDisplay();
+    showCrosshair(fingerX[0]);
+    unlockDisplay();
+    return false;
+  }
+  // Panning and zooming need absolute times from the history
+  if (!clockSet || nowMs - lastFrame < GESTURE_FRAME_MS) {
+    return false;
+  }
+
+  const int64_t span0 = anchorTo - anchorFrom;
+  int64_t span = span0;
+  int64_t from;
+  if (gesture == Gesture::PAN) {
+    // The time under the finger stays under the finger
+    from = anchorFrom - (fingerX[0] - anchorX[0]) * span0 / graphW;
+  } else {
+    int d0 = abs(anchorX[0] - anchorX[1]);
+    int d = abs(fingerX[0] - fingerX[1]);
+    if (d0 < 10 || d < 10) {
+      return false; // fingers too close for a stable ratio
+    }
+    span = std::min<int64_t>(std::max<int64_t>(span0 * d0 / d, VIEW_MIN_SPAN_S),
+                             VIEW_MAX_SPAN_S);
+    // Zoom around the point between the fingers
+    int64_t c0 = (anchorX[0] + anchorX[1]) / 2 - graphX;
+    int64_t c = (fingerX[0] + fingerX[1]) / 2 - graphX;
+    int64_t centre = anchorFrom + c0 * span0 / graphW;
+    from = centre - c * span / graphW;
+  }
+  // Stay between the oldest cached hour and the end of today
+  from = std::min<int64_t>(std::max<int64_t>(from, int64_t(dayEnd) - VIEW_MAX_SPAN_S),
+                           int64_t(dayEnd) - span);
+  if (viewActive && from == viewFrom && from + span == viewTo) {
+    return false;
+  }
+  viewActive = true;
+  viewFrom = from;
+  viewTo = from + span;
+  lastFrame = nowMs;
+  lockDisplay();
+  drawGraphWindow(viewFrom, viewTo);
+  unlockDisplay();
+#endif
+  return false;
+}
+
+// Draw a label or value of the values block: with the smooth value font
+// if one is installed, otherwise with the current built-in font.
+void drawValueText(const char *text, int x, int y, uint8_t datum) {
+  if (valueFont.loaded()) {
+    valueFont.drawString(tft, text, x, y, datum);
+    return;
+  }
+  tft.setTextDatum(datum);
+  tft.drawString(text, x, y);
+}
+
+// Draw the archive's icon ``name`` beside the value row at ``y``, if the
+// archive has one small enough.
+void drawValueIcon(const char *name, int y) {
+  int id = assets.find(name);
+  if (id < 0 || assets.width(id) > valueIconSize ||
+      assets.height(id) > valueIconSize) {
+    return;
+  }
+  assets.draw(tft, id, valueIconX, y);
+}
+
 /*
  * Draw textual information (battery %, daily generation and consumption)
  * beneath the graph.  The values are formatted with one decimal place.  If
- * a value is NaN it is displayed as "--".
+ * a value is NaN it is displayed as "--".  The "battery", "sun" and "house"
+ * icons of the asset archive, if any, go beside the rows.
  */
 void drawNumbers(float batteryPercent, float dailyGeneration,
                  float dailyConsumption) {
   int startY = valuesY;
   int colX = valuesX;
+  markDisplayDirty(0, valuesY, tft.width(), tft.height() - valuesY);
   tft.setTextColor(TFT_WHITE, TFT_BLACK);
   tft.setTextSize(2);
+  valueFont.setColors(TFT_WHITE, TFT_BLACK);
+  drawValueIcon("battery", startY);
+  drawValueIcon("sun", startY + rowHeight);
+  drawValueIcon("house", startY + 2 * rowHeight);
   // Battery state
-  tft.setTextDatum(TL_DATUM);
-  tft.drawString("Battery:", colX, startY);
-  tft.setTextDatum(TR_DATUM);
+  drawValueText("Battery:", colX, startY, TL_DATUM);
   if (isnan(batteryPercent)) {
-    tft.drawString("-- %", colX + valueLabelToValDist, startY);
+    drawValueText("-- %", colX + valueLabelToValDist, startY, TR_DATUM);
   } else {
     char buf[16];
     sprintf(buf, "%5.1f %%", batteryPercent);
-    tft.drawString(buf, colX + valueLabelToValDist, startY);
+    drawValueText(buf, colX + valueLabelToValDist, startY, TR_DATUM);
   }
   // Daily generation
-  tft.setTextDatum(TL_DATUM);
-  tft.drawString("Generated:", colX, startY + rowHeight);
-  tft.setTextDatum(TR_DATUM);
+  drawValueText("Generated:", colX, startY + rowHeight, TL_DATUM);
   if (isnan(dailyGeneration)) {
-    tft.drawString("-- kWh", colX + valueLabelToValDist, startY + rowHeight);
+    drawValueText("-- kWh", colX + valueLabelToValDist, startY + rowHeight, TR_DATUM);
   } else {
     char buf[16];
     sprintf(buf, "%5.2f kWh", dailyGeneration);
-    tft.drawString(buf, colX + valueLabelToValDist, startY + rowHeight);
+    drawValueText(buf, colX + valueLabelToValDist, startY + rowHeight, TR_DATUM);
   }
   // Daily consumption
-  tft.setTextDatum(TL_DATUM);
-  tft.drawString("Consumed:", colX, startY + 2 * rowHeight);
-  tft.setTextDatum(TR_DATUM);
+  drawValueText("Consumed:", colX, startY + 2 * rowHeight, TL_DATUM);
   if (isnan(dailyConsumption)) {
-    tft.drawString("-- kWh", colX + valueLabelToValDist, startY + 2 * rowHeight);
+    drawValueText("-- kWh", colX + valueLabelToValDist, startY + 2 * rowHeight,
+                  TR_DATUM);
   } else {
     char buf[16];
     sprintf(buf, "%5.2f kWh", dailyConsumption);
-    tft.drawString(buf, colX + valueLabelToValDist, startY + 2 * rowHeight);
+    drawValueText(buf, colX + valueLabelToValDist, startY + 2 * rowHeight,
+                  TR_DATUM);
   }
   // Reset datum and text size for subsequent elements
   tft.setTextDatum(TL_DATUM);
   tft.setTextSize(1);
 
+  if (hasLivePower()) {
+    drawLivePower();
+  }
+  drawDerivedRows(batteryPercent, dailyGeneration, dailyConsumption);
+  drawAlarmBanner();
+
   // Draw the refresh button.  A dark grey filled rectangle with a light
   // border and white text forms the on-screen button.  Users can tap
   // anywhere inside this area to trigger an immediate refresh when touch
@@ -616,42 +1622,167 @@ void drawNumbers(float batteryPercent, float dailyGeneration,
                  refreshBtnY + refreshBtnH / 2 + refreshTextOffsetY);
   tft.setTextSize(1);
 
-  // Display the timestamp of the last successful update underneath the
-  // button.  The label remains even if no updates have occurred yet.
+  drawUpdated();
+}
+
+/*
+ * Display the timestamp of the last successful update underneath the
+ * button.  The label remains even if no updates have occurred yet.  The
+ * text always has the same width, so it simply overwrites the previous one.
+ */
+void drawUpdated() {
   tft.setTextColor(TFT_LIGHTGREY, TFT_BLACK);
-  tft.drawString(String("Updated: ") + lastUpdateStr, valuesX, updatedY);
+  tft.setTextSize(1);
+  int w = tft.drawString(String("Updated: ") + lastUpdateStr, valuesX, updatedY);
+  markDisplayDirty(valuesX, updatedY, w, tft.fontHeight());
+}
+
+// True if the selected source delivers instantaneous power.
+bool hasLivePower() {
+  return currentMode == Mode::MODE_OPTICAL_METER ||
+         currentMode == Mode::MODE_RPC_METER;
 }
 
 /*
- * Fetch energy data from the Anker Solix cloud.  The function returns true
- * on success and fills the provided references with the current battery
- * charge, daily generation and consumption (in kWh) together with hourly
- * arrays of generation and consumption power (in W).  The actual API
- * endpoints and authorisation tokens must be specified in ``secrets.h``.
+ * Draw the live power readout.  Only the small box to the right of the
+ * values block is repainted so it can be refreshed for every telegram
+ * without touching the rest of the screen.
  */
-bool fetchAnkerData(float &batteryPercent, float &dailyGeneration,
-                    float &dailyConsumption,
-                    std::vector<float> &generationCurve,
-                    std::vector<float> &consumptionCurve) {
-  // Check that the user has configured the Anker API endpoints
-  if (strlen(ANKER_AUTH_URL) == 0 || strlen(ANKER_ENERGY_URL) == 0) {
-    Serial.println("Anker API endpoints are not configured");
-    return false;
+void drawLivePower() {
+  // With user-defined rows below it the readout is condensed to one line
+  bool compact = derivedValues.count() > 0;
+  int h = compact ? rowHeight - GAP : liveBoxH;
+  int valueY = compact ? liveBoxY : liveBoxY + rowHeight / 2 + GAP;
+  tft.fillRect(liveBoxX, liveBoxY, liveBoxW, h, TFT_BLACK);
+  markDisplayDirty(liveBoxX, liveBoxY, liveBoxW, h);
+  tft.setTextColor(TFT_LIGHTGREY, TFT_BLACK);
+  tft.setTextSize(1);
+  if (compact) {
+    tft.setTextDatum(TL_DATUM);
+    tft.drawString("Live power", liveBoxX, liveBoxY + GAP);
+  } else {
+    tft.setTextDatum(TR_DATUM);
+    tft.drawString("Live power", liveBoxX + liveBoxW, liveBoxY);
+  }
+  tft.setTextDatum(TR_DATUM);
+  tft.setTextColor(TFT_CYAN, TFT_BLACK);
+  tft.setTextSize(2);
+  if (isnan(livePowerW)) {
+    tft.drawString("-- W", liveBoxX + liveBoxW, valueY);
+  } else {
+    char buf[16];
+    sprintf(buf, "%.0f W", livePowerW);
+    tft.drawString(buf, liveBoxX + liveBoxW, valueY);
+  }
+  tft.setTextDatum(TL_DATUM);
+  tft.setTextSize(1);
+}
+
+/*
+ * Draw the user-defined rows below the live readout, or at the top of the
+ * right column when there is none.  Each row is evaluated from the given
+ * values, today's curves, the live power and the current (UTC) hour.
+ */
+void drawDerivedRows(float batteryPercent, float dailyGeneration,
+                     float dailyConsumption) {
+  int top = hasLivePower() ? liveBoxY + rowHeight - GAP : valuesY;
+  int rows = std::min<int>(derivedValues.count(),
+                           (refreshBtnY - GAP - top) / derivedRowH);
+  if (rows <= 0) {
+    return;
+  }
+  DerivedInputs in;
+  in.battery = batteryPercent;
+  in.gen = dailyGeneration;
+  in.cons = dailyConsumption;
+  in.power = hasLivePower() ? livePowerW : NAN;
+  in.hour = NAN;
+  time_t nowT = time(nullptr);
+  if (nowT > 100000) {
+    struct tm tmNow;
+    gmtime_r(&nowT, &tmNow);
+    in.hour = tmNow.tm_hour;
+  }
+  bool curves = todayGen.size() == POINTS_PER_DAY &&
+                todayCons.size() == POINTS_PER_DAY;
+  in.genCurve = curves ? todayGen.data() : nullptr;
+  in.consCurve = curves ? todayCons.data() : nullptr;
+  in.curveLength = curves ? POINTS_PER_DAY : 0;
+
+  tft.fillRect(liveBoxX, top, liveBoxW, rows * derivedRowH, TFT_BLACK);
+  markDisplayDirty(liveBoxX, top, liveBoxW, rows * derivedRowH);
+  tft.setTextSize(1);
+  for (int i = 0; i < rows; ++i) {
+    int y = top + i * derivedRowH + 2;
+    tft.setTextDatum(TL_DATUM);
+    tft.setTextColor(TFT_LIGHTGREY, TFT_BLACK);
+    tft.drawString(derivedValues.label(i), liveBoxX, y);
+    float v = derivedValues.evaluate(i, in);
+    char buf[24];
+    if (isnan(v) || isinf(v)) {
+      snprintf(buf, sizeof(buf), "-- %s", derivedValues.unit(i));
+    } else {
+      float mag = fabsf(v);
+      int decimals = mag >= 100.0f ? 0 : mag >= 10.0f ? 1 : 2;
+      snprintf(buf, sizeof(buf), "%.*f %s", decimals, v, derivedValues.unit(i));
+    }
+    tft.setTextDatum(TR_DATUM);
+    tft.setTextColor(TFT_WHITE, TFT_BLACK);
+    tft.drawString(buf, liveBoxX + liveBoxW, y);
+  }
+  tft.setTextDatum(TL_DATUM);
+}
+
+/*
+ * Draw the alarm banner.  Like the live readout it repaints only its own
+ * rectangle, so raising or clearing an alarm never redraws the graph.
+ */
+void drawAlarmBanner() {
+  char text[40];
+  markDisplayDirty(bannerX, bannerY, bannerW, bannerH);
+  if (!alarmBannerText(text, sizeof(text))) {
+    tft.fillRect(bannerX, bannerY, bannerW, bannerH, TFT_BLACK);
+    return;
+  }
+  tft.fillRect(bannerX, bannerY, bannerW, bannerH, TFT_RED);
+  tft.setTextDatum(MC_DATUM);
+  tft.setTextColor(TFT_WHITE, TFT_RED);
+  tft.setTextSize(1);
+  tft.drawString(text, bannerX + bannerW / 2, bannerY + bannerH / 2);
+  tft.setTextDatum(TL_DATUM);
+}
+
+// Check the values of a successful fetch against the alarm rules.  The
+// generation rule looks at the curve value of the current (UTC) hour.
+void feedAlarms(float batteryPercent, const std::vector<float> &genCurve) {
+  alarmSample(AlarmMetric::BATTERY, batteryPercent);
+  time_t nowT = time(nullptr);
+  if (nowT > 100000) {
+    struct tm tmNow;
+    gmtime_r(&nowT, &tmNow);
+    alarmSample(AlarmMetric::GENERATION, genCurve[tmNow.tm_hour]);
   }
-  // Authenticate with the Anker cloud
+  alarmSample(AlarmMetric::AGE, 0.0f);
+}
+
+// Log in to the Anker cloud and keep the token in ``session``.
+static bool ankerLogin(SourceSession &session, const String &authUrl) {
   HTTPClient http;
-  http.begin(wifiClient, ANKER_AUTH_URL);
+  http.begin(session.client, authUrl);
   http.addHeader("Content-Type", "application/json");
-  // Build JSON body for login; credentials defined in secrets.h
+  // Build JSON body for login from the configured credentials
   JsonDocument loginDoc;
-  loginDoc["userAccount"] = ANKER_USER;
-  loginDoc["password"] = ANKER_PASSWORD;
-  loginDoc["country"] = ANKER_COUNTRY;
+  loginDoc["userAccount"] = configString(ConfigKey::AnkerUser);
+  loginDoc["password"] = configString(ConfigKey::AnkerPassword);
+  loginDoc["country"] = configString(ConfigKey::AnkerCountry);
   String loginBody;
   serializeJson(loginDoc, loginBody);
   int httpCode = http.POST(loginBody);
   if (httpCode != HTTP_CODE_OK) {
     Serial.printf("Anker auth failed: %d\n", httpCode);
+    if (httpCode < 0 || httpCode >= 500) {
+      reportEndpointFailure();
+    }
     http.end();
     return false;
   }
@@ -669,67 +1800,108 @@ bool fetchAnkerData(float &batteryPercent, float &dailyGeneration,
     Serial.println("No access token received");
     return false;
   }
-  // Request daily energy data
-  http.begin(wifiClient, ANKER_ENERGY_URL);
-  http.addHeader("Authorization", String("Bearer ") + token);
-  http.addHeader("Content-Type", "application/json");
-  int energyCode = http.GET();
+  session.token = token;
+  return true;
+}
+
+/*
+ * Fetch energy data from the Anker Solix cloud.  The function returns true
+ * on success and fills the provided references with the current battery
+ * charge, daily generation and consumption (in kWh) together with hourly
+ * arrays of generation and consumption power (in W).  The actual API
+ * endpoints and credentials come from the runtime configuration.  The
+ * token of the last login is reused until the cloud rejects it.  Called
+ * through fetchDocument(), which holds the session.
+ */
+bool fetchAnkerData(SourceSession &session, float &batteryPercent,
+                    float &dailyGeneration, float &dailyConsumption,
+                    std::vector<float> &generationCurve,
+                    std::vector<float> &consumptionCurve) {
+  // Check that the user has configured the Anker API endpoints
+  // Both go to the fastest healthy regional host if alternatives are
+  // configured
+  String authUrl = endpointUrl(configString(ConfigKey::AnkerAuthUrl));
+  String energyUrl = endpointUrl(configString(ConfigKey::AnkerEnergyUrl));
+  if (authUrl.length() == 0 || energyUrl.length() == 0) {
+    Serial.println("Anker API endpoints are not configured");
+    return false;
+  }
+  bool cachedToken = session.token.length() > 0;
+  if (!cachedToken) {
+    // Authenticate with the Anker cloud
+    session.warm = claimConnection(session, authUrl);
+    if (!ankerLogin(session, authUrl)) {
+      return false;
+    }
+  } else {
+    session.warm = claimConnection(session, energyUrl);
+  }
+  HTTPClient http;
+  int energyCode = 0;
+  for (;;) {
+    // Request daily energy data
+    claimConnection(session, energyUrl);
+    http.begin(session.client, energyUrl);
+    http.addHeader("Authorization", String("Bearer ") + session.token);
+    http.addHeader("Content-Type", "application/json");
+    energyCode = http.GET();
+    if (!cachedToken ||
+        (energyCode != HTTP_CODE_UNAUTHORIZED && energyCode != HTTP_CODE_FORBIDDEN)) {
+      break;
+    }
+    // The token has expired: log in again and repeat the request once
+    http.end();
+    session.token = "";
+    cachedToken = false;
+    claimConnection(session, authUrl);
+    if (!ankerLogin(session, authUrl)) {
+      return false;
+    }
+  }
   if (energyCode != HTTP_CODE_OK) {
     Serial.printf("Energy request failed: %d\n", energyCode);
+    if (energyCode < 0 || energyCode >= 500) {
+      reportEndpointFailure();
+    }
+    if (energyCode == HTTP_CODE_UNAUTHORIZED || energyCode == HTTP_CODE_FORBIDDEN) {
+      session.token = "";
+    }
     http.end();
     return false;
   }
-  String energyResponse = http.getString();
-  http.end();
-  // Parse energy response.  The expected JSON structure must be
-  // documented by Anker.  Here we assume a structure similar to
+  // The energy response is read through the configured field mapping.
+  // Without one it is expected to look like
   // {"battery_percent": 80.3, "daily_generation": 3.45,
   //  "daily_consumption": 2.10,
   //  "generation_curve": [24 floats ...],
   //  "consumption_curve": [24 floats ...] }.
-  JsonDocument energyDoc;
-  err = deserializeJson(energyDoc, energyResponse);
-  if (err) {
-    Serial.println("Failed to parse energy response");
-    return false;
-  }
-  // Extract numeric values; use NaN if not present
-  batteryPercent = energyDoc["battery_percent"] | NAN;
-  dailyGeneration = energyDoc["daily_generation"] | NAN;
-  dailyConsumption = energyDoc["daily_consumption"] | NAN;
-  // Fill curves
-  JsonArray genArr = energyDoc["generation_curve"].as<JsonArray>();
-  JsonArray consArr = energyDoc["consumption_curve"].as<JsonArray>();
-  if (genArr.size() == POINTS_PER_DAY && consArr.size() == POINTS_PER_DAY) {
-    for (int i = 0; i < POINTS_PER_DAY; ++i) {
-      generationCurve[i] = genArr[i].as<float>();
-      consumptionCurve[i] = consArr[i].as<float>();
-    }
-  } else {
-    Serial.println("Invalid curve length; expected 24 values");
-  }
-  return true;
+  return readMappedFields(http, session, "energy", batteryPercent, dailyGeneration,
+                          dailyConsumption, generationCurve, consumptionCurve);
 }
 
 /*
  * Fetch energy data from a local smart-meter.  The smart-meter must provide
  * an HTTP API returning JSON with the same structure as described above.
- * Configure the host address and endpoint in ``secrets.h``.  Returns true
- * on success.
+ * The host address and endpoint come from the runtime configuration.  Returns true
+ * on success.  Called through fetchDocument(), which holds the session.
  */
-bool fetchSmartmeterData(float &batteryPercent, float &dailyGeneration,
-                         float &dailyConsumption,
+bool fetchSmartmeterData(SourceSession &session, float &batteryPercent,
+                         float &dailyGeneration, float &dailyConsumption,
                          std::vector<float> &generationCurve,
                          std::vector<float> &consumptionCurve) {
-  if (strlen(SMARTMETER_HOST) == 0 || strlen(SMARTMETER_ENERGY_ENDPOINT) == 0) {
+  String host = configString(ConfigKey::MeterHost);
+  String endpoint = configString(ConfigKey::MeterEndpoint);
+  String token = configString(ConfigKey::MeterToken);
+  if (host.length() == 0 || endpoint.length() == 0) {
     Serial.println("Smart-meter host or endpoint not configured");
     return false;
   }
+  String url = String("http://") + host + endpoint;
+  session.warm = claimConnection(session, url);
   HTTPClient http;
-  String url = String("http://") + SMARTMETER_HOST + SMARTMETER_ENERGY_ENDPOINT;
-  http.begin(wifiClient, url);
-  if (strlen(SMARTMETER_TOKEN) > 0) {
-    http.addHeader("Authorization", String("Bearer ") + SMARTMETER_TOKEN);
+  http.begin(session.client, url);
+  if (token.length() > 0) {
+    http.addHeader("Authorization", String("Bearer ") + token);
   }
   int httpCode = http.GET();
   if (httpCode != HTTP_CODE_OK) {
@@ -737,30 +1909,477 @@ bool fetchSmartmeterData(float &batteryPercent, float &dailyGeneration,
     http.end();
     return false;
   }
-  String response = http.getString();
+  return readMappedFields(http, session, "smart-meter", batteryPercent,
+                          dailyGeneration, dailyConsumption, generationCurve,
+                          consumptionCurve);
+}
+
+// URL of the first request of the next fetch, empty for sources that do
+// not fetch over HTTP.  Reads the cloud token, so the caller holds the
+// cloud session in cloud mode.
+String firstRequestUrl() {
+  if (currentMode == Mode::MODE_ANKER_CLOUD) {
+    // With a token at hand the fetch starts with the energy request
+    return endpointUrl(configString(cloudSession.token.length()
+                                        ? ConfigKey::AnkerEnergyUrl
+                                        : ConfigKey::AnkerAuthUrl));
+  }
+  if (currentMode == Mode::MODE_LOCAL_SMARTMETER) {
+    String host = configString(ConfigKey::MeterHost);
+    return host.length() ? String("http://") + host +
+                               configString(ConfigKey::MeterEndpoint)
+                         : String();
+  }
+  return String();
+}
+
+// "host:port" of an http(s) URL, empty if it has no host.
+static String urlTarget(const String &url) {
+  int start = url.indexOf("://");
+  if (start < 0) {
+    return String();
+  }
+  start += 3;
+  int end = start;
+  while (end < static_cast<int>(url.length()) && url[end] != '/' &&
+         url[end] != '?') {
+    ++end;
+  }
+  String host = url.substring(start, end);
+  if (host.length() == 0 || host.indexOf(':') >= 0) {
+    return host;
+  }
+  return host + (url.startsWith("https") ? ":443" : ":80");
+}
+
+/*
+ * Resolve the host of the next fetch and open the TCP connection a few
+ * seconds early.  A connection left idle since the previous fetch has
+ * usually been dropped by the server or a NAT by then, so without this
+ * the fetch itself would wait for DNS and the handshake.  A connection
+ * that is still open is kept.
+ */
+void prewarmConnection() {
+  SourceSession *session = sessionFor(currentMode);
+  // Skipped while the standby task is still fetching the source
+  if (!session || WiFi.status() != WL_CONNECTED || !claimSession(*session, 0)) {
+    return;
+  }
+  String target = urlTarget(firstRequestUrl());
+  int colon = target.lastIndexOf(':');
+  if (colon > 0 && !(session->target == target && session->client.connected())) {
+    String host = target.substring(0, colon);
+    uint16_t port = static_cast<uint16_t>(target.substring(colon + 1).toInt());
+    uint32_t start = millis();
+    session->client.stop();
+    if (session->client.connect(host.c_str(), port, PREWARM_TIMEOUT_MS)) {
+      session->target = target;
+      Serial.printf("Pre-warmed %s in %lu ms\n", target.c_str(),
+                    static_cast<unsigned long>(millis() - start));
+    } else {
+      Serial.printf("Pre-warming %s failed\n", target.c_str());
+      session->target = "";
+    }
+  }
+  xSemaphoreGive(session->busy);
+}
+
+// Keep the open connection of ``session`` for a request to ``url`` if it
+// leads to the same host; otherwise close it.  Returns true if the request
+// goes out over the open connection.
+bool claimConnection(SourceSession &session, const String &url) {
+  String target = urlTarget(url);
+  bool warm = target.length() > 0 && session.target == target &&
+              session.client.connected();
+  if (!warm) {
+    session.client.stop();
+  }
+  // HTTPClient leaves the connection open if the server allows keep-alive
+  session.target = target;
+  return warm;
+}
+
+void logFetchTime(uint32_t ms, bool overWarm) {
+  FetchTiming &t = fetchTimings[overWarm ? 1 : 0];
+  ++t.count;
+  t.totalMs += ms;
+  const FetchTiming &cold = fetchTimings[0];
+  const FetchTiming &warm = fetchTimings[1];
+  Serial.printf("Fetch took %lu ms over a %s connection (average cold %lu ms, warm %lu ms)\n",
+                static_cast<unsigned long>(ms), overWarm ? "warm" : "cold",
+                static_cast<unsigned long>(cold.count ? cold.totalMs / cold.count : 0),
+                static_cast<unsigned long>(warm.count ? warm.totalMs / warm.count : 0));
+}
+
+// Session of a document source, null for the live meters.
+SourceSession *sessionFor(Mode mode) {
+  if (mode == Mode::MODE_ANKER_CLOUD) {
+    return &cloudSession;
+  }
+  if (mode == Mode::MODE_LOCAL_SMARTMETER) {
+    return &meterSession;
+  }
+  return nullptr;
+}
+
+// Session of the document source that is not shown, null if the active
+// source is a live meter.
+SourceSession *standbySession() {
+  if (currentMode == Mode::MODE_ANKER_CLOUD) {
+    return &meterSession;
+  }
+  if (currentMode == Mode::MODE_LOCAL_SMARTMETER) {
+    return &cloudSession;
+  }
+  return nullptr;
+}
+
+// Take ``session`` for a fetch, waiting at most ``wait`` ticks.  Drops
+// the connection, token and hash first if the settings changed since.
+bool claimSession(SourceSession &session, TickType_t wait) {
+  if (xSemaphoreTake(session.busy, wait) != pdTRUE) {
+    return false;
+  }
+  if (session.reset.exchange(false)) {
+    session.client.stop();
+    session.target = "";
+    session.token = "";
+    session.bodyHashValid = false;
+  }
+  if (!session.bodyShown.exchange(true)) {
+    session.bodyHashValid = false;
+  }
+  return true;
+}
+
+/*
+ * Fetch the document source of ``session``, reading the body with ``map``.
+ * Waits while the other task fetches the same source.  ``unchanged`` tells
+ * whether the body was the same as last time, ``warm`` whether the fetch
+ * went out over an open connection.
+ */
+bool fetchDocument(SourceSession &session, JsonFieldMap &map, float &batteryPercent,
+                   float &dailyGeneration, float &dailyConsumption,
+                   std::vector<float> &generationCurve,
+                   std::vector<float> &consumptionCurve, bool &unchanged,
+                   bool &warm) {
+  claimSession(session, portMAX_DELAY);
+  session.map = &map;
+  session.warm = false;
+  session.unchanged = false;
+  bool ok = &session == &cloudSession
+                ? fetchAnkerData(session, batteryPercent, dailyGeneration,
+                                 dailyConsumption, generationCurve, consumptionCurve)
+                : fetchSmartmeterData(session, batteryPercent, dailyGeneration,
+                                      dailyConsumption, generationCurve,
+                                      consumptionCurve);
+  if (!ok) {
+    session.bodyHashValid = false;
+  }
+  unchanged = ok && session.unchanged;
+  warm = session.warm;
+  xSemaphoreGive(session.busy);
+  return ok;
+}
+
+void storeSnapshot(SourceSession &session, float batteryPercent,
+                   float dailyGeneration, float dailyConsumption,
+                   const std::vector<float> &genCurve,
+                   const std::vector<float> &consCurve) {
+  String updated;
+  formatTimestamp(updated);
+  xSemaphoreTake(snapshotMutex, portMAX_DELAY);
+  session.valid = true;
+  session.fetchedAt = millis();
+  session.updated = updated;
+  session.battery = batteryPercent;
+  session.gen = dailyGeneration;
+  session.cons = dailyConsumption;
+  session.genCurve = genCurve;
+  session.consCurve = consCurve;
+  xSemaphoreGive(snapshotMutex);
+}
+
+// Time of the last values of ``session``; false if there are none.
+bool snapshotTime(SourceSession &session, uint32_t &fetchedAt) {
+  xSemaphoreTake(snapshotMutex, portMAX_DELAY);
+  bool valid = session.valid;
+  fetchedAt = session.fetchedAt;
+  xSemaphoreGive(snapshotMutex);
+  return valid;
+}
+
+// Forget the values of ``session`` and start its next fetch afresh.
+void invalidateSession(SourceSession &session) {
+  session.reset.store(true);
+  xSemaphoreTake(snapshotMutex, portMAX_DELAY);
+  session.valid = false;
+  xSemaphoreGive(snapshotMutex);
+}
+
+/*
+ * Redraw the screen from the last values of ``session``, as a fetch would.
+ * Alarms, history and exports are left alone: they only follow the
+ * fetches of the active source.  Returns false if there are no values.
+ * Call with the display lock held.
+ */
+bool showSnapshot(SourceSession &session, uint32_t &fetchedAt) {
+  xSemaphoreTake(snapshotMutex, portMAX_DELAY);
+  bool valid = session.valid;
+  if (valid) {
+    fetchedAt = session.fetchedAt;
+    lastUpdateStr = session.updated;
+    lastDataTime = session.fetchedAt;
+    shownBattery = session.battery;
+    shownDailyGen = session.gen;
+    shownDailyCons = session.cons;
+    todayGen = session.genCurve;
+    todayCons = session.consCurve;
+  }
+  xSemaphoreGive(snapshotMutex);
+  if (!valid) {
+    return false;
+  }
+  tft.fillScreen(TFT_BLACK);
+  markDisplayDirty(0, 0, tft.width(), tft.height());
+  if (viewActive) {
+    drawGraphWindow(viewFrom, viewTo);
+  } else {
+    drawGraph(todayGen, todayCons);
+  }
+  drawNumbers(shownBattery, shownDailyGen, shownDailyCons);
+  updateDashboard();
+  return true;
+}
+
+// Fetches the session loop() hands over in ``standbyTarget``.  Runs at
+// idle priority so drawing, touch and the live readout never wait for it.
+static void standbyTask(void *) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    SourceSession *session = standbyTarget.load();
+    if (!session) {
+      continue;
+    }
+    // Compiled per fetch, so loop() can change the mapping at any time
+    String text = configString(ConfigKey::FieldMap);
+    char err[48];
+    standbyMap.compile(text.length() ? text.c_str() : DEFAULT_FIELD_MAP, err,
+                       sizeof(err));
+    float batteryPercent = NAN;
+    float dailyGen = NAN;
+    float dailyCons = NAN;
+    std::vector<float> genCurve(POINTS_PER_DAY, 0.0f);
+    std::vector<float> consCurve(POINTS_PER_DAY, 0.0f);
+    bool unchanged;
+    bool warm;
+    bool ok = fetchDocument(*session, standbyMap, batteryPercent, dailyGen,
+                            dailyCons, genCurve, consCurve, unchanged, warm);
+    if (ok) {
+      storeSnapshot(*session, batteryPercent, dailyGen, dailyCons, genCurve,
+                    consCurve);
+    }
+    standbyState.store(ok ? STANDBY_OK : STANDBY_FAILED);
+  }
+}
+
+// Create the session locks and the standby task.  Call once before loop().
+void beginStandby() {
+  if (standbyTaskHandle) {
+    return;
+  }
+  snapshotMutex = xSemaphoreCreateMutex();
+  cloudSession.busy = xSemaphoreCreateMutex();
+  meterSession.busy = xSemaphoreCreateMutex();
+  // HTTP and the login document need about as much stack as the probe
+  if (xTaskCreatePinnedToCore(standbyTask, "standby", 8192, nullptr,
+                              tskIDLE_PRIORITY + 1, &standbyTaskHandle,
+                              0) != pdPASS) {
+    Serial.println("Failed to start standby task");
+    standbyTaskHandle = nullptr;
+  }
+}
+
+/*
+ * Hand the document source that is not shown to the standby task when its
+ * values are due, so a switch to it has something recent to draw.  Only
+ * the session is updated.  Does nothing while the active source is a live
+ * meter or the other source is not configured.
+ */
+void refreshStandby() {
+  uint8_t state = standbyState.load();
+  if (state == STANDBY_RUNNING) {
+    return;
+  }
+  if (state != STANDBY_IDLE) {
+    if (state == STANDBY_OK) {
+      standbySchedule.succeeded();
+    } else {
+      standbySchedule.failed();
+    }
+    standbyState.store(STANDBY_IDLE);
+  }
+  SourceSession *session = standbySession();
+  uint32_t now = millis();
+  if (!session || !standbyTaskHandle || WiFi.status() != WL_CONNECTED ||
+      !standbySchedule.due(now)) {
+    return;
+  }
+  bool cloud = session == &cloudSession;
+  if (cloud ? configString(ConfigKey::AnkerAuthUrl).length() == 0 ||
+                  configString(ConfigKey::AnkerEnergyUrl).length() == 0
+            : configString(ConfigKey::MeterHost).length() == 0 ||
+                  configString(ConfigKey::MeterEndpoint).length() == 0) {
+    return;
+  }
+  standbySchedule.begin(now);
+  standbyTarget.store(session);
+  standbyState.store(STANDBY_RUNNING);
+  xTaskNotifyGive(standbyTaskHandle);
+}
+
+// Switch between the cloud and the smart meter.  Goes through the settings,
+// so the choice is kept, and applies it at once.
+void toggleSource() {
+  const char *next;
+  if (currentMode == Mode::MODE_ANKER_CLOUD) {
+    next = "smartmeter";
+  } else if (currentMode == Mode::MODE_LOCAL_SMARTMETER) {
+    next = "cloud";
+  } else {
+    return;
+  }
+  if (setConfig("mode", next)) {
+    applyConfigChanges();
+  }
+}
+
+// Stream that scans everything written to it with the field mapping, so
+// HTTPClient can hand over the body, chunked or not, without buffering it.
+// The body is hashed on the way to detect repeated responses.
+class FieldMapSink : public Stream {
+public:
+  explicit FieldMapSink(JsonFieldMap &map) : map_(map) {}
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t *data, size_t len) override {
+    PROFILE_SCOPE("json map");
+    hash_.update(data, len);
+    map_.feed(data, len);
+    return len;
+  }
+  uint32_t digest() const { return hash_.digest(); }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  void flush() override {}
+
+private:
+  JsonFieldMap &map_;
+  Xxh32 hash_;
+};
+
+/*
+ * Read the body of a successful request through the mapping of the fetch
+ * and fill its values.  Targets missing from the response are NaN; the
+ * curves are only taken when both have a value for every hour.  Sets
+ * ``session.unchanged`` if the body is the last one of ``session``.  Ends
+ * the request.
+ */
+bool readMappedFields(HTTPClient &http, SourceSession &session, const char *source,
+                      float &batteryPercent, float &dailyGeneration,
+                      float &dailyConsumption, std::vector<float> &generationCurve,
+                      std::vector<float> &consumptionCurve) {
+  JsonFieldMap &map = *session.map;
+  map.begin();
+  FieldMapSink sink(map);
+  int read = http.writeToStream(&sink);
   http.end();
-  JsonDocument doc;
-  DeserializationError err = deserializeJson(doc, response);
-  if (err) {
-    Serial.println("Failed to parse smart-meter response");
+  if (read < 0 || !map.complete()) {
+    Serial.printf("Failed to parse %s response\n", source);
     return false;
   }
-  batteryPercent = doc["battery_percent"] | NAN;
-  dailyGeneration = doc["daily_generation"] | NAN;
-  dailyConsumption = doc["daily_consumption"] | NAN;
-  JsonArray genArr = doc["generation_curve"].as<JsonArray>();
-  JsonArray consArr = doc["consumption_curve"].as<JsonArray>();
-  if (genArr.size() == POINTS_PER_DAY && consArr.size() == POINTS_PER_DAY) {
+  uint32_t hash = sink.digest();
+  session.unchanged = session.bodyHashValid && hash == session.bodyHash;
+  session.bodyHash = hash;
+  session.bodyHashValid = true;
+  const JsonFieldMap::Fields &f = map.fields();
+  batteryPercent = f.battery;
+  dailyGeneration = f.generation;
+  dailyConsumption = f.consumption;
+  if (f.genLength == POINTS_PER_DAY && f.consLength == POINTS_PER_DAY) {
     for (int i = 0; i < POINTS_PER_DAY; ++i) {
-      generationCurve[i] = genArr[i].as<float>();
-      consumptionCurve[i] = consArr[i].as<float>();
+      generationCurve[i] = isnan(f.gen[i]) ? 0.0f : f.gen[i];
+      consumptionCurve[i] = isnan(f.cons[i]) ? 0.0f : f.cons[i];
     }
   } else {
-    Serial.println("Invalid curve length from smart-meter");
+    Serial.printf("Invalid curve length from %s; expected 24 values\n", source);
   }
   return true;
 }
 
+// Compile the configured field mapping, or the built-in one when none is
+// set.  An invalid mapping keeps the previous one.
+void loadFieldMap() {
+  String text = configString(ConfigKey::FieldMap);
+  char err[48];
+  if (!fieldMap.compile(text.length() ? text.c_str() : DEFAULT_FIELD_MAP, err,
+                        sizeof(err))) {
+    Serial.printf("Invalid field mapping: %s\n", err);
+  }
+}
+
+// Compile the user-defined rows.  An invalid list keeps the previous one.
+void loadDerivedValues() {
+  char err[48];
+  if (!derivedValues.compile(configString(ConfigKey::Derived).c_str(), err,
+                             sizeof(err))) {
+    Serial.printf("Invalid derived values: %s\n", err);
+  }
+}
+
+/*
+ * Queue the current values for the InfluxDB exporter.  Samples are only
+ * exported once the clock has been synchronised because line protocol needs
+ * an absolute timestamp.
+ */
+void queueExportSample(float batteryPercent, float dailyGeneration,
+                       float dailyConsumption) {
+  time_t nowT = time(nullptr);
+  if (nowT < 100000) {
+    return;
+  }
+  ExportSample sample;
+  sample.time = static_cast<uint32_t>(nowT);
+  sample.batteryPercent = batteryPercent;
+  sample.dailyGeneration = dailyGeneration;
+  sample.dailyConsumption = dailyConsumption;
+  sample.powerW = livePowerW;
+  exportSample(sample);
+}
+
+/*
+ * Hand the values on screen to the web dashboard.  The snapshot is
+ * serialised here once, not per request.
+ */
+void updateDashboard() {
+  lastDashboardPublish = millis();
+  char alarm[40];
+  DashboardSnapshot s;
+  s.batteryPercent = shownBattery;
+  s.dailyGeneration = shownDailyGen;
+  s.dailyConsumption = shownDailyCons;
+  s.live = hasLivePower();
+  s.powerW = s.live ? livePowerW : NAN;
+  s.gen = todayGen.data();
+  s.cons = todayCons.data();
+  s.points = std::min(todayGen.size(), todayCons.size());
+  s.updated = lastUpdateStr.c_str();
+  time_t nowT = time(nullptr);
+  s.time = nowT > 100000 ? static_cast<uint32_t>(nowT) : 0;
+  s.alarm = alarmBannerText(alarm, sizeof(alarm)) ? alarm : nullptr;
+  publishDashboard(s);
+}
+
 /*
  * Update the human-readable timestamp string ``lastUpdateStr``.
  *
@@ -771,6 +2390,12 @@ bool fetchSmartmeterData(float &batteryPercent, float &dailyGeneration,
  * to indicate an unknown time.
  */
 void updateTimestamp() {
+  formatTimestamp(lastUpdateStr);
+}
+
+// Write the current time as HH:MM:SS to ``out``; leaves it alone while
+// the clock is not set.
+void formatTimestamp(String &out) {
   time_t nowT = time(nullptr);
   // Do not update if the epoch has not been set (less than 1970-01-02)
   if (nowT < 100000) {
@@ -783,6 +2408,6 @@ void updateTimestamp() {
   char buf[9];
   // Format as HH:MM:SS in 24-hour notation
   if (strftime(buf, sizeof(buf), "%H:%M:%S", &timeInfo) > 0) {
-    lastUpdateStr = String(buf);
+    out = String(buf);
   }
 }
\ No newline at end of file
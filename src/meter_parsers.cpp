@@ -0,0 +1,432 @@
+#include "meter_parsers.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Start of an SML transport frame: four escape bytes followed by four 0x01.
+static const uint8_t SML_START[8] = {0x1b, 0x1b, 0x1b, 0x1b,
+                                     0x01, 0x01, 0x01, 0x01};
+
+// Nibble table for the reflected CCITT polynomial (0x8408).  Sixteen
+// entries keep the flash footprint tiny while halving the bit loop.
+static const uint16_t CRC_X25_NIBBLE[16] = {
+    0x0000, 0x1081, 0x2102, 0x3183, 0x4204, 0x5285, 0x6306, 0x7387,
+    0x8408, 0x9489, 0xa50a, 0xb58b, 0xc60c, 0xd68d, 0xe70e, 0xf78f};
+
+uint16_t crc16X25Update(uint16_t crc, uint8_t b) {
+  crc = (crc >> 4) ^ CRC_X25_NIBBLE[(crc ^ b) & 0x0f];
+  crc = (crc >> 4) ^ CRC_X25_NIBBLE[(crc ^ (b >> 4)) & 0x0f];
+  return crc;
+}
+
+ObisField lookupObis(uint8_t a, uint8_t c, uint8_t d, uint8_t e) {
+  if (a != 1 || e != 0) {
+    return ObisField::NONE;
+  }
+  if (c == 16 && d == 7) {
+    return ObisField::POWER;
+  }
+  if (d == 8 && c == 1) {
+    return ObisField::IMPORT;
+  }
+  if (d == 8 && c == 2) {
+    return ObisField::EXPORT;
+  }
+  return ObisField::NONE;
+}
+
+void clearMeterReading(MeterReading &reading) {
+  reading.powerW = NAN;
+  reading.importWh = NAN;
+  reading.exportWh = NAN;
+}
+
+// Store a decoded register value in the matching field of a reading.
+static void storeField(MeterReading &reading, ObisField field, double value) {
+  switch (field) {
+  case ObisField::POWER:
+    reading.powerW = static_cast<float>(value);
+    break;
+  case ObisField::IMPORT:
+    reading.importWh = value;
+    break;
+  case ObisField::EXPORT:
+    reading.exportWh = value;
+    break;
+  case ObisField::NONE:
+    break;
+  }
+}
+
+// --- SML ---------------------------------------------------------------------
+
+SmlParser::SmlParser() : crcErrors_(0) {
+  clearMeterReading(reading_);
+  reading_.sequence = 0;
+  reset();
+}
+
+void SmlParser::reset() {
+  state_ = State::SEARCH;
+  matched_ = 0;
+  escCount_ = 0;
+  escLen_ = 0;
+}
+
+// Reset the decoder at the beginning of a transport frame.  The CRC covers
+// the start sequence itself.
+void SmlParser::startFrame() {
+  state_ = State::DATA;
+  escCount_ = 0;
+  escLen_ = 0;
+  crc_ = 0xffff;
+  for (uint8_t b : SML_START) {
+    crc_ = crc16X25Update(crc_, b);
+  }
+  inTl_ = false;
+  payloadLeft_ = 0;
+  depth_ = 0;
+  entryDepth_ = 0;
+  frameError_ = false;
+  clearMeterReading(pending_);
+}
+
+bool SmlParser::feed(uint8_t b) {
+  switch (state_) {
+  case State::SEARCH:
+    if (b == SML_START[matched_]) {
+      ++matched_;
+    } else if (b == 0x1b) {
+      // A fifth escape byte keeps the four already matched.
+      matched_ = (matched_ == 4) ? 4 : 1;
+    } else {
+      matched_ = 0;
+    }
+    if (matched_ == sizeof(SML_START)) {
+      matched_ = 0;
+      startFrame();
+    }
+    return false;
+
+  case State::DATA:
+    crc_ = crc16X25Update(crc_, b);
+    if (b == 0x1b) {
+      if (++escCount_ == 4) {
+        escCount_ = 0;
+        escLen_ = 0;
+        state_ = State::ESCAPE;
+      }
+      return false;
+    }
+    // Fewer than four 0x1b bytes are ordinary payload.
+    for (; escCount_ > 0; --escCount_) {
+      decode(0x1b);
+    }
+    decode(b);
+    return false;
+
+  case State::ESCAPE:
+    escBuf_[escLen_++] = b;
+    // The two CRC bytes of the end sequence are not part of the checksum.
+    if (escBuf_[0] != 0x1a || escLen_ <= 2) {
+      crc_ = crc16X25Update(crc_, b);
+    }
+    if (escLen_ < 4) {
+      if (escBuf_[0] != 0x1a && escBuf_[0] != 0x1b && escBuf_[0] != 0x01) {
+        reset(); // unknown escape — drop the frame and resynchronise
+      }
+      return false;
+    }
+    if (escBuf_[0] == 0x1b) {
+      // Escaped escape sequence: four literal 0x1b payload bytes.
+      for (uint8_t i = 0; i < 4; ++i) {
+        decode(0x1b);
+      }
+      state_ = State::DATA;
+      return false;
+    }
+    if (escBuf_[0] == 0x01) {
+      // A new start sequence without a preceding end; restart the frame.
+      if (escBuf_[1] == 0x01 && escBuf_[2] == 0x01 && escBuf_[3] == 0x01) {
+        startFrame();
+      } else {
+        reset();
+      }
+      return false;
+    }
+    {
+      uint16_t crc = crc_ ^ 0xffff;
+      bool crcOk = escBuf_[2] == (crc & 0xff) && escBuf_[3] == (crc >> 8);
+      reset();
+      if (!crcOk || frameError_) {
+        ++crcErrors_;
+        return false;
+      }
+      uint32_t seq = reading_.sequence + 1;
+      reading_ = pending_;
+      reading_.sequence = seq;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Decode one payload byte of the SML TL (type-length) encoding.  Lists are
+ * tracked on a small stack of remaining element counts; scalars are
+ * accumulated into ``value_`` or ``octets_`` until complete.
+ */
+void SmlParser::decode(uint8_t b) {
+  if (payloadLeft_ > 0) {
+    if (tlType_ == 0) {
+      if (payloadLen_ < sizeof(octets_)) {
+        octets_[payloadLen_] = b;
+      }
+    } else {
+      value_ = (value_ << 8) | b;
+    }
+    ++payloadLen_;
+    if (--payloadLeft_ == 0) {
+      elementDone(tlType_, payloadLen_);
+    }
+    return;
+  }
+  if (!inTl_) {
+    if (b == 0x00) {
+      // EndOfSmlMsg closes the message list; outside a list it is one of
+      // the fill bytes before the end sequence.
+      if (depth_ != 0) {
+        elementDone(0, 0);
+      }
+      return;
+    }
+    tlType_ = (b >> 4) & 0x07;
+    tlLen_ = b & 0x0f;
+    tlBytes_ = 1;
+  } else {
+    tlLen_ = (tlLen_ << 4) | (b & 0x0f);
+    ++tlBytes_;
+  }
+  inTl_ = (b & 0x80) != 0;
+  if (inTl_) {
+    return;
+  }
+
+  if (tlType_ == 7) {
+    // List: the length is the number of contained elements.
+    if (tlLen_ == 0) {
+      elementDone(7, 0);
+      return;
+    }
+    if (depth_ >= MAX_DEPTH) {
+      frameError_ = true;
+      return;
+    }
+    remaining_[depth_++] = tlLen_;
+    if (tlLen_ == 7) {
+      // SML_ListEntry: objName, status, valTime, unit, scaler, value,
+      // valueSignature.  Only confirmed once objName is a 6-byte OBIS code.
+      entryDepth_ = depth_;
+      entryIndex_ = 0;
+      entryField_ = ObisField::NONE;
+      entryScaler_ = 0;
+      entryHasValue_ = false;
+    }
+    return;
+  }
+
+  // Scalar: the length includes the TL bytes themselves.
+  payloadLeft_ = tlLen_ > tlBytes_ ? tlLen_ - tlBytes_ : 0;
+  payloadLen_ = 0;
+  value_ = 0;
+  if (payloadLeft_ == 0) {
+    elementDone(tlType_, 0);
+  }
+}
+
+void SmlParser::elementDone(uint8_t type, uint16_t len) {
+  if (entryDepth_ != 0 && depth_ == entryDepth_) {
+    switch (entryIndex_) {
+    case 0:
+      if (type == 0 && len == 6) {
+        entryField_ = lookupObis(octets_[0], octets_[2], octets_[3], octets_[4]);
+      } else {
+        entryDepth_ = 0; // not a list entry
+      }
+      break;
+    case 4:
+      if (type == 5 && len == 1) {
+        entryScaler_ = static_cast<int8_t>(value_);
+      }
+      break;
+    case 5:
+      if ((type == 5 || type == 6) && len > 0 && len <= 8) {
+        if (type == 5) {
+          // Sign-extend the big-endian two's complement integer.
+          int64_t v = static_cast<int64_t>(value_);
+          if (len < 8 && (value_ & (1ULL << (len * 8 - 1)))) {
+            v = static_cast<int64_t>(value_ | (~0ULL << (len * 8)));
+          }
+          entryValue_ = static_cast<double>(v);
+        } else {
+          entryValue_ = static_cast<double>(value_);
+        }
+        entryHasValue_ = true;
+      }
+      break;
+    default:
+      break;
+    }
+    ++entryIndex_;
+  }
+
+  // Account for the element in the enclosing lists; a list that becomes
+  // complete is itself an element of its parent.
+  while (depth_ > 0) {
+    if (--remaining_[depth_ - 1] != 0) {
+      return;
+    }
+    if (entryDepth_ == depth_) {
+      commitEntry();
+      entryDepth_ = 0;
+    }
+    --depth_;
+    if (entryDepth_ != 0 && depth_ == entryDepth_) {
+      ++entryIndex_;
+    }
+  }
+}
+
+void SmlParser::commitEntry() {
+  if (entryField_ == ObisField::NONE || !entryHasValue_) {
+    return;
+  }
+  double v = entryValue_;
+  for (int8_t s = entryScaler_; s > 0; --s) {
+    v *= 10.0;
+  }
+  for (int8_t s = entryScaler_; s < 0; ++s) {
+    v /= 10.0;
+  }
+  storeField(pending_, entryField_, v);
+}
+
+// --- D0 ----------------------------------------------------------------------
+
+D0Parser::D0Parser() : crcErrors_(0) {
+  clearMeterReading(reading_);
+  reading_.sequence = 0;
+  reset();
+}
+
+void D0Parser::reset() {
+  lineLen_ = 0;
+  inTelegram_ = false;
+  framed_ = false;
+  awaitBcc_ = false;
+  complete_ = false;
+  clearMeterReading(pending_);
+}
+
+bool D0Parser::commit() {
+  uint32_t seq = reading_.sequence + 1;
+  reading_ = pending_;
+  reading_.sequence = seq;
+  reset();
+  return true;
+}
+
+bool D0Parser::feed(uint8_t b) {
+  b &= 0x7f; // strip the parity bit when the UART runs 8N1 on a 7E1 line
+  if (awaitBcc_) {
+    bool ok = complete_ && b == bcc_;
+    if (!ok) {
+      ++crcErrors_;
+      reset();
+      return false;
+    }
+    return commit();
+  }
+  if (b == 0x02) {
+    // STX: mode C data block; the BCC covers everything after it.
+    reset();
+    inTelegram_ = true;
+    framed_ = true;
+    bcc_ = 0;
+    return false;
+  }
+  if (framed_) {
+    bcc_ ^= b;
+    if (b == 0x03) {
+      awaitBcc_ = true;
+      return false;
+    }
+  }
+  if (b == '/') {
+    // Identification line of a new telegram.
+    reset();
+    inTelegram_ = true;
+    return false;
+  }
+  if (!inTelegram_) {
+    return false;
+  }
+  if (b == '!') {
+    if (framed_) {
+      complete_ = true;
+      return false;
+    }
+    return commit();
+  }
+  if (b == '\n') {
+    line_[lineLen_] = '\0';
+    parseLine();
+    lineLen_ = 0;
+  } else if (b != '\r' && lineLen_ < LINE_MAX - 1) {
+    line_[lineLen_++] = static_cast<char>(b);
+  }
+  return false;
+}
+
+/*
+ * Parse one data line such as ``1-0:1.8.0*255(001234.5678*kWh)``.  The
+ * short form ``1.8.0(…)`` without medium and channel is accepted as well.
+ */
+void D0Parser::parseLine() {
+  char *open = strchr(line_, '(');
+  if (!open) {
+    return;
+  }
+  *open = '\0';
+  char *p = line_;
+  uint8_t a = 1;
+  char *colon = strchr(line_, ':');
+  if (colon) {
+    a = static_cast<uint8_t>(strtoul(line_, nullptr, 10));
+    p = colon + 1;
+  }
+  uint8_t cde[3] = {0, 0, 0};
+  for (uint8_t i = 0; i < 3; ++i) {
+    char *end;
+    cde[i] = static_cast<uint8_t>(strtoul(p, &end, 10));
+    if (end == p) {
+      return;
+    }
+    p = (*end == '.') ? end + 1 : end;
+  }
+  ObisField field = lookupObis(a, cde[0], cde[1], cde[2]);
+  if (field == ObisField::NONE) {
+    return;
+  }
+  char *end;
+  double value = strtod(open + 1, &end);
+  if (end == open + 1) {
+    return;
+  }
+  // Units are normalised to W and Wh.
+  if (*end == '*' && (end[1] == 'k' || end[1] == 'K')) {
+    value *= 1000.0;
+  }
+  storeField(pending_, field, value);
+}
@@ -0,0 +1,138 @@
+/*
+  -----------------------------------------------------------------------------
+  meter_parsers.h — Streaming parsers for optical smart-meter interfaces
+
+  Many German electricity meters (eHZ, EasyMeter, ISKRA, EMH …) only expose
+  their registers through the optical infrared port on the front panel.  Two
+  wire formats are common:
+
+    • SML (Smart Message Language) — a binary, TLV encoded format framed by
+      ``1b1b1b1b 01010101`` … ``1b1b1b1b 1a xx crc crc`` escape sequences.
+    • D0 / IEC 62056-21 — an ASCII telegram starting with ``/`` and ending
+      with ``!`` where each line carries one OBIS register, e.g.
+      ``1-0:1.8.0*255(001234.5678*kWh)``.
+
+  Both parsers below are fed one byte at a time straight from the UART and
+  never allocate memory.  A telegram only updates the published reading after
+  its checksum (CRC-16/X.25 for SML, BCC for D0 mode C) has been verified, so
+  a corrupted frame can never produce a bogus value on the display.
+
+  The code in this file is plain C++ without Arduino dependencies so that it
+  can be exercised on a Linux host (see ``tools/sml_dump.cpp``).
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Registers published by a meter telegram.  Values that were not part of
+// the last telegram are NaN.
+struct MeterReading {
+  float powerW;     // 1-0:16.7.0 instantaneous active power (import > 0)
+  double importWh;  // 1-0:1.8.0 total energy drawn from the grid
+  double exportWh;  // 1-0:2.8.0 total energy fed into the grid
+  uint32_t sequence; // incremented for every validated telegram
+};
+
+// Register a telegram value is stored in.
+enum class ObisField : uint8_t { NONE, POWER, IMPORT, EXPORT };
+
+// Map the C.D.E groups of an OBIS code to the register it describes.  Only
+// electricity (A = 1) registers are recognised.
+ObisField lookupObis(uint8_t a, uint8_t c, uint8_t d, uint8_t e);
+
+// Reset a reading to "no data".
+void clearMeterReading(MeterReading &reading);
+
+/*
+ * Streaming SML 1.04 parser.  Call ``feed()`` for every received byte; the
+ * function returns true once a complete, CRC-valid transport frame has been
+ * decoded and ``reading()`` has been updated.
+ */
+class SmlParser {
+public:
+  SmlParser();
+  void reset();
+  bool feed(uint8_t b);
+  const MeterReading &reading() const { return reading_; }
+  uint32_t crcErrors() const { return crcErrors_; }
+
+private:
+  static constexpr uint8_t MAX_DEPTH = 12;
+
+  enum class State : uint8_t { SEARCH, DATA, ESCAPE };
+
+  void startFrame();
+  void decode(uint8_t b);
+  void elementDone(uint8_t type, uint16_t len);
+  void commitEntry();
+
+  // Transport layer
+  State state_;
+  uint8_t matched_;      // bytes of the start sequence matched so far
+  uint8_t escCount_;     // consecutive 0x1b bytes seen inside a frame
+  uint8_t escBuf_[4];    // bytes following an escape sequence
+  uint8_t escLen_;
+  uint16_t crc_;
+  bool frameError_;
+
+  // TL decoder
+  bool inTl_;
+  uint8_t tlType_;
+  uint16_t tlLen_;
+  uint8_t tlBytes_;
+  uint16_t payloadLeft_;
+  uint16_t payloadLen_;
+  uint64_t value_;
+  uint8_t octets_[6];
+  uint8_t depth_;
+  uint16_t remaining_[MAX_DEPTH];
+
+  // Current SML_ListEntry candidate (a list of seven elements)
+  uint8_t entryDepth_;   // 0 when no entry is being decoded
+  uint8_t entryIndex_;
+  ObisField entryField_;
+  int8_t entryScaler_;
+  bool entryHasValue_;
+  double entryValue_;
+
+  MeterReading pending_;
+  MeterReading reading_;
+  uint32_t crcErrors_;
+};
+
+/*
+ * Streaming D0 (IEC 62056-21) parser for meters in push mode or mode C
+ * readout.  Returns true from ``feed()`` when a telegram terminated by ``!``
+ * (and, if framed by STX/ETX, a matching BCC) has been decoded.
+ */
+class D0Parser {
+public:
+  D0Parser();
+  void reset();
+  bool feed(uint8_t b);
+  const MeterReading &reading() const { return reading_; }
+  uint32_t crcErrors() const { return crcErrors_; }
+
+private:
+  static constexpr size_t LINE_MAX = 80;
+
+  void parseLine();
+  bool commit();
+
+  char line_[LINE_MAX];
+  uint8_t lineLen_;
+  bool inTelegram_;
+  bool framed_;       // telegram started with STX and ends with ETX + BCC
+  bool awaitBcc_;
+  bool complete_;
+  uint8_t bcc_;
+  MeterReading pending_;
+  MeterReading reading_;
+  uint32_t crcErrors_;
+};
+
+// CRC-16/X.25 as used by the SML transport layer.
+uint16_t crc16X25Update(uint16_t crc, uint8_t b);
@@ -0,0 +1,92 @@
+#include "optical_meter.h"
+
+#include <atomic>
+
+// UART settings of the optical read head.  Most SML meters push at
+// 9600 baud 8N1; D0 meters in push mode usually use 9600 baud 7E1.
+#ifndef METER_UART_RX_PIN
+#define METER_UART_RX_PIN 22
+#endif
+#ifndef METER_UART_TX_PIN
+#define METER_UART_TX_PIN -1
+#endif
+#ifndef METER_UART_BAUD
+#define METER_UART_BAUD 9600
+#endif
+// Set to 1 for meters that send ASCII D0 (IEC 62056-21) telegrams.
+#ifndef METER_PROTOCOL_D0
+#define METER_PROTOCOL_D0 0
+#endif
+
+static HardwareSerial &meterSerial = Serial2;
+static std::atomic<TaskHandle_t> meterTaskHandle(nullptr);
+// Set by stopOpticalMeter(); the task answers by giving ``meterExited``.
+static std::atomic<bool> meterStop(false);
+static SemaphoreHandle_t meterExited = nullptr;
+
+#if METER_PROTOCOL_D0
+static D0Parser parser;
+#else
+static SmlParser parser;
+#endif
+
+static void meterTask(void *) {
+  while (!meterStop.load()) {
+    int avail = meterSerial.available();
+    if (avail <= 0) {
+      vTaskDelay(1);
+      continue;
+    }
+    while (avail-- > 0) {
+      if (parser.feed(static_cast<uint8_t>(meterSerial.read()))) {
+        publishLiveReading(parser.reading());
+      }
+    }
+  }
+  meterTaskHandle.store(nullptr);
+  xSemaphoreGive(meterExited);
+  vTaskDelete(nullptr);
+}
+
+bool beginOpticalMeter() {
+  if (meterTaskHandle.load()) {
+    return true;
+  }
+  if (!meterExited) {
+    meterExited = xSemaphoreCreateBinary();
+  }
+  beginLiveSource();
+  meterSerial.setRxBufferSize(1024);
+#if METER_PROTOCOL_D0
+  meterSerial.begin(METER_UART_BAUD, SERIAL_7E1, METER_UART_RX_PIN,
+                    METER_UART_TX_PIN);
+#else
+  meterSerial.begin(METER_UART_BAUD, SERIAL_8N1, METER_UART_RX_PIN,
+                    METER_UART_TX_PIN);
+#endif
+  meterStop.store(false);
+  // Priority above the Arduino loop task so telegrams are decoded as soon
+  // as they arrive, even while the display is being redrawn.
+  TaskHandle_t task = nullptr;
+  if (xTaskCreatePinnedToCore(meterTask, "meter", 3072, nullptr, 2, &task, 0) !=
+      pdPASS) {
+    Serial.println("Failed to start meter task");
+    meterSerial.end();
+    return false;
+  }
+  meterTaskHandle.store(task);
+  Serial.println("Optical meter reader started");
+  return true;
+}
+
+void stopOpticalMeter() {
+  if (!meterTaskHandle.load()) {
+    return;
+  }
+  meterStop.store(true);
+  // The task checks the flag at least once per tick
+  xSemaphoreTake(meterExited, portMAX_DELAY);
+  meterSerial.end();
+  parser.reset();
+  Serial.println("Optical meter reader stopped");
+}
@@ -0,0 +1,29 @@
+/*
+  -----------------------------------------------------------------------------
+  optical_meter.h — UART data source for SML / D0 optical meter heads
+
+  An IR read head (e.g. the common "Hichi" or volkszähler heads) attached to
+  a spare UART delivers a telegram every one to four seconds.  A dedicated
+  FreeRTOS task reads the UART, feeds the streaming parsers from
+  ``meter_parsers.h`` and publishes each validated reading to the live
+  source pipeline (``live_source.h``) immediately, so the live power readout
+  lags the meter by only a few milliseconds.
+
+  For a bidirectional grid meter the export register is reported as
+  generation and the import register as consumption.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "live_source.h"
+
+// Start the UART and the reader task.  Returns false if the task could not
+// be created.
+bool beginOpticalMeter();
+
+// End the reader task and release the UART.  No reading is published
+// once this returns.
+void stopOpticalMeter();
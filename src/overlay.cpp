@@ -0,0 +1,51 @@
+#include "overlay.h"
+
+#include "display_mirror.h"
+
+OverlayLayer::OverlayLayer(TFT_eSPI &tft, size_t capacity)
+    : tft_(tft), pixels_(nullptr), capacity_(capacity), used_(0), count_(0) {}
+
+bool OverlayLayer::save(int32_t x, int32_t y, int32_t w, int32_t h) {
+  // Allocate on first use so the buffer does not exist before the display
+  // is running.
+  if (!pixels_) {
+    pixels_ = static_cast<uint16_t *>(malloc(capacity_ * sizeof(uint16_t)));
+    if (!pixels_) {
+      return false;
+    }
+  }
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    y = 0;
+  }
+  w = min<int32_t>(w, tft_.width() - x);
+  h = min<int32_t>(h, tft_.height() - y);
+  if (w <= 0 || h <= 0) {
+    return true;
+  }
+  size_t n = static_cast<size_t>(w) * h;
+  if (count_ == MAX_RECTS || used_ + n > capacity_) {
+    return false;
+  }
+  tft_.readRect(x, y, w, h, pixels_ + used_);
+  // Everything the caller draws stays inside the saved rectangles
+  markDisplayDirty(x, y, w, h);
+  rects_[count_++] = {static_cast<int16_t>(x), static_cast<int16_t>(y),
+                      static_cast<int16_t>(w), static_cast<int16_t>(h), used_};
+  used_ += n;
+  return true;
+}
+
+void OverlayLayer::restore() {
+  // Newest first, so overlapping rectangles end up with the original pixels.
+  while (count_ > 0) {
+    const Rect &r = rects_[--count_];
+    tft_.pushImage(r.x, r.y, r.w, r.h, pixels_ + r.offset);
+    markDisplayDirty(r.x, r.y, r.w, r.h);
+  }
+  used_ = 0;
+}
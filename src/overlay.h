@@ -0,0 +1,57 @@
+/*
+  -----------------------------------------------------------------------------
+  overlay.h — Transient drawing layer on top of the TFT contents
+
+  Elements such as the graph crosshair and its tooltip follow the finger and
+  must be redrawn many times per second.  Instead of repainting the whole
+  graph underneath for every move, ``save()`` reads back the pixels of each
+  rectangle the element will cover before it is drawn and ``restore()``
+  writes them back again.  A move therefore only transfers the pixels of
+  the element's own rectangles.
+
+  Reading back requires the display's MISO line (``TFT_MISO`` in the
+  TFT_eSPI setup), which is wired on the ESP32-2432S032C.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <TFT_eSPI.h>
+
+class OverlayLayer {
+public:
+  // ``capacity`` is the total number of pixels that can be saved at once.
+  OverlayLayer(TFT_eSPI &tft, size_t capacity);
+
+  // Save the pixels of a rectangle that is about to be drawn over.  The
+  // rectangle is clipped to the screen.  Returns false if the buffer is
+  // full; the caller should then not draw into the rectangle.
+  bool save(int32_t x, int32_t y, int32_t w, int32_t h);
+
+  // Write back all saved rectangles, newest first, and forget them.
+  void restore();
+
+  // Forget the saved pixels without writing them back, e.g. after the
+  // area underneath has been redrawn.
+  void discard() { count_ = 0; used_ = 0; }
+
+  bool empty() const { return count_ == 0; }
+
+private:
+  static constexpr size_t MAX_RECTS = 4;
+
+  struct Rect {
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+    size_t offset;
+  };
+
+  TFT_eSPI &tft_;
+  uint16_t *pixels_;
+  size_t capacity_;
+  size_t used_;
+  Rect rects_[MAX_RECTS];
+  uint8_t count_;
+};
@@ -0,0 +1,101 @@
+#include "png_writer.h"
+
+#include <string.h>
+
+static void putU32(uint8_t *p, uint32_t v) {
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+bool PngWriter::begin(uint16_t width, uint16_t height, DeflateSink sink,
+                      void *ctx) {
+  if (width == 0 || width > MAX_WIDTH || height == 0) {
+    return false;
+  }
+  sink_ = sink;
+  ctx_ = ctx;
+  width_ = width;
+  idatLen_ = 0;
+  static const uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  sink_(ctx_, SIGNATURE, sizeof(SIGNATURE));
+  uint8_t ihdr[13];
+  putU32(ihdr, width);
+  putU32(ihdr + 4, height);
+  ihdr[8] = 8;  // bits per channel
+  ihdr[9] = 2;  // truecolour RGB
+  ihdr[10] = 0; // deflate
+  ihdr[11] = 0; // adaptive filtering
+  ihdr[12] = 0; // no interlace
+  writeChunk("IHDR", ihdr, sizeof(ihdr));
+  deflate_.begin(deflateSink, this, DeflateWriter::Format::ZLIB);
+  return true;
+}
+
+void PngWriter::writeChunk(const char *type, const uint8_t *data, size_t len) {
+  uint8_t head[8];
+  putU32(head, len);
+  memcpy(head + 4, type, 4);
+  uint32_t crc = crc32Update(0, head + 4, 4);
+  crc = crc32Update(crc, data, len);
+  uint8_t tail[4];
+  putU32(tail, crc);
+  sink_(ctx_, head, sizeof(head));
+  if (len > 0) {
+    sink_(ctx_, data, len);
+  }
+  sink_(ctx_, tail, sizeof(tail));
+}
+
+void PngWriter::flushIdat() {
+  if (idatLen_ > 0) {
+    writeChunk("IDAT", idat_, idatLen_);
+    idatLen_ = 0;
+  }
+}
+
+void PngWriter::deflateSink(void *ctx, const uint8_t *data, size_t len) {
+  PngWriter *self = static_cast<PngWriter *>(ctx);
+  while (len > 0) {
+    size_t n = sizeof(self->idat_) - self->idatLen_;
+    if (n > len) {
+      n = len;
+    }
+    memcpy(self->idat_ + self->idatLen_, data, n);
+    self->idatLen_ += n;
+    data += n;
+    len -= n;
+    if (self->idatLen_ == sizeof(self->idat_)) {
+      self->flushIdat();
+    }
+  }
+}
+
+void PngWriter::writeRows(const uint16_t *pixels, uint16_t rows) {
+  if (rows > MAX_BAND_ROWS) {
+    rows = MAX_BAND_ROWS;
+  }
+  // Expand to RGB888 with filter type 0.  The whole band is compressed in
+  // one call so identical rows (e.g. plain background) match each other.
+  uint8_t *out = rows_;
+  for (uint16_t r = 0; r < rows; ++r) {
+    *out++ = 0;
+    for (uint16_t x = 0; x < width_; ++x) {
+      uint16_t c = *pixels++;
+      uint8_t red = (c >> 11) & 0x1f;
+      uint8_t green = (c >> 5) & 0x3f;
+      uint8_t blue = c & 0x1f;
+      *out++ = (red << 3) | (red >> 2);
+      *out++ = (green << 2) | (green >> 4);
+      *out++ = (blue << 3) | (blue >> 2);
+    }
+  }
+  deflate_.write(rows_, out - rows_);
+}
+
+void PngWriter::finish() {
+  deflate_.finish();
+  flushIdat();
+  writeChunk("IEND", nullptr, 0);
+}
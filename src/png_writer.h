@@ -0,0 +1,50 @@
+/*
+  -----------------------------------------------------------------------------
+  png_writer.h — Streaming PNG encoder for RGB565 pixels
+
+  Encodes an image row band by row band, so a screenshot never needs more
+  than one band of pixels in RAM.  The image data is compressed with
+  ``DeflateWriter`` and emitted as a series of small IDAT chunks as soon as
+  the compressor produces output; the first bytes can therefore leave the
+  device before the last band has been read from the panel.
+
+  The code is plain C++ so it can be checked on a host.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "deflate.h"
+
+class PngWriter {
+public:
+  // Maximum rows passed to one ``writeRows()`` call.
+  static constexpr uint16_t MAX_BAND_ROWS = 8;
+  static constexpr uint16_t MAX_WIDTH = 320;
+
+  // Write the signature and header.  Returns false if the size is not
+  // supported.
+  bool begin(uint16_t width, uint16_t height, DeflateSink sink, void *ctx);
+
+  // Add ``rows`` rows of native RGB565 pixels, ``width`` pixels each.
+  void writeRows(const uint16_t *pixels, uint16_t rows);
+
+  // Flush the compressed data and write the trailing chunk.
+  void finish();
+
+private:
+  static void deflateSink(void *ctx, const uint8_t *data, size_t len);
+  void writeChunk(const char *type, const uint8_t *data, size_t len);
+  void flushIdat();
+
+  DeflateSink sink_;
+  void *ctx_;
+  uint16_t width_;
+  DeflateWriter deflate_;
+  uint8_t rows_[MAX_BAND_ROWS * (1 + 3 * MAX_WIDTH)];
+  uint8_t idat_[512];
+  size_t idatLen_;
+};
@@ -0,0 +1,112 @@
+#include "profiling.h"
+
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include "console.h"
+#endif
+
+static std::atomic<ProfileProbe *> probeList(nullptr);
+
+ProfileProbe::ProfileProbe(const char *name) : name_(name), next_(nullptr) {
+  reset();
+  // Function-local statics may be constructed from any task
+  ProfileProbe *head = probeList.load();
+  do {
+    next_ = head;
+  } while (!probeList.compare_exchange_weak(head, this));
+}
+
+void ProfileProbe::record(uint32_t ticks) {
+  size_t b = ticks ? 32 - __builtin_clz(ticks) : 0;
+  if (b >= BUCKETS) {
+    b = BUCKETS - 1;
+  }
+  ++buckets_[b];
+  ++count_;
+  total_ += ticks;
+  if (ticks < min_) {
+    min_ = ticks;
+  }
+  if (ticks > max_) {
+    max_ = ticks;
+  }
+}
+
+void ProfileProbe::reset() {
+  count_ = 0;
+  min_ = UINT32_MAX;
+  max_ = 0;
+  total_ = 0;
+  memset(buckets_, 0, sizeof(buckets_));
+}
+
+ProfileProbe *ProfileProbe::first() {
+  return probeList.load();
+}
+
+static float ticksPerUs() {
+#ifdef ARDUINO
+  return ESP.getCpuFreqMHz();
+#else
+  return 1000.0f;
+#endif
+}
+
+void profileReport(void (*emit)(const char *line)) {
+  const float perUs = ticksPerUs();
+  char line[80];
+  emit("probe                    count     min us     avg us     max us");
+  for (ProfileProbe *p = ProfileProbe::first(); p; p = p->next()) {
+    uint32_t count = p->count();
+    if (count == 0) {
+      continue;
+    }
+    snprintf(line, sizeof(line), "%-20s %9lu %10.1f %10.1f %10.1f", p->name(),
+             static_cast<unsigned long>(count), p->minTicks() / perUs,
+             static_cast<float>(p->totalTicks()) / count / perUs,
+             p->maxTicks() / perUs);
+    emit(line);
+    // Histogram: upper bound of each non-empty bucket and its share
+    for (size_t b = 0; b < ProfileProbe::BUCKETS; ++b) {
+      uint32_t n = p->bucket(b);
+      if (n == 0) {
+        continue;
+      }
+      float upper = static_cast<float>(1ULL << b) / perUs;
+      snprintf(line, sizeof(line), "    < %10.2f us %9lu  %5.1f %%", upper,
+               static_cast<unsigned long>(n), 100.0f * n / count);
+      emit(line);
+    }
+  }
+}
+
+void profileReset() {
+  for (ProfileProbe *p = ProfileProbe::first(); p; p = p->next()) {
+    p->reset();
+  }
+}
+
+#if defined(ARDUINO) && ENABLE_PROFILING
+static void printLine(const char *line) {
+  Serial.println(line);
+}
+
+// ``prof`` prints the probes, ``prof reset`` clears them.
+static void profCommand(char *args) {
+  if (strcmp(args, "reset") == 0) {
+    profileReset();
+    Serial.println("Probes reset");
+    return;
+  }
+  profileReport(printLine);
+}
+#endif
+
+void beginProfiling() {
+#if defined(ARDUINO) && ENABLE_PROFILING
+  registerConsoleCommand("prof", "show or reset profiling probes", profCommand);
+#endif
+}
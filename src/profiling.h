@@ -0,0 +1,113 @@
+/*
+  -----------------------------------------------------------------------------
+  profiling.h — Cycle-counting probes for hot paths
+
+  Put ``PROFILE_SCOPE("name");`` at the start of a function or block to
+  measure how long it takes every time it runs.  Each probe keeps the
+  count, minimum, maximum and total time plus a histogram with one bucket
+  per power of two, so rare slow runs stay visible next to the average.
+
+  On the ESP32 the time is taken from the CPU cycle counter
+  (``ESP.getCycleCount()``); on a host ``std::chrono::steady_clock`` in
+  nanoseconds is used, so the same probes work in host benchmarks.
+
+  Probes are only compiled in when ``ENABLE_PROFILING`` is 1, e.g. with
+  ``build_flags = -DENABLE_PROFILING=1``; otherwise the macro expands to
+  nothing.  The ``prof`` console command prints all probes and
+  ``prof reset`` clears them.  Probes are not locked: a probe entered from
+  two tasks at the same moment may lose a sample.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef ENABLE_PROFILING
+#define ENABLE_PROFILING 0
+#endif
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+// Current time in ticks (CPU cycles on the device, ns on a host).  Wraps
+// around; only differences are meaningful.
+inline uint32_t profileTicks() {
+#ifdef ARDUINO
+  return ESP.getCycleCount();
+#else
+  return static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+class ProfileProbe {
+public:
+  // Bucket ``b`` counts durations in [2^(b-1), 2^b) ticks.
+  static constexpr size_t BUCKETS = 32;
+
+  // Probes register themselves in a global list when constructed.
+  explicit ProfileProbe(const char *name);
+
+  void record(uint32_t ticks);
+  void reset();
+
+  const char *name() const { return name_; }
+  uint32_t count() const { return count_; }
+  uint32_t minTicks() const { return min_; }
+  uint32_t maxTicks() const { return max_; }
+  uint64_t totalTicks() const { return total_; }
+  uint32_t bucket(size_t b) const { return buckets_[b]; }
+
+  static ProfileProbe *first();
+  ProfileProbe *next() const { return next_; }
+
+private:
+  const char *name_;
+  ProfileProbe *next_;
+  uint32_t count_;
+  uint32_t min_;
+  uint32_t max_;
+  uint64_t total_;
+  uint32_t buckets_[BUCKETS];
+};
+
+// Records the time between construction and destruction.
+class ProfileScope {
+public:
+  explicit ProfileScope(ProfileProbe &probe)
+      : probe_(probe), start_(profileTicks()) {}
+  ~ProfileScope() { probe_.record(profileTicks() - start_); }
+
+private:
+  ProfileProbe &probe_;
+  uint32_t start_;
+};
+
+// Format every probe that has samples, one line at a time.
+void profileReport(void (*emit)(const char *line));
+
+// Clear the samples of all probes.
+void profileReset();
+
+// Register the ``prof`` console command (device only).
+void beginProfiling();
+
+#if ENABLE_PROFILING
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(name)                                                  \
+  static ProfileProbe PROFILE_CONCAT(profileProbe, __LINE__)(name);          \
+  ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(                       \
+      PROFILE_CONCAT(profileProbe, __LINE__))
+#else
+#define PROFILE_SCOPE(name) \
+  do {                      \
+  } while (0)
+#endif
@@ -0,0 +1,150 @@
+#include "range_api.h"
+
+#include <stdarg.h>
+#include <time.h>
+
+constexpr uint32_t RANGE_MIN_STEP_S = 60;
+constexpr size_t RANGE_MAX_POINTS = 4096;
+constexpr size_t RANGE_CHUNK_ROWS = 16;
+constexpr size_t RANGE_ROW_MAX = 80;
+// Values beyond this magnitude are not plausible readings and are sent as
+// null, which also bounds the width of every "%.1f".
+constexpr float RANGE_VALUE_LIMIT = 1e9f;
+
+static SemaphoreHandle_t historyMutex = nullptr;
+
+void lockHistory() {
+  if (historyMutex) {
+    xSemaphoreTake(historyMutex, portMAX_DELAY);
+  }
+}
+
+void unlockHistory() {
+  if (historyMutex) {
+    xSemaphoreGive(historyMutex);
+  }
+}
+
+// Parse an unsigned query argument, keeping ``value`` if it is absent.
+static bool parseArg(WebServer &server, const char *name, uint32_t &value) {
+  if (!server.hasArg(name)) {
+    return true;
+  }
+  String text = server.arg(name);
+  char *end = nullptr;
+  unsigned long v = strtoul(text.c_str(), &end, 10);
+  if (text.length() == 0 || *end != '\0') {
+    return false;
+  }
+  value = v;
+  return true;
+}
+
+// Append to the chunk being formatted in ``out``.  Returns false, leaving
+// ``n`` unchanged, if the text does not fit in ``cap``.
+static bool appendChunk(char *out, size_t cap, size_t &n, const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  int len = vsnprintf(out + n, cap - n, fmt, args);
+  va_end(args);
+  if (len < 0 || static_cast<size_t>(len) >= cap - n) {
+    return false;
+  }
+  n += len;
+  return true;
+}
+
+static bool appendValue(char *out, size_t cap, size_t &n, float v) {
+  if (!isfinite(v) || fabsf(v) >= RANGE_VALUE_LIMIT) {
+    return appendChunk(out, cap, n, ",null");
+  }
+  return appendChunk(out, cap, n, ",%.1f", v);
+}
+
+// Append one row to ``out``.  Returns false, leaving ``n`` unchanged, if
+// it does not fit.
+static bool appendRow(char *out, size_t cap, size_t &n, bool first, uint32_t t,
+                      float gen, float cons, const EnergyHistory::Envelope &e) {
+  size_t end = n;
+  if (!appendChunk(out, cap, end, "%s[%lu", first ? "" : ",",
+                   static_cast<unsigned long>(t)) ||
+      !appendValue(out, cap, end, gen) || !appendValue(out, cap, end, cons) ||
+      !appendValue(out, cap, end, e.genMin) || !appendValue(out, cap, end, e.genMax) ||
+      !appendValue(out, cap, end, e.consMin) || !appendValue(out, cap, end, e.consMax) ||
+      !appendChunk(out, cap, end, "]")) {
+    return false;
+  }
+  n = end;
+  return true;
+}
+
+static void sendRange(WebServer &server, const EnergyHistory &history) {
+  time_t now = time(nullptr);
+  uint32_t to = static_cast<uint32_t>(now);
+  uint32_t step = 3600;
+  if (!parseArg(server, "to", to) || !parseArg(server, "step", step)) {
+    server.send(400, "text/plain", "Invalid to or step\n");
+    return;
+  }
+  uint32_t from = to > 86400 ? to - 86400 : 0;
+  if (!parseArg(server, "from", from)) {
+    server.send(400, "text/plain", "Invalid from\n");
+    return;
+  }
+  if (step < RANGE_MIN_STEP_S || to <= from) {
+    server.send(400, "text/plain", "Need from < to and step >= 60\n");
+    return;
+  }
+  size_t count = (to - from) / step;
+  if (count == 0 || count > RANGE_MAX_POINTS) {
+    server.send(400, "text/plain", "Between 1 and 4096 steps allowed\n");
+    return;
+  }
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  char buf[RANGE_CHUNK_ROWS * RANGE_ROW_MAX];
+  int len = snprintf(buf, sizeof(buf),
+                     "{\"from\":%lu,\"step\":%lu,\"count\":%u,\"fields\":[\"t\","
+                     "\"gen\",\"cons\",\"gen_min\",\"gen_max\",\"cons_min\","
+                     "\"cons_max\"],\"data\":[",
+                     static_cast<unsigned long>(from),
+                     static_cast<unsigned long>(step),
+                     static_cast<unsigned>(count));
+  server.sendContent(buf, len);
+
+  float gen[RANGE_CHUNK_ROWS];
+  float cons[RANGE_CHUNK_ROWS];
+  EnergyHistory::Envelope envelope[RANGE_CHUNK_ROWS];
+  for (size_t i = 0; i < count; i += RANGE_CHUNK_ROWS) {
+    size_t rows = std::min(RANGE_CHUNK_ROWS, count - i);
+    uint32_t chunkFrom = from + i * step;
+    lockHistory();
+    history.query(chunkFrom, step, rows, gen, cons, envelope);
+    unlockHistory();
+    size_t n = 0;
+    for (size_t r = 0; r < rows; ++r) {
+      uint32_t t = chunkFrom + r * step;
+      if (appendRow(buf, sizeof(buf), n, i + r == 0, t, gen[r], cons[r], envelope[r])) {
+        continue;
+      }
+      // Wide rows: send what is there and start the chunk over.  A single
+      // row is bounded well below the buffer.
+      server.sendContent(buf, n);
+      n = 0;
+      appendRow(buf, sizeof(buf), n, i + r == 0, t, gen[r], cons[r], envelope[r]);
+    }
+    server.sendContent(buf, n);
+  }
+  server.sendContent("]}\n");
+  server.sendContent("");
+}
+
+void registerRangeRoute(WebServer &server, const EnergyHistory &history) {
+  if (!historyMutex) {
+    historyMutex = xSemaphoreCreateMutex();
+  }
+  WebServer *srv = &server;
+  const EnergyHistory *hist = &history;
+  srv->on("/api/range", HTTP_GET, [srv, hist]() { sendRange(*srv, *hist); });
+}
@@ -0,0 +1,33 @@
+/*
+  -----------------------------------------------------------------------------
+  range_api.h — Aggregated history over HTTP
+
+  GET /api/range?from=<unix>&to=<unix>&step=<seconds> returns the average,
+  minimum and maximum generation and consumption for every ``step`` seconds
+  of [from, to) from the RAM history, e.g.
+
+    {"from":1760000000,"step":3600,"count":2,
+     "fields":["t","gen","cons","gen_min","gen_max","cons_min","cons_max"],
+     "data":[[1760000000,412.0,130.5,412.0,412.0,130.5,130.5],
+             [1760003600,null,null,null,null,null,null]]}
+
+  ``to`` defaults to now, ``from`` to one day before ``to`` and ``step`` to
+  one hour.  The history picks the cheapest level for the step, and the
+  answer is produced a few rows at a time and sent with chunked encoding,
+  so a query needs the same small amount of memory whatever its length.
+
+  The handler runs in the web server task; code that changes the history
+  must hold ``lockHistory()``.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <WebServer.h>
+
+#include "history.h"
+
+void registerRangeRoute(WebServer &server, const EnergyHistory &history);
+
+void lockHistory();
+void unlockHistory();
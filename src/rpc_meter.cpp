@@ -0,0 +1,253 @@
+#include "rpc_meter.h"
+
+#include <ArduinoJson.h>
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include <atomic>
+
+#include "config_store.h"
+
+// Power is polled at this interval; the energy registers change slowly and
+// are refreshed less often.
+constexpr uint32_t RPC_POLL_INTERVAL_MS = 500;
+constexpr uint32_t RPC_ENERGY_INTERVAL_MS = 10UL * 1000UL;
+constexpr uint16_t RPC_TIMEOUT_MS = 1500;
+
+enum class RpcKind { SHELLY_PRO3EM, SHELLY_GEN1, SHELLY_PLUG, TASMOTA };
+
+// Request paths for a device kind.  ``energyPath`` is null when the power
+// response already carries the energy registers.
+struct RpcEndpoints {
+  const char *powerPath;
+  const char *energyPath;
+};
+
+static const RpcEndpoints RPC_ENDPOINTS[] = {
+    {"/rpc/EM.GetStatus?id=0", "/rpc/EMData.GetStatus?id=0"},
+    {"/status", nullptr},
+    {"/rpc/Switch.GetStatus?id=0", nullptr},
+    {"/cm?cmnd=Status%208", nullptr},
+};
+
+// Requests from other tasks, handled by the poll task between polls.
+enum RpcRequest : uint8_t { RPC_RUN, RPC_RELOAD, RPC_STOP };
+
+// Settings copied from the configuration when the task (re)loads them.
+static char rpcHost[CONFIG_STR_MAX];
+static RpcKind rpcKind = RpcKind::SHELLY_PRO3EM;
+static bool rpcGenerator = false;
+static std::atomic<uint8_t> rpcRequest(RPC_RUN);
+static std::atomic<TaskHandle_t> rpcTaskHandle(nullptr);
+// Given by the task as it ends, see stopRpcMeter().
+static SemaphoreHandle_t rpcExited = nullptr;
+
+// The client and HTTPClient live for the lifetime of the task so the TCP
+// connection is reused between polls.
+static WiFiClient rpcClient;
+static HTTPClient rpcHttp;
+
+static RpcKind parseKind(const char *kind) {
+  if (strcmp(kind, "shelly-gen1") == 0) {
+    return RpcKind::SHELLY_GEN1;
+  }
+  if (strcmp(kind, "shelly-plug") == 0) {
+    return RpcKind::SHELLY_PLUG;
+  }
+  if (strcmp(kind, "tasmota") == 0) {
+    return RpcKind::TASMOTA;
+  }
+  return RpcKind::SHELLY_PRO3EM;
+}
+
+/*
+ * Issue one GET over the persistent connection and parse the JSON body
+ * into ``doc``.  The response is parsed straight from the socket when the
+ * length is known; chunked responses fall back to a buffered read.
+ */
+static bool rpcGet(const char *path, JsonDocument &doc) {
+  rpcHttp.begin(rpcClient, rpcHost, 80, path);
+  int code = rpcHttp.GET();
+  if (code != HTTP_CODE_OK) {
+    Serial.printf("RPC meter request failed: %d\n", code);
+    rpcHttp.end();
+    return false;
+  }
+  DeserializationError err;
+  if (rpcHttp.getSize() > 0) {
+    err = deserializeJson(doc, rpcHttp.getStream());
+  } else {
+    err = deserializeJson(doc, rpcHttp.getString());
+  }
+  // end() keeps the socket open because reuse is enabled.
+  rpcHttp.end();
+  if (err) {
+    Serial.println("Failed to parse RPC meter response");
+    return false;
+  }
+  return true;
+}
+
+// Map the power response of the configured device kind into ``reading``.
+static bool mapPower(JsonDocument &doc, MeterReading &reading) {
+  switch (rpcKind) {
+  case RpcKind::SHELLY_PRO3EM:
+    reading.powerW = doc["total_act_power"] | NAN;
+    break;
+  case RpcKind::SHELLY_GEN1: {
+    JsonArray meters = doc["emeters"].as<JsonArray>();
+    if (meters.size() == 0) {
+      return false;
+    }
+    float power = 0.0f;
+    double total = 0.0;
+    double returned = 0.0;
+    for (size_t i = 0; i < meters.size(); ++i) {
+      power += meters[i]["power"] | 0.0f;
+      total += meters[i]["total"] | 0.0;
+      returned += meters[i]["total_returned"] | 0.0;
+    }
+    reading.powerW = power;
+    reading.importWh = total;
+    reading.exportWh = returned;
+    break;
+  }
+  case RpcKind::SHELLY_PLUG:
+    reading.powerW = doc["apower"] | NAN;
+    reading.importWh = doc["aenergy"]["total"] | NAN;
+    break;
+  case RpcKind::TASMOTA: {
+    JsonVariant energy = doc["StatusSNS"]["ENERGY"];
+    reading.powerW = energy["Power"] | NAN;
+    double totalKWh = energy["Total"] | NAN;
+    reading.importWh = totalKWh * 1000.0;
+    break;
+  }
+  }
+  return !isnan(reading.powerW);
+}
+
+/*
+ * A device that measures the inverter output reports generation as
+ * positive power and accumulated energy; swap it to the feed-in side of
+ * the pipeline.
+ */
+static void applyGenerator(MeterReading &reading) {
+  if (rpcGenerator) {
+    reading.powerW = -reading.powerW;
+    reading.exportWh = reading.importWh;
+    reading.importWh = NAN;
+  }
+}
+
+static void loadRpcSettings() {
+  configString(ConfigKey::RpcHost, rpcHost, sizeof(rpcHost));
+  char kind[CONFIG_STR_MAX];
+  configString(ConfigKey::RpcKind, kind, sizeof(kind));
+  rpcKind = parseKind(kind);
+  rpcGenerator = configUInt(ConfigKey::RpcGenerator) != 0;
+  Serial.printf("Polling %s meter at %s\n", kind, rpcHost);
+}
+
+static void rpcTask(void *) {
+  JsonDocument doc;
+  MeterReading reading;
+  clearMeterReading(reading);
+  double importWh = NAN;
+  double exportWh = NAN;
+  uint32_t lastEnergy = 0;
+  loadRpcSettings();
+  for (;;) {
+    uint8_t request = rpcRequest.exchange(RPC_RUN);
+    if (request != RPC_RUN) {
+      // The old connection may point at a different host.
+      rpcClient.stop();
+      if (request == RPC_STOP) {
+        break;
+      }
+      loadRpcSettings();
+      importWh = NAN;
+      exportWh = NAN;
+      lastEnergy = 0;
+    }
+    const RpcEndpoints &ep = RPC_ENDPOINTS[static_cast<int>(rpcKind)];
+    uint32_t start = millis();
+    if (WiFi.status() == WL_CONNECTED && rpcHost[0] != '\0') {
+      if (ep.energyPath &&
+          (lastEnergy == 0 || start - lastEnergy >= RPC_ENERGY_INTERVAL_MS) &&
+          rpcGet(ep.energyPath, doc)) {
+        importWh = doc["total_act"] | NAN;
+        exportWh = doc["total_act_ret"] | NAN;
+        lastEnergy = start;
+      }
+      clearMeterReading(reading);
+      if (rpcGet(ep.powerPath, doc) && mapPower(doc, reading)) {
+        if (ep.energyPath) {
+          reading.importWh = importWh;
+          reading.exportWh = exportWh;
+        }
+        applyGenerator(reading);
+        // A poll that overlapped a stop is dropped
+        if (rpcRequest.load() != RPC_STOP) {
+          publishLiveReading(reading);
+        }
+      }
+    }
+    uint32_t elapsed = millis() - start;
+    // Woken early by reloads and stops
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(elapsed < RPC_POLL_INTERVAL_MS
+                                              ? RPC_POLL_INTERVAL_MS - elapsed
+                                              : 10));
+  }
+  rpcTaskHandle.store(nullptr);
+  xSemaphoreGive(rpcExited);
+  vTaskDelete(nullptr);
+}
+
+bool beginRpcMeter() {
+  // stopRpcMeter() waits for the task, so a task that exists keeps running
+  if (rpcTaskHandle.load()) {
+    return true;
+  }
+  if (configString(ConfigKey::RpcHost).length() == 0) {
+    Serial.println("RPC meter host not configured");
+    return false;
+  }
+  if (!rpcExited) {
+    rpcExited = xSemaphoreCreateBinary();
+  }
+  beginLiveSource();
+  rpcRequest.store(RPC_RUN);
+  rpcHttp.setReuse(true);
+  rpcHttp.setTimeout(RPC_TIMEOUT_MS);
+  rpcHttp.setConnectTimeout(RPC_TIMEOUT_MS);
+  TaskHandle_t task = nullptr;
+  if (xTaskCreatePinnedToCore(rpcTask, "rpcmeter", 6144, nullptr, 1, &task, 0) !=
+      pdPASS) {
+    Serial.println("Failed to start RPC meter task");
+    return false;
+  }
+  rpcTaskHandle.store(task);
+  return true;
+}
+
+void restartRpcMeter() {
+  TaskHandle_t task = rpcTaskHandle.load();
+  if (task) {
+    rpcRequest.store(RPC_RELOAD);
+    xTaskNotifyGive(task);
+  } else {
+    beginRpcMeter();
+  }
+}
+
+void stopRpcMeter() {
+  TaskHandle_t task = rpcTaskHandle.load();
+  if (!task) {
+    return;
+  }
+  rpcRequest.store(RPC_STOP);
+  xTaskNotifyGive(task);
+  // Only the poll in progress remains, its requests time out after
+  // RPC_TIMEOUT_MS
+  xSemaphoreTake(rpcExited, portMAX_DELAY);
+}
@@ -0,0 +1,39 @@
+/*
+  -----------------------------------------------------------------------------
+  rpc_meter.h — Adapter for Shelly / Tasmota style local energy meters
+
+  Devices such as the Shelly Pro 3EM, Shelly 3EM (Gen1), Shelly Plus plugs
+  or Tasmota plugs answer small JSON RPC calls on the LAN within a few
+  milliseconds.  They do not provide the daily energy document expected by
+  ``fetchSmartmeterData()``, so this adapter polls their native endpoints
+  over a keep-alive connection several times per second and maps the
+  returned power and energy registers into the live source pipeline
+  (``live_source.h``).
+
+  The device is configured through the runtime settings
+  (``config_store.h``), whose defaults come from ``secrets.h``:
+    rpc_host      – IP address or hostname of the device (RPC_METER_HOST)
+    rpc_kind      – "shelly-pro3em", "shelly-gen1", "shelly-plug" or
+                    "tasmota" (RPC_METER_KIND)
+    rpc_generator – 1 if the device measures the inverter output rather
+                    than the grid connection (RPC_METER_GENERATOR)
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "live_source.h"
+
+// Start the polling task.  Returns false if the device is not configured
+// or the task could not be created.
+bool beginRpcMeter();
+
+// Make the task drop its connection and re-read the settings before the
+// next poll, e.g. after ``rpc_host`` changed.
+void restartRpcMeter();
+
+// Close the connection and end the polling task.  Waits for the task, so
+// no reading is published once this returns.
+void stopRpcMeter();
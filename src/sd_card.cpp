@@ -0,0 +1,209 @@
+/* --- sd_card.cpp — SD card mounting and buffered, sector-aligned file access --- */
+
+#include "sd_card.h"
+
+#include <SD.h>
+#include <SPI.h>
+#include <string.h>
+
+namespace {
+
+// SPI clocks the ESP32 derives exactly from its 80 MHz APB clock.
+constexpr uint32_t SD_CLOCKS_HZ[] = {40000000UL, 26666666UL, 20000000UL,
+                                     16000000UL, 10000000UL, 4000000UL};
+constexpr int SD_VERIFY_READS = 4;
+
+constexpr const char *SD_PROBE_PATH = "/.sdprobe";
+constexpr size_t SD_PROBE_BYTES = 64UL * 1024UL;
+constexpr size_t SD_PROBE_CHUNK = 4096;
+
+static_assert(SD_READ_AHEAD_BYTES % SD_SECTOR_SIZE == 0,
+              "SD_READ_AHEAD_BYTES must be a multiple of the sector size");
+
+uint32_t mountedHz = 0;
+
+// Read the boot sector several times and check that every copy carries
+// the boot signature and matches the first.
+bool bootSectorStable() {
+  uint8_t first[SD_SECTOR_SIZE];
+  uint8_t again[SD_SECTOR_SIZE];
+  if (!SD.readRAW(first, 0) || first[510] != 0x55 || first[511] != 0xAA) {
+    return false;
+  }
+  for (int i = 1; i < SD_VERIFY_READS; ++i) {
+    if (!SD.readRAW(again, 0) || memcmp(first, again, sizeof(first)) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32_t kbPerSecond(size_t bytes, uint32_t us) {
+  return us ? static_cast<uint32_t>(static_cast<uint64_t>(bytes) * 1000000ULL /
+                                    1024ULL / us)
+            : 0;
+}
+
+}  // namespace
+
+bool mountSdCard(SPIClass &spi) {
+  mountedHz = 0;
+  for (uint32_t hz : SD_CLOCKS_HZ) {
+    if (hz > SD_MAX_CLOCK_HZ) {
+      continue;
+    }
+    // The card is initialised at 400 kHz whatever the clock, so a failed
+    // begin() means there is no usable card rather than a too fast clock.
+    if (!SD.begin(SD_CS, spi, hz)) {
+      Serial.println("SD init failed");
+      return false;
+    }
+    if (SD.cardType() == CARD_NONE) {
+      Serial.println("No SD card attached");
+      SD.end();
+      return false;
+    }
+    if (bootSectorStable()) {
+      mountedHz = hz;
+      Serial.printf("SD card detected, running at %lu kHz\n",
+                    static_cast<unsigned long>(hz / 1000));
+      return true;
+    }
+    Serial.printf("SD card unreliable at %lu kHz\n",
+                  static_cast<unsigned long>(hz / 1000));
+    SD.end();
+  }
+  Serial.println("SD card unreadable at every clock");
+  return false;
+}
+
+uint32_t sdClockHz() { return mountedHz; }
+
+void probeSdSpeed() {
+  if (!mountedHz) {
+    return;
+  }
+  std::vector<uint8_t> chunk(SD_PROBE_CHUNK);
+  fs::File f = SD.open(SD_PROBE_PATH, FILE_WRITE);
+  if (!f) {
+    Serial.println("SD speed probe: cannot create scratch file");
+    return;
+  }
+  uint32_t start = micros();
+  bool ok = true;
+  for (size_t off = 0; ok && off < SD_PROBE_BYTES; off += SD_PROBE_CHUNK) {
+    for (size_t i = 0; i < SD_PROBE_CHUNK; ++i) {
+      chunk[i] = static_cast<uint8_t>(i ^ (off >> 12));
+    }
+    ok = f.write(chunk.data(), SD_PROBE_CHUNK) == SD_PROBE_CHUNK;
+  }
+  f.close();
+  uint32_t writeUs = micros() - start;
+
+  SdReader reader;
+  if (ok && reader.open(SD_PROBE_PATH)) {
+    start = micros();
+    for (size_t off = 0; ok && off < SD_PROBE_BYTES; off += SD_PROBE_CHUNK) {
+      ok = reader.read(chunk.data(), SD_PROBE_CHUNK) == SD_PROBE_CHUNK;
+      for (size_t i = 0; ok && i < SD_PROBE_CHUNK; ++i) {
+        ok = chunk[i] == static_cast<uint8_t>(i ^ (off >> 12));
+      }
+    }
+    reader.close();
+  } else {
+    ok = false;
+  }
+  uint32_t readUs = micros() - start;
+  SD.remove(SD_PROBE_PATH);
+
+  if (!ok) {
+    Serial.println("SD speed probe: scratch file did not read back intact");
+    return;
+  }
+  Serial.printf("SD speed at %lu kHz: write %lu KB/s, read %lu KB/s\n",
+                static_cast<unsigned long>(mountedHz / 1000),
+                static_cast<unsigned long>(kbPerSecond(SD_PROBE_BYTES, writeUs)),
+                static_cast<unsigned long>(kbPerSecond(SD_PROBE_BYTES, readUs)));
+}
+
+bool SdReader::open(const char *path) {
+  close();
+  file_ = SD.open(path, FILE_READ);
+  if (!file_) {
+    return false;
+  }
+  size_ = file_.size();
+  buf_.resize(SD_READ_AHEAD_BYTES);
+  return true;
+}
+
+void SdReader::close() {
+  if (file_) {
+    file_.close();
+  }
+  std::vector<uint8_t>().swap(buf_);
+  bufStart_ = 0;
+  bufLen_ = 0;
+  pos_ = 0;
+  filePos_ = 0;
+  size_ = 0;
+}
+
+bool SdReader::seek(uint32_t pos) {
+  if (!file_ || pos > size_) {
+    return false;
+  }
+  pos_ = pos;
+  return true;
+}
+
+// Read ``n`` bytes at ``at`` from the file, seeking only when needed.
+size_t SdReader::readFile(uint8_t *dst, uint32_t at, size_t n) {
+  if (filePos_ != at && !file_.seek(at)) {
+    return 0;
+  }
+  size_t got = file_.read(dst, n);
+  filePos_ = at + got;
+  return got;
+}
+
+// Load the sector-aligned block containing the current position.
+bool SdReader::fill() {
+  bufStart_ = pos_ - pos_ % SD_SECTOR_SIZE;
+  bufLen_ = readFile(buf_.data(), bufStart_, buf_.size());
+  return pos_ < bufStart_ + bufLen_;
+}
+
+size_t SdReader::read(uint8_t *dst, size_t n) {
+  if (!file_) {
+    return 0;
+  }
+  n = std::min<size_t>(n, size_ - pos_);
+  size_t done = 0;
+  while (done < n) {
+    if (pos_ >= bufStart_ && pos_ < bufStart_ + bufLen_) {
+      size_t take = std::min<size_t>(n - done, bufStart_ + bufLen_ - pos_);
+      memcpy(dst + done, buf_.data() + (pos_ - bufStart_), take);
+      done += take;
+      pos_ += take;
+      continue;
+    }
+    size_t left = n - done;
+    if (pos_ % SD_SECTOR_SIZE == 0 && left >= buf_.size()) {
+      // Large aligned request: read whole sectors straight into the
+      // caller's buffer and leave the rest to the read-ahead buffer.
+      size_t direct = left - left % SD_SECTOR_SIZE;
+      size_t got = readFile(dst + done, pos_, direct);
+      done += got;
+      pos_ += got;
+      if (got < direct) {
+        break;
+      }
+      continue;
+    }
+    if (!fill()) {
+      break;
+    }
+  }
+  return done;
+}
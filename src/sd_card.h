@@ -0,0 +1,88 @@
+/*
+  -----------------------------------------------------------------------------
+  sd_card.h — SD card mounting and buffered, sector-aligned file access
+
+  ``SD.begin()`` with its defaults runs the card at 4 MHz on the global
+  ``SPI`` object.  ``mountSdCard()`` instead tries the SPI clocks the ESP32
+  can derive from its 80 MHz APB clock, from ``SD_MAX_CLOCK_HZ`` downwards,
+  and keeps the fastest one at which the boot sector reads back
+  identically several times in a row.
+
+  The card is mounted on the SPI object passed in.  When the card sits on
+  the display's bus this must be the display's own ``SPIClass`` so both
+  drivers take the same bus lock and the display is never driven while a
+  card transaction is in progress.  The card stays mounted while the
+  firmware runs.  The bus lock only covers single transfers, so after boot
+  the card is read with ``lockDisplay()`` held as well; no transfer then
+  falls into the middle of a drawing sequence.
+
+  ``SdReader`` reads a file through a read-ahead buffer of
+  ``SD_READ_AHEAD_BYTES`` that always starts on a sector boundary, so the
+  FAT driver fills it with a single multi-block read straight from the
+  card.  Requests at least as large as the buffer bypass it and go to the
+  card directly, again in whole sectors where possible.
+
+  ``probeSdSpeed()`` writes and reads back a scratch file in the same
+  sector-aligned chunks and logs the measured throughput.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <vector>
+
+class SPIClass;
+
+#ifndef SD_CS
+#define SD_CS 5
+#endif
+
+#ifndef SD_MAX_CLOCK_HZ
+#define SD_MAX_CLOCK_HZ 40000000UL
+#endif
+
+#ifndef SD_READ_AHEAD_BYTES
+#define SD_READ_AHEAD_BYTES 4096
+#endif
+
+// Set to 0 to skip the throughput measurement at boot.
+#ifndef SD_SPEED_PROBE
+#define SD_SPEED_PROBE 1
+#endif
+
+constexpr size_t SD_SECTOR_SIZE = 512;
+
+// Mount the card on ``spi`` at the fastest clock that reads reliably.
+bool mountSdCard(SPIClass &spi);
+
+// Clock the card was mounted at, 0 if it is not mounted.
+uint32_t sdClockHz();
+
+// Measure and log write and read throughput with a scratch file.
+void probeSdSpeed();
+
+class SdReader {
+public:
+  bool open(const char *path);
+  void close();
+  bool isOpen() const { return file_ ? true : false; }
+
+  size_t read(uint8_t *dst, size_t n);
+  bool seek(uint32_t pos);
+  uint32_t position() const { return pos_; }
+  uint32_t size() const { return size_; }
+
+private:
+  bool fill();
+  size_t readFile(uint8_t *dst, uint32_t at, size_t n);
+
+  fs::File file_;
+  std::vector<uint8_t> buf_;
+  uint32_t bufStart_ = 0;   // file offset of buf_[0], sector aligned
+  size_t bufLen_ = 0;
+  uint32_t pos_ = 0;        // position seen by the caller
+  uint32_t filePos_ = 0;    // position of the underlying file
+  uint32_t size_ = 0;
+};
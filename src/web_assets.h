@@ -0,0 +1,190 @@
+/*
+  Generated by tools/embed_assets.py from web/ -- do not edit.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+struct WebAsset {
+  const char *path;
+  const char *type;
+  const uint8_t *gzip;
+  size_t length;
+  const char *etag;
+  bool immutable;  // name contains the content hash
+};
+
+static const uint8_t WEB_ASSET_0[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xa5, 0x54, 0x5d, 0x6f, 0xd3, 0x30,
+    0x14, 0x7d, 0xdf, 0xaf, 0x30, 0x7e, 0x26, 0x4d, 0xc6, 0x4a, 0xd6, 0x21, 0x27, 0x0f, 0x0c, 0xb4,
+    0x17, 0x10, 0x48, 0x9b, 0x84, 0x78, 0xbc, 0xb1, 0x6f, 0x1b, 0x33, 0xd7, 0x89, 0x6c, 0xb7, 0xa5,
+    0xff, 0x9e, 0xeb, 0x38, 0xe9, 0x5a, 0x56, 0x0d, 0x10, 0x55, 0xa5, 0x24, 0xf7, 0x1e, 0x9f, 0x73,
+    0x72, 0x3f, 0x22, 0x5e, 0x7d, 0xf8, 0x72, 0xfb, 0xf0, 0xfd, 0xeb, 0x47, 0xd6, 0x86, 0xb5, 0xa9,
+    0x2f, 0x44, 0xbc, 0x30, 0x03, 0x76, 0x55, 0x71, 0xb4, 0x3c, 0x06, 0x10, 0x14, 0x5d, 0xd6, 0x18,
+    0x80, 0xc9, 0x16, 0x9c, 0xc7, 0x50, 0xf1, 0x4d, 0x58, 0x66, 0x0b, 0x3e, 0x85, 0x2d, 0xac, 0xb1,
+    0xe2, 0x5b, 0x8d, 0xbb, 0xbe, 0x73, 0x81, 0x33, 0xd9, 0xd9, 0x80, 0x96, 0x60, 0x3b, 0xad, 0x42,
+    0x5b, 0x29, 0xdc, 0x6a, 0x89, 0xd9, 0xf0, 0xf0, 0x9a, 0x69, 0xab, 0x83, 0x06, 0x93, 0x79, 0x09,
+    0x06, 0xab, 0xcb, 0x48, 0x12, 0x74, 0x30, 0x58, 0xdf, 0x77, 0x46, 0xff, 0x64, 0x9f, 0x3b, 0xca,
+    0x77, 0x4e, 0xe4, 0x29, 0x78, 0x21, 0x8c, 0xb6, 0x8f, 0xcc, 0xa1, 0xa9, 0xb8, 0x0f, 0x7b, 0x83,
+    0xbe, 0x45, 0x24, 0x89, 0xd6, 0xe1, 0xb2, 0xe2, 0x0a, 0x7c, 0xdb, 0x74, 0xe0, 0xd4, 0xac, 0x59,
+    0x16, 0xe5, 0xf5, 0xdb, 0xab, 0xc5, 0x4c, 0x7a, 0x1f, 0x29, 0xf3, 0xd1, 0x76, 0xd3, 0xa9, 0xfd,
+    0xf8, 0x12, 0xe8, 0xea, 0x0b, 0xc6, 0x44, 0x7b, 0xf9, 0xbb, 0x12, 0x45, 0x62, 0xc2, 0xf7, 0x60,
+    0x99, 0x56, 0xf4, 0x72, 0xbd, 0x82, 0x80, 0x8a, 0xd7, 0x59, 0xf6, 0x6e, 0xf8, 0x8b, 0x3c, 0xe6,
+    0x26, 0xd6, 0xc8, 0x23, 0x94, 0xde, 0x0e, 0x58, 0x30, 0xe0, 0xd6, 0x64, 0x47, 0x2b, 0x85, 0xb6,
+    0x16, 0x39, 0xc5, 0x63, 0x55, 0x40, 0xdb, 0xc4, 0x89, 0x32, 0xe8, 0xce, 0x32, 0x69, 0xc0, 0x7b,
+    0x2a, 0x11, 0x98, 0x0d, 0x46, 0x7f, 0x8c, 0x7e, 0x91, 0xa3, 0x4e, 0xaa, 0x63, 0xda, 0x40, 0x83,
+    0x86, 0xd7, 0xef, 0x21, 0x04, 0x74, 0xfb, 0x51, 0xf5, 0xc9, 0x57, 0x93, 0xe2, 0xfc, 0x84, 0x2d,
+    0xba, 0x9c, 0x90, 0x49, 0xfd, 0x45, 0xee, 0x3b, 0xb4, 0xe8, 0xe2, 0xdb, 0x3d, 0x63, 0x5f, 0xa5,
+    0x0c, 0xb9, 0xfd, 0x2f, 0x81, 0xdb, 0xce, 0xfa, 0xcd, 0xfa, 0x0c, 0xbf, 0x1c, 0x12, 0xfd, 0xbf,
+    0x08, 0x0c, 0xe7, 0x8c, 0xde, 0xe2, 0x53, 0x81, 0xcf, 0x28, 0x7e, 0x22, 0x00, 0xeb, 0xbb, 0x1d,
+    0xba, 0x67, 0x9a, 0x43, 0xf4, 0xcf, 0x6a, 0xf4, 0x9c, 0xfa, 0x74, 0xae, 0x67, 0x71, 0xe6, 0xc3,
+    0xd4, 0x32, 0x0b, 0xa3, 0x3d, 0xba, 0x6f, 0x36, 0x21, 0x10, 0x8c, 0x66, 0x05, 0xb2, 0xc8, 0x57,
+    0xf1, 0xe2, 0x20, 0x05, 0x44, 0x41, 0xb6, 0xeb, 0x87, 0x4e, 0x01, 0x35, 0x32, 0x41, 0x5f, 0x38,
+    0x59, 0x16, 0xf3, 0x45, 0x51, 0xf0, 0xfa, 0x1b, 0xe2, 0xe3, 0x5f, 0xc0, 0xdf, 0x94, 0xd7, 0x8b,
+    0x79, 0xc4, 0xd3, 0x0c, 0x87, 0xf6, 0xf4, 0x80, 0xc8, 0x0f, 0x26, 0x85, 0x04, 0xbb, 0x05, 0x9f,
+    0xda, 0xeb, 0xa0, 0x6f, 0x39, 0x4b, 0x1b, 0xc9, 0xcb, 0x39, 0x79, 0x6d, 0x51, 0xaf, 0x5a, 0xda,
+    0xd2, 0xab, 0xc8, 0x24, 0xf2, 0x04, 0x3e, 0xaa, 0xfe, 0x54, 0x66, 0xa4, 0xd1, 0xa0, 0x6d, 0x38,
+    0xa9, 0xfd, 0x2a, 0x7e, 0x1c, 0xee, 0x0e, 0x23, 0x73, 0x52, 0xf9, 0xa9, 0x70, 0xd4, 0xf0, 0x69,
+    0x1e, 0xfa, 0x63, 0xd0, 0x99, 0xb2, 0x8b, 0x3c, 0xad, 0x8c, 0xf0, 0xd2, 0xe9, 0x3e, 0x30, 0xef,
+    0xe4, 0xf1, 0x76, 0x43, 0x29, 0x6f, 0xca, 0x9b, 0x02, 0x66, 0x3f, 0x7c, 0x74, 0x9a, 0x40, 0xf1,
+    0xd4, 0xb8, 0xde, 0x79, 0xfa, 0x78, 0xfd, 0x02, 0x5a, 0xe3, 0xb3, 0x00, 0xcd, 0x04, 0x00, 0x00,
+};
+
+static const uint8_t WEB_ASSET_1[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x7d, 0x53, 0xdb, 0x6e, 0xe3, 0x20,
+    0x10, 0x7d, 0xef, 0x57, 0xa0, 0x46, 0x2b, 0xb5, 0x52, 0x88, 0x6c, 0xb7, 0xf1, 0x56, 0xce, 0xd7,
+    0x8c, 0xcd, 0xe0, 0xb0, 0xc5, 0x60, 0x01, 0xce, 0x65, 0x57, 0xfb, 0xef, 0x3b, 0x60, 0x3b, 0x89,
+    0x93, 0x6e, 0x5f, 0x6c, 0x01, 0x87, 0x73, 0x99, 0x19, 0x6a, 0x2b, 0xce, 0xec, 0xcf, 0x13, 0x63,
+    0x1d, 0xb8, 0x56, 0x99, 0x8a, 0x65, 0x3b, 0x5a, 0xd4, 0xd0, 0x7c, 0xb6, 0xce, 0x0e, 0x46, 0x54,
+    0x6c, 0x95, 0x65, 0x69, 0xaf, 0xb1, 0xda, 0x3a, 0x5a, 0x4a, 0x29, 0xe3, 0x52, 0x5a, 0x13, 0xb8,
+    0x84, 0x4e, 0xe9, 0x73, 0xc5, 0xfc, 0xd9, 0x07, 0xec, 0xf8, 0xa0, 0xd6, 0xcc, 0x83, 0xf1, 0xdc,
+    0xa3, 0x53, 0x84, 0xfa, 0xfb, 0xb4, 0x47, 0x10, 0xe8, 0x92, 0x80, 0x50, 0xbe, 0xd7, 0x40, 0x60,
+    0xa9, 0xf1, 0x14, 0x19, 0x7e, 0x0d, 0x3e, 0x28, 0x79, 0xe6, 0x0d, 0x31, 0xa1, 0x09, 0xc4, 0xd2,
+    0x43, 0x83, 0xbc, 0xc6, 0x70, 0x44, 0x34, 0x11, 0x01, 0x5a, 0xb5, 0x86, 0x2b, 0xa2, 0xf6, 0x15,
+    0x79, 0xf2, 0xa8, 0x95, 0xc1, 0x78, 0xd0, 0x83, 0x10, 0xca, 0xb4, 0x15, 0xcb, 0x8b, 0xfe, 0xc4,
+    0xf2, 0xb2, 0x3f, 0x3d, 0xb8, 0x2e, 0x8a, 0x22, 0x19, 0xc8, 0x1f, 0xd3, 0x25, 0xeb, 0x5e, 0xfd,
+    0x46, 0xba, 0xbf, 0x29, 0xb0, 0x8b, 0xb8, 0xd5, 0xd0, 0x0b, 0x08, 0x28, 0x12, 0x7a, 0x8e, 0x0a,
+    0x00, 0xe9, 0x0c, 0x34, 0xb8, 0x2e, 0x9d, 0x5c, 0x84, 0x3f, 0xfe, 0xa7, 0xdb, 0x64, 0x57, 0x8d,
+    0x23, 0xaa, 0x76, 0x4f, 0xc1, 0x6a, 0xab, 0x45, 0x24, 0xea, 0x40, 0x99, 0x25, 0xcd, 0x4c, 0xd1,
+    0xc1, 0x89, 0x1f, 0x95, 0x08, 0xfb, 0x8a, 0xfd, 0x2c, 0xb2, 0x79, 0x6f, 0xf2, 0xcc, 0x60, 0x08,
+    0x36, 0xde, 0xdf, 0x1c, 0x40, 0x0f, 0xe8, 0x97, 0xe5, 0x6c, 0x9d, 0x12, 0x11, 0x1e, 0xff, 0x9c,
+    0x4a, 0x45, 0xbb, 0x01, 0xa9, 0xa8, 0x7a, 0xe8, 0x0c, 0x95, 0xcd, 0x61, 0x8f, 0x10, 0x5e, 0x22,
+    0x05, 0x97, 0x2a, 0xac, 0x59, 0xa7, 0x0c, 0xa9, 0xbd, 0xe4, 0xef, 0x24, 0xb3, 0x66, 0xb9, 0x74,
+    0xaf, 0xaf, 0xe9, 0x3a, 0xf4, 0x63, 0x39, 0xaf, 0xd2, 0xbc, 0xb6, 0x21, 0xd8, 0x6e, 0x76, 0x79,
+    0xd5, 0x17, 0xea, 0x90, 0x3c, 0x3c, 0x16, 0x9c, 0xf6, 0xac, 0xa3, 0x8e, 0x73, 0x07, 0x42, 0x0d,
+    0x24, 0x3f, 0xe5, 0xbb, 0x06, 0xce, 0x26, 0x2a, 0x0d, 0x35, 0xea, 0x65, 0x92, 0x5a, 0xdb, 0xe6,
+    0x73, 0x77, 0x5f, 0xff, 0x45, 0xbf, 0xb2, 0xcd, 0xc7, 0x76, 0x6c, 0xd8, 0xe8, 0x25, 0x11, 0x2c,
+    0xfa, 0x59, 0x4e, 0xfd, 0xec, 0xed, 0x71, 0x1a, 0xbc, 0x99, 0x2d, 0x93, 0x69, 0x24, 0x0d, 0x1c,
+    0x58, 0x3d, 0x50, 0x30, 0xf3, 0x98, 0xe1, 0xed, 0xed, 0xed, 0x8b, 0x51, 0x1f, 0x23, 0x11, 0x39,
+    0xf5, 0xdc, 0x5b, 0xad, 0x04, 0x5b, 0x6d, 0xb7, 0xdb, 0x2f, 0xc2, 0xbe, 0xdf, 0x85, 0x2d, 0xe3,
+    0x90, 0x14, 0x63, 0xe0, 0xab, 0xec, 0x06, 0x9a, 0xa0, 0x0e, 0xf8, 0xa8, 0x5e, 0x96, 0x65, 0x44,
+    0x36, 0x60, 0x0e, 0x30, 0x36, 0x79, 0x1a, 0x89, 0x3c, 0xcb, 0x7e, 0x44, 0xe2, 0xfd, 0x34, 0x4f,
+    0xe3, 0x3c, 0x5c, 0xda, 0x14, 0x6c, 0x9f, 0x06, 0xf2, 0x61, 0x16, 0xf3, 0x3c, 0x1f, 0x6b, 0x8d,
+    0x2d, 0x1a, 0x11, 0xdf, 0x97, 0xb9, 0x79, 0x0d, 0xdc, 0x8d, 0x6c, 0x97, 0xee, 0xde, 0xc0, 0xaa,
+    0xaa, 0x46, 0x69, 0x1d, 0x4e, 0x05, 0x9c, 0x1e, 0xe8, 0xf3, 0xf3, 0xee, 0xb6, 0x5f, 0xca, 0xc4,
+    0xf7, 0xc8, 0x2f, 0x6d, 0x9b, 0xdd, 0x4e, 0x43, 0x34, 0xbb, 0xbd, 0x1b, 0xaa, 0x49, 0xf5, 0x4e,
+    0x74, 0x43, 0xdf, 0x85, 0xe8, 0x22, 0x88, 0x94, 0xd9, 0x02, 0x4c, 0x8e, 0xfc, 0x37, 0xe8, 0x2c,
+    0xa1, 0xff, 0x01, 0x08, 0xf7, 0x77, 0x84, 0xdb, 0x04, 0x00, 0x00,
+};
+
+static const uint8_t WEB_ASSET_2[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x95, 0x57, 0xdb, 0x72, 0xdb, 0x36,
+    0x10, 0x7d, 0xd7, 0x57, 0x6c, 0x26, 0x4d, 0x08, 0x45, 0x14, 0x45, 0x39, 0x8a, 0xdb, 0xb1, 0xea,
+    0x74, 0xda, 0x24, 0xbd, 0xcc, 0x24, 0x6d, 0xa6, 0x76, 0x9b, 0x07, 0x8f, 0xa7, 0x81, 0x48, 0x50,
+    0xa4, 0x4d, 0x11, 0x0c, 0x00, 0x4a, 0xd6, 0x38, 0xfa, 0xf7, 0xee, 0x02, 0xbc, 0xc9, 0xb1, 0xdc,
+    0x66, 0xfc, 0x20, 0x02, 0xd8, 0x3d, 0xd8, 0xcb, 0xd9, 0xc5, 0xda, 0xab, 0xb4, 0x00, 0x6d, 0x54,
+    0x16, 0x19, 0x6f, 0x3e, 0x18, 0x44, 0xb2, 0xd0, 0x06, 0xde, 0xff, 0xf1, 0xf6, 0xed, 0x3f, 0xef,
+    0xce, 0xe0, 0x14, 0x5e, 0x84, 0x61, 0x38, 0x1f, 0xe4, 0xc2, 0x80, 0x2e, 0x79, 0x81, 0x1b, 0xe1,
+    0x1c, 0x60, 0x32, 0x81, 0x10, 0x74, 0x2a, 0x37, 0x1a, 0x8c, 0x8c, 0xf9, 0xd6, 0xd3, 0x10, 0x55,
+    0x6a, 0x2d, 0x34, 0x24, 0x4a, 0xae, 0xc0, 0xa4, 0x88, 0x58, 0xf0, 0x12, 0x25, 0x8c, 0x53, 0xad,
+    0x17, 0xa8, 0x5e, 0x54, 0x79, 0x8e, 0xd7, 0x24, 0x55, 0x11, 0x99, 0x4c, 0x16, 0x90, 0xac, 0x0c,
+    0x5b, 0xfb, 0x10, 0x67, 0xcb, 0xcc, 0x68, 0x1f, 0xaa, 0x22, 0x33, 0x43, 0xb8, 0x1d, 0x00, 0x28,
+    0x61, 0x2a, 0x55, 0xc0, 0x1a, 0x4e, 0x4f, 0x9d, 0x16, 0x7c, 0xfe, 0x5c, 0xaf, 0xaa, 0x22, 0x16,
+    0x49, 0x56, 0x88, 0x18, 0x7e, 0x00, 0x6f, 0x3c, 0xf6, 0xe0, 0x04, 0xd6, 0x81, 0x91, 0x3f, 0x67,
+    0x37, 0x22, 0x66, 0x0e, 0x69, 0x08, 0x23, 0xf0, 0xf0, 0x6f, 0x64, 0x11, 0xe7, 0x83, 0x5d, 0xef,
+    0x4a, 0x32, 0xfc, 0x6f, 0x9e, 0x57, 0x42, 0x33, 0xed, 0xee, 0x8a, 0x65, 0x54, 0xad, 0x44, 0x61,
+    0x82, 0xa5, 0x30, 0x6f, 0x72, 0x41, 0x9f, 0x3f, 0x6d, 0x7f, 0x8b, 0x99, 0x57, 0x95, 0x31, 0x37,
+    0x22, 0xf6, 0x86, 0x81, 0x11, 0x37, 0xe6, 0x95, 0x2c, 0x0c, 0x1e, 0xa1, 0x17, 0x3a, 0xa8, 0x4f,
+    0xe6, 0x0f, 0x69, 0x2f, 0xb8, 0x31, 0x42, 0x6d, 0xbf, 0xd0, 0x26, 0x9f, 0x75, 0x50, 0x9f, 0xfa,
+    0x30, 0xf5, 0xc1, 0x7b, 0xe2, 0x0d, 0x1f, 0x84, 0x5a, 0x8a, 0x42, 0x28, 0x4e, 0xe6, 0x1f, 0x40,
+    0xeb, 0x04, 0x7c, 0x38, 0x42, 0xc0, 0xeb, 0x0f, 0xe9, 0x7f, 0x40, 0x52, 0xa6, 0xab, 0x55, 0xf9,
+    0x00, 0x66, 0x4f, 0xe2, 0xff, 0x82, 0xe6, 0xd9, 0x5a, 0x20, 0x5a, 0x9a, 0xc5, 0xb1, 0x20, 0xb6,
+    0x3c, 0xd2, 0x01, 0x6d, 0x3d, 0xa8, 0x53, 0xca, 0x8d, 0x50, 0x07, 0x4c, 0xb0, 0x67, 0x3e, 0x84,
+    0x78, 0xf9, 0x07, 0x77, 0xb5, 0x23, 0x28, 0xcf, 0xb9, 0x5a, 0xa1, 0xd4, 0x41, 0x50, 0x2b, 0xe0,
+    0x34, 0xec, 0xe7, 0x9e, 0x49, 0x76, 0xa7, 0x3b, 0xba, 0x9b, 0x5b, 0x07, 0x8e, 0x74, 0xf3, 0x3c,
+    0xcb, 0x1c, 0xa4, 0xfb, 0x6b, 0xc5, 0x37, 0xd0, 0xc5, 0x18, 0x78, 0x11, 0x43, 0x2f, 0x3c, 0x20,
+    0xd7, 0x42, 0xc1, 0x05, 0xb1, 0xdf, 0x77, 0x35, 0x30, 0x22, 0xe9, 0x20, 0x17, 0xc5, 0xd2, 0xa4,
+    0xf0, 0x0c, 0x0b, 0x4c, 0x94, 0xc3, 0xa0, 0xe3, 0x60, 0x8c, 0x78, 0xbf, 0x28, 0x5e, 0xa6, 0x0c,
+    0xc5, 0x7c, 0x0b, 0xe5, 0x14, 0x7d, 0x27, 0x6a, 0x69, 0xe9, 0x5c, 0x8d, 0x1e, 0x72, 0x73, 0x49,
+    0x18, 0xfd, 0xc0, 0x2c, 0x51, 0x3a, 0x22, 0x31, 0xeb, 0xd0, 0x8d, 0x61, 0xde, 0x51, 0xdc, 0x3f,
+    0xcf, 0x45, 0x42, 0x4e, 0xce, 0x30, 0xa2, 0x0b, 0x69, 0x8c, 0x5c, 0x59, 0xf9, 0x54, 0x64, 0xcb,
+    0xd4, 0xc0, 0x18, 0x8e, 0x70, 0xdf, 0xc8, 0x12, 0x37, 0xa7, 0xf8, 0xa5, 0xec, 0x2e, 0x09, 0x6c,
+    0xb2, 0x18, 0xfd, 0x18, 0xe3, 0x2e, 0x41, 0x2d, 0x83, 0x28, 0x17, 0x5c, 0xfd, 0x29, 0x22, 0xc3,
+    0x42, 0x9b, 0x9d, 0x5a, 0xc2, 0x6f, 0xb1, 0x7a, 0x57, 0xae, 0xf8, 0x0d, 0x62, 0xbc, 0xe3, 0x26,
+    0x0d, 0xf0, 0x93, 0x21, 0xdd, 0x83, 0x80, 0xf8, 0x1a, 0x24, 0x59, 0x8e, 0x15, 0xc0, 0xb0, 0xa8,
+    0x5f, 0x62, 0x65, 0x3f, 0xaa, 0xeb, 0x7c, 0x68, 0xcf, 0x49, 0xf5, 0x90, 0x40, 0x0f, 0x9b, 0x90,
+    0x33, 0x3a, 0xb6, 0x7e, 0x8d, 0x80, 0xa9, 0xda, 0x11, 0x5a, 0x0f, 0x31, 0xf0, 0x19, 0x4c, 0x7a,
+    0x99, 0xe8, 0x14, 0xb7, 0xa8, 0x68, 0x71, 0xeb, 0x28, 0x8c, 0x81, 0xb5, 0x5f, 0x18, 0x00, 0x52,
+    0x5d, 0xa3, 0x2a, 0x1a, 0xec, 0x1c, 0xc6, 0x0e, 0x29, 0xaf, 0xc5, 0x99, 0xd9, 0xe6, 0x02, 0x35,
+    0xbd, 0xc7, 0xb3, 0xd9, 0xcc, 0x73, 0x27, 0x68, 0x64, 0xde, 0xed, 0x73, 0xce, 0x9b, 0x7d, 0x69,
+    0xe9, 0xe4, 0x4d, 0x8f, 0xca, 0x1b, 0xd0, 0xbc, 0xd0, 0x63, 0x2d, 0x54, 0x96, 0xd8, 0xd3, 0x44,
+    0x2a, 0x60, 0xd4, 0x19, 0xaf, 0x5d, 0x47, 0xbd, 0x86, 0xef, 0x31, 0x27, 0x73, 0x18, 0x8d, 0xae,
+    0x5d, 0xea, 0x5b, 0x33, 0xc9, 0xce, 0x2d, 0xa3, 0x10, 0x3e, 0x43, 0xa9, 0x09, 0xcc, 0xac, 0xf3,
+    0x84, 0xbf, 0x10, 0xcb, 0xac, 0x78, 0x8f, 0x51, 0x65, 0xed, 0xd6, 0x0a, 0x69, 0x78, 0x2e, 0x19,
+    0xf9, 0xee, 0xa3, 0x6a, 0xbb, 0x9f, 0x63, 0xb3, 0xc4, 0x7d, 0x1b, 0x9b, 0xbd, 0x03, 0xe7, 0x55,
+    0x07, 0x40, 0xbe, 0x9c, 0x13, 0x6b, 0x6c, 0xb6, 0x94, 0xc4, 0x4e, 0xbb, 0x77, 0xb7, 0xed, 0xaa,
+    0x1f, 0x3c, 0x9b, 0x72, 0x34, 0x6d, 0x54, 0x9b, 0xb3, 0xeb, 0xe8, 0xc5, 0x17, 0x22, 0xd7, 0x68,
+    0xf3, 0xf1, 0x41, 0x37, 0x9d, 0xc8, 0x3d, 0xbe, 0xda, 0xe7, 0x41, 0x6c, 0xe0, 0x35, 0x36, 0x56,
+    0xc6, 0xea, 0x2a, 0xa2, 0x6a, 0xc0, 0xeb, 0xf7, 0x8a, 0x89, 0x6c, 0x71, 0x28, 0x94, 0xa6, 0x29,
+    0xbe, 0x50, 0xb5, 0x03, 0x35, 0x0e, 0x3a, 0x40, 0x75, 0x6c, 0xdf, 0x2b, 0xe4, 0x4c, 0x48, 0xa5,
+    0x6c, 0x57, 0x78, 0xfb, 0x77, 0xc7, 0xb3, 0x30, 0xb4, 0xc2, 0x80, 0xaf, 0xc7, 0x19, 0xbe, 0x7b,
+    0xc5, 0x92, 0xd9, 0xba, 0xfa, 0xeb, 0xfc, 0xd5, 0xaf, 0xb2, 0x52, 0x9a, 0x0d, 0x87, 0x41, 0xc9,
+    0xe3, 0x33, 0xc3, 0x95, 0x61, 0xd4, 0xf5, 0x42, 0xcf, 0xfa, 0x7d, 0x12, 0x86, 0x5e, 0xad, 0x78,
+    0x02, 0x8d, 0x86, 0xb5, 0xd5, 0x1e, 0x07, 0xf4, 0xd8, 0xb4, 0x48, 0xef, 0x30, 0xf9, 0xa9, 0x3d,
+    0x98, 0xd6, 0xa7, 0x5f, 0x84, 0x98, 0xcc, 0xf4, 0x0f, 0xf2, 0xb6, 0xf3, 0x91, 0xaa, 0xee, 0xd8,
+    0xef, 0x17, 0x69, 0x17, 0x74, 0x1b, 0x60, 0xe7, 0xf5, 0x05, 0xbe, 0x47, 0x9c, 0x3a, 0x49, 0x8e,
+    0x4e, 0x5c, 0x82, 0x4c, 0xe0, 0xe2, 0xc2, 0xb5, 0x15, 0xef, 0x71, 0x82, 0xa6, 0x5f, 0xfa, 0x70,
+    0x61, 0x7b, 0x0d, 0x2e, 0x13, 0x5c, 0x5e, 0x36, 0xc1, 0xbf, 0xcb, 0x6d, 0x87, 0x70, 0x90, 0x65,
+    0x94, 0xce, 0xd2, 0x36, 0xd2, 0x84, 0xe7, 0x5a, 0xb8, 0x4d, 0xba, 0x1b, 0x09, 0xaf, 0xde, 0xf0,
+    0x28, 0x65, 0xf4, 0x9e, 0x67, 0x43, 0xaa, 0xad, 0xdb, 0x3a, 0x5e, 0x59, 0x02, 0xac, 0x7b, 0xc8,
+    0x87, 0xed, 0x3e, 0x7c, 0x89, 0x84, 0x7e, 0x01, 0x3a, 0x2d, 0xac, 0x0e, 0x9e, 0xf6, 0x85, 0x5b,
+    0x22, 0xdf, 0xb0, 0x0c, 0x63, 0x16, 0x06, 0x2f, 0xb0, 0x57, 0x6c, 0xd9, 0x7a, 0x38, 0xbc, 0xa3,
+    0xdb, 0x57, 0xa9, 0x6b, 0xe2, 0xa0, 0x4a, 0x63, 0x83, 0x51, 0x55, 0x67, 0x82, 0xfd, 0xdd, 0xdd,
+    0x5b, 0x26, 0x3b, 0x7a, 0x11, 0xb8, 0xde, 0x16, 0x11, 0xb4, 0xdd, 0x5c, 0x89, 0x44, 0x09, 0x9d,
+    0xba, 0x86, 0xee, 0x2c, 0x26, 0xf3, 0x3b, 0x06, 0x36, 0x5e, 0xd8, 0xdd, 0x7a, 0x18, 0xea, 0x3c,
+    0x73, 0x09, 0xc4, 0x39, 0x8a, 0x58, 0x5b, 0x9f, 0x06, 0x26, 0x5b, 0x09, 0xcc, 0xf5, 0xfe, 0xfa,
+    0x89, 0xe3, 0x6f, 0x63, 0x67, 0xf7, 0x8a, 0xb4, 0x62, 0x36, 0xc5, 0xed, 0xca, 0x11, 0x00, 0x91,
+    0x7d, 0x78, 0x7e, 0xdc, 0x96, 0x89, 0x73, 0xcf, 0x0d, 0x58, 0xfb, 0xe5, 0x6b, 0xab, 0xad, 0x2e,
+    0x9d, 0x97, 0xf0, 0x2d, 0xf2, 0xd0, 0xde, 0x87, 0x95, 0x72, 0x34, 0x45, 0x7d, 0x24, 0x3e, 0xc1,
+    0x74, 0x5d, 0xd4, 0xc8, 0xa6, 0xb3, 0x27, 0xb9, 0x94, 0x8a, 0x51, 0x39, 0x04, 0x85, 0xdc, 0x60,
+    0x10, 0x26, 0xb6, 0x30, 0xf1, 0xc7, 0xbd, 0x67, 0xee, 0x09, 0xac, 0x0b, 0xba, 0x03, 0x50, 0xa8,
+    0xcf, 0x37, 0x3c, 0x33, 0x90, 0x08, 0x83, 0xdc, 0xf9, 0x38, 0xe1, 0x65, 0x36, 0x51, 0xbc, 0x58,
+    0x8a, 0x1f, 0xa8, 0x03, 0x9c, 0x7e, 0x73, 0x8b, 0x77, 0x8c, 0xad, 0x45, 0xbb, 0xa7, 0x46, 0xda,
+    0xf5, 0xee, 0x29, 0x81, 0xe0, 0x27, 0xfd, 0xec, 0x3e, 0xf6, 0x9e, 0x83, 0xab, 0x16, 0x4e, 0x05,
+    0x57, 0x5a, 0x16, 0x2e, 0x65, 0x5d, 0x98, 0xae, 0x02, 0xcb, 0xd4, 0x15, 0x2f, 0x99, 0x92, 0x1b,
+    0xa2, 0x28, 0xfe, 0x5c, 0x4c, 0x2f, 0x91, 0x14, 0xf7, 0x1f, 0x1d, 0xb9, 0x23, 0xf7, 0x32, 0x5f,
+    0x05, 0xd6, 0x97, 0xf9, 0x3d, 0x0c, 0x28, 0x65, 0x9e, 0xd7, 0x99, 0x37, 0x6a, 0x5b, 0x67, 0x16,
+    0xe7, 0x86, 0x73, 0x1c, 0x85, 0x63, 0xb1, 0xce, 0x22, 0x81, 0x23, 0x83, 0xc6, 0x59, 0x46, 0xc3,
+    0xf3, 0x70, 0x06, 0x9b, 0x34, 0xc3, 0x5a, 0xeb, 0xcf, 0xc9, 0x90, 0x69, 0x1c, 0x55, 0xa3, 0x94,
+    0x3c, 0x8f, 0x83, 0x5e, 0x37, 0xbb, 0x1b, 0x21, 0xcf, 0x46, 0x08, 0x63, 0x8c, 0x5d, 0xf8, 0x36,
+    0xc2, 0x7a, 0x13, 0x27, 0xe0, 0x15, 0x72, 0x6c, 0x3f, 0xbd, 0xdd, 0x5e, 0x27, 0xd4, 0xf7, 0x86,
+    0xc3, 0xd1, 0xf0, 0x51, 0x7b, 0x33, 0x75, 0xc7, 0x40, 0x8b, 0x4f, 0xf6, 0x81, 0x6d, 0xa9, 0x83,
+    0x1b, 0x1d, 0x43, 0x7b, 0x03, 0xbc, 0x6e, 0xc8, 0xb7, 0x37, 0x46, 0x37, 0x9b, 0xfb, 0x95, 0xd0,
+    0xd1, 0x6d, 0x07, 0x11, 0x47, 0xeb, 0x81, 0x89, 0x06, 0xf4, 0xab, 0x67, 0x6e, 0x4f, 0x26, 0x09,
+    0xd5, 0xbf, 0xd7, 0x50, 0x56, 0x0b, 0x73, 0x8e, 0x45, 0x21, 0x2b, 0xc3, 0x28, 0xfc, 0x7e, 0xf3,
+    0x5f, 0x8b, 0x4b, 0x50, 0x8b, 0xff, 0xa9, 0xc2, 0x29, 0xfb, 0x4c, 0xe4, 0x38, 0xac, 0x48, 0xf5,
+    0x23, 0xa6, 0xc9, 0x2b, 0xf8, 0x1a, 0x16, 0x15, 0x3e, 0xf6, 0x34, 0xf8, 0x36, 0x5d, 0x6b, 0x61,
+    0x87, 0x81, 0x80, 0xc7, 0xf1, 0x9b, 0x35, 0xaa, 0xbd, 0xcd, 0x30, 0xd7, 0x38, 0xee, 0xe1, 0x9c,
+    0x9c, 0x67, 0xd1, 0x35, 0x06, 0x9b, 0xb5, 0x2d, 0xed, 0x6b, 0xa1, 0x25, 0x29, 0x4a, 0x9c, 0x99,
+    0xb8, 0xd6, 0x84, 0x8b, 0xff, 0xab, 0x2c, 0x97, 0xb9, 0xc0, 0x21, 0x15, 0xc9, 0x83, 0xf3, 0xb2,
+    0x0f, 0xd2, 0xb6, 0x89, 0x85, 0xeb, 0x4a, 0xf5, 0x3f, 0x5a, 0xbf, 0x57, 0xab, 0x05, 0xde, 0xbf,
+    0xb0, 0xbc, 0x44, 0x5f, 0x03, 0xda, 0xb7, 0x02, 0x77, 0x83, 0xbc, 0x23, 0xbd, 0x81, 0xa3, 0xe0,
+    0x7c, 0xf0, 0x2f, 0x97, 0x3b, 0x31, 0x7a, 0xd1, 0x0d, 0x00, 0x00,
+};
+
+static const WebAsset WEB_ASSETS[] = {
+    {"/", "text/html", WEB_ASSET_0, sizeof(WEB_ASSET_0), "\"7997e00daf239381\"", false},
+    {"/dashboard.bf067538.css", "text/css", WEB_ASSET_1, sizeof(WEB_ASSET_1), "\"bf0675380a165960\"", true},
+    {"/dashboard.a6c9690a.js", "application/javascript", WEB_ASSET_2, sizeof(WEB_ASSET_2), "\"a6c9690aa61b05ec\"", true},
+};
@@ -0,0 +1,42 @@
+#include "web_server.h"
+
+constexpr size_t WEB_MAX_HEADERS = 4;
+
+static WebServer server(80);
+static TaskHandle_t serverTaskHandle = nullptr;
+static const char *headerNames[WEB_MAX_HEADERS];
+static size_t headerCount = 0;
+
+WebServer &webServer() {
+  return server;
+}
+
+void collectRequestHeader(const char *name) {
+  if (headerCount < WEB_MAX_HEADERS) {
+    headerNames[headerCount++] = name;
+  }
+}
+
+static void serverTask(void *) {
+  for (;;) {
+    server.handleClient();
+    vTaskDelay(pdMS_TO_TICKS(2));
+  }
+}
+
+void beginWebServer() {
+  if (serverTaskHandle) {
+    return;
+  }
+  server.onNotFound([]() { server.send(404, "text/plain", "Not found\n"); });
+  // collectHeaders() replaces the list, so it is set once for all modules
+  server.collectHeaders(headerNames, headerCount);
+  server.begin();
+  if (xTaskCreatePinnedToCore(serverTask, "http", 6144, nullptr, 1,
+                              &serverTaskHandle, 0) != pdPASS) {
+    serverTaskHandle = nullptr;
+    Serial.println("Failed to start web server task");
+    return;
+  }
+  Serial.println("Web server listening on port 80");
+}
@@ -0,0 +1,23 @@
+/*
+  -----------------------------------------------------------------------------
+  web_server.h — Shared HTTP server on port 80
+
+  Modules register their routes on ``webServer()`` during setup(); the
+  server then runs in its own low-priority task so HTTP clients never delay
+  the display loop.  Route handlers therefore run concurrently with loop()
+  and must only touch thread-safe state.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <WebServer.h>
+
+WebServer &webServer();
+
+// Ask the server to keep a request header for the handlers.  The server
+// only stores headers it was told about before ``beginWebServer()``.
+void collectRequestHeader(const char *name);
+
+// Start serving from a background task.  Register all routes first.
+void beginWebServer();
@@ -0,0 +1,190 @@
+#include "websocket.h"
+
+#include <base64.h>
+#include <mbedtls/sha1.h>
+
+constexpr uint32_t WS_HANDSHAKE_TIMEOUT_MS = 1000;
+
+enum : uint8_t {
+  WS_CONTINUATION = 0x0,
+  WS_BINARY = 0x2,
+  WS_CLOSE = 0x8,
+  WS_PING = 0x9,
+  WS_PONG = 0xa,
+};
+
+WebSocketServer::WebSocketServer(uint16_t port)
+    : server_(port), open_(false), firstFragment_(true), fragmentLen_(0) {}
+
+void WebSocketServer::begin() {
+  server_.begin();
+}
+
+bool WebSocketServer::handshake(WiFiClient &client) {
+  client.setTimeout(WS_HANDSHAKE_TIMEOUT_MS);
+  String key;
+  bool upgrade = false;
+  // Read the request headers up to the empty line.
+  for (int lines = 0; lines < 32; ++lines) {
+    String line = client.readStringUntil('\n');
+    line.trim();
+    if (line.length() == 0) {
+      break;
+    }
+    if (line.startsWith("GET ")) {
+      upgrade = true;
+    } else if (line.startsWith("Sec-WebSocket-Key:")) {
+      key = line.substring(18);
+      key.trim();
+    }
+  }
+  if (!upgrade || key.length() == 0) {
+    client.print("HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n");
+    return false;
+  }
+  key += "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+  uint8_t digest[20];
+  mbedtls_sha1_ret(reinterpret_cast<const unsigned char *>(key.c_str()),
+                   key.length(), digest);
+  String response = "HTTP/1.1 101 Switching Protocols\r\n"
+                    "Upgrade: websocket\r\n"
+                    "Connection: Upgrade\r\n"
+                    "Sec-WebSocket-Accept: ";
+  response += base64::encode(digest, sizeof(digest));
+  response += "\r\n\r\n";
+  client.print(response);
+  return true;
+}
+
+bool WebSocketServer::poll() {
+  bool joined = false;
+  WiFiClient incoming = server_.available();
+  if (incoming) {
+    if (handshake(incoming)) {
+      if (open_) {
+        client_.stop();
+      }
+      client_ = incoming;
+      client_.setNoDelay(true);
+      open_ = true;
+      joined = true;
+    } else {
+      incoming.stop();
+    }
+  }
+  while (connected() && client_.available() >= 2) {
+    readFrame();
+  }
+  return joined;
+}
+
+bool WebSocketServer::connected() {
+  if (open_ && !client_.connected()) {
+    client_.stop();
+    open_ = false;
+  }
+  return open_;
+}
+
+void WebSocketServer::readFrame() {
+  uint8_t head[2];
+  if (client_.readBytes(head, 2) != 2) {
+    return;
+  }
+  uint8_t opcode = head[0] & 0x0f;
+  uint64_t len = head[1] & 0x7f;
+  if (len >= 126) {
+    uint8_t ext[8];
+    size_t n = len == 126 ? 2 : 8;
+    if (client_.readBytes(ext, n) != n) {
+      return;
+    }
+    len = 0;
+    for (size_t i = 0; i < n; ++i) {
+      len = (len << 8) | ext[i];
+    }
+  }
+  uint8_t mask[4] = {0, 0, 0, 0};
+  if ((head[1] & 0x80) && client_.readBytes(mask, 4) != 4) {
+    return;
+  }
+  // Control frames carry at most 125 bytes; data from the browser is not
+  // used and is skipped.
+  uint8_t payload[125];
+  size_t kept = 0;
+  while (len > 0) {
+    uint8_t chunk[64];
+    size_t n = len < sizeof(chunk) ? static_cast<size_t>(len) : sizeof(chunk);
+    if (client_.readBytes(chunk, n) != n) {
+      break;
+    }
+    for (size_t i = 0; i < n && kept < sizeof(payload); ++i) {
+      payload[kept] = chunk[i] ^ mask[kept & 3];
+      ++kept;
+    }
+    len -= n;
+  }
+  if (opcode == WS_PING) {
+    sendFrame(WS_PONG, true, payload, kept);
+  } else if (opcode == WS_CLOSE) {
+    sendFrame(WS_CLOSE, true, payload, kept < 2 ? kept : 2);
+    client_.stop();
+    open_ = false;
+  }
+}
+
+void WebSocketServer::sendFrame(uint8_t opcode, bool fin, const uint8_t *data,
+                                size_t len) {
+  uint8_t head[4];
+  size_t headLen = 2;
+  head[0] = (fin ? 0x80 : 0) | opcode;
+  if (len < 126) {
+    head[1] = len;
+  } else {
+    head[1] = 126;
+    head[2] = len >> 8;
+    head[3] = len;
+    headLen = 4;
+  }
+  if (client_.write(head, headLen) != headLen ||
+      (len > 0 && client_.write(data, len) != len)) {
+    client_.stop();
+    open_ = false;
+  }
+}
+
+void WebSocketServer::beginMessage() {
+  firstFragment_ = true;
+  fragmentLen_ = 0;
+}
+
+void WebSocketServer::flushFragment(bool fin) {
+  if (!open_) {
+    return;
+  }
+  sendFrame(firstFragment_ ? WS_BINARY : WS_CONTINUATION, fin, fragment_,
+            fragmentLen_);
+  firstFragment_ = false;
+  fragmentLen_ = 0;
+}
+
+void WebSocketServer::write(const uint8_t *data, size_t len) {
+  while (len > 0) {
+    size_t n = sizeof(fragment_) - fragmentLen_;
+    if (n > len) {
+      n = len;
+    }
+    memcpy(fragment_ + fragmentLen_, data, n);
+    fragmentLen_ += n;
+    data += n;
+    len -= n;
+    if (fragmentLen_ == sizeof(fragment_)) {
+      flushFragment(false);
+    }
+  }
+}
+
+bool WebSocketServer::endMessage() {
+  flushFragment(true);
+  return open_;
+}
@@ -0,0 +1,52 @@
+/*
+  -----------------------------------------------------------------------------
+  websocket.h — Minimal single-client WebSocket server (RFC 6455)
+
+  Only what the display mirror needs: the opening handshake, server-to-client
+  binary messages and answering ping/close from the browser.  Messages are
+  sent as fragments of at most ``FRAGMENT_SIZE`` bytes, so a message of any
+  length can be streamed while it is produced without knowing its size in
+  advance.  A new connection replaces the previous one.
+
+  All methods must be called from the same task.
+  -----------------------------------------------------------------------------
+*/
+
+#pragma once
+
+#include <WiFi.h>
+
+class WebSocketServer {
+public:
+  static constexpr size_t FRAGMENT_SIZE = 1024;
+
+  explicit WebSocketServer(uint16_t port);
+
+  void begin();
+
+  // Accept a pending connection and process frames from the client.
+  // Returns true when a new client has completed the handshake.
+  bool poll();
+
+  bool connected();
+
+  // Stream one binary message: ``beginMessage()``, any number of
+  // ``write()`` calls, then ``endMessage()``.  Returns false if the client
+  // went away meanwhile.
+  void beginMessage();
+  void write(const uint8_t *data, size_t len);
+  bool endMessage();
+
+private:
+  bool handshake(WiFiClient &client);
+  void readFrame();
+  void sendFrame(uint8_t opcode, bool fin, const uint8_t *data, size_t len);
+  void flushFragment(bool fin);
+
+  WiFiServer server_;
+  WiFiClient client_;
+  bool open_;
+  bool firstFragment_;
+  uint8_t fragment_[FRAGMENT_SIZE];
+  size_t fragmentLen_;
+};
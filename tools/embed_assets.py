@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""
+embed_assets — Compress the dashboard in web/ into src/web_assets.h.
+
+Every file is gzip-compressed at the highest level and written as a
+PROGMEM byte array, so the firmware can hand the bytes to the network
+straight from flash with ``Content-Encoding: gzip``.  Scripts and style
+sheets get the first eight hex digits of their SHA-1 in the file name and
+index.html is rewritten to match; the firmware can then let browsers cache
+them for a year, while index.html itself is revalidated by its ETag.
+
+Run after changing anything in web/:
+
+    python3 tools/embed_assets.py
+"""
+
+import gzip
+import hashlib
+import os
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+WEB = os.path.join(ROOT, "web")
+OUT = os.path.join(ROOT, "src", "web_assets.h")
+
+TYPES = {
+    ".html": "text/html",
+    ".js": "application/javascript",
+    ".css": "text/css",
+    ".svg": "image/svg+xml",
+    ".png": "image/png",
+}
+
+
+def compress(data):
+    # mtime=0 keeps the output identical for identical input
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+
+def c_array(name, data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "static const uint8_t %s[] PROGMEM = {\n%s\n};\n" % (name, "\n".join(lines))
+
+
+def main():
+    files = sorted(f for f in os.listdir(WEB) if os.path.splitext(f)[1] in TYPES)
+    if "index.html" not in files:
+        sys.exit("web/index.html is missing")
+    assets = []  # (url, type, bytes, immutable)
+    renames = {}
+    for name in files:
+        if name == "index.html":
+            continue
+        with open(os.path.join(WEB, name), "rb") as f:
+            data = f.read()
+        stem, ext = os.path.splitext(name)
+        hashed = "%s.%s%s" % (stem, hashlib.sha1(data).hexdigest()[:8], ext)
+        renames[name] = hashed
+        assets.append(("/" + hashed, TYPES[ext], data, True))
+    with open(os.path.join(WEB, "index.html"), "rb") as f:
+        index = f.read().decode("utf-8")
+    for name, hashed in renames.items():
+        index = index.replace('"%s"' % name, '"%s"' % hashed)
+    assets.insert(0, ("/", "text/html", index.encode("utf-8"), False))
+
+    out = [
+        "/*",
+        "  Generated by tools/embed_assets.py from web/ -- do not edit.",
+        "*/",
+        "",
+        "#pragma once",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "struct WebAsset {",
+        "  const char *path;",
+        "  const char *type;",
+        "  const uint8_t *gzip;",
+        "  size_t length;",
+        "  const char *etag;",
+        "  bool immutable;  // name contains the content hash",
+        "};",
+        "",
+    ]
+    table = []
+    raw_total = 0
+    gz_total = 0
+    for i, (url, ctype, data, immutable) in enumerate(assets):
+        gz = compress(data)
+        raw_total += len(data)
+        gz_total += len(gz)
+        out.append(c_array("WEB_ASSET_%d" % i, gz))
+        etag = '"\\"%s\\""' % hashlib.sha1(data).hexdigest()[:16]
+        table.append('    {"%s", "%s", WEB_ASSET_%d, sizeof(WEB_ASSET_%d), %s, %s},'
+                     % (url, ctype, i, i, etag, "true" if immutable else "false"))
+    out.append("static const WebAsset WEB_ASSETS[] = {")
+    out.extend(table)
+    out.append("};")
+    out.append("")
+    with open(OUT, "w") as f:
+        f.write("\n".join(out))
+    print("%d assets, %d bytes -> %d bytes gzip" % (len(assets), raw_total, gz_total))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+endpoint_standin.py — Local stand-ins for regional cloud endpoints.
+
+Starts one small HTTP server per ``--endpoint PORT:DELAY_MS[:FAIL_RATE]``.
+Each waits DELAY_MS before every answer (and before the TLS handshake when
+``--cert``/``--key`` are given) and answers a share FAIL_RATE of requests
+with 503.  POST requests get a login token and GET requests a daily energy
+document in the default format, so the device can fetch from them:
+
+    python3 tools/endpoint_standin.py --endpoint 8441:20 --endpoint 8442:300 \\
+        --endpoint 8443:50:0.5
+
+Then set ``anker_auth_url`` to ``http://<host-ip>:8441/login``,
+``anker_data_url`` to ``http://<host-ip>:8441/energy`` and ``anker_hosts``
+to ``<host-ip>:8442,<host-ip>:8443``, and watch ``endpoints`` on the
+console or ``/api/endpoints``.  Ports can be slowed down or made to fail
+while running by typing ``PORT:DELAY_MS[:FAIL_RATE]`` on stdin.
+"""
+
+import argparse
+import json
+import random
+import ssl
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+
+def energy_document():
+    hour = time.gmtime().tm_hour
+    gen = [round(max(0.0, 600 - 60 * abs(h - 12)) * random.uniform(0.9, 1.1), 1)
+           if h <= hour else 0.0 for h in range(24)]
+    cons = [round(random.uniform(150, 400), 1) if h <= hour else 0.0
+            for h in range(24)]
+    return {
+        "battery_percent": round(random.uniform(20, 100), 1),
+        "daily_generation": round(sum(gen) / 1000, 2),
+        "daily_consumption": round(sum(cons) / 1000, 2),
+        "generation_curve": gen,
+        "consumption_curve": cons,
+    }
+
+
+class StandinHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def answer(self, body):
+        settings = self.server.settings
+        time.sleep(settings["delay"])
+        if random.random() < settings["fail"]:
+            self.reply(503, b"injected failure\n")
+            return False
+        if body is not None:
+            self.reply(200, json.dumps(body).encode())
+        return True
+
+    def do_HEAD(self):
+        if self.answer(None):
+            self.send_response(200)
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+
+    def do_POST(self):
+        self.rfile.read(int(self.headers.get("Content-Length", 0)))
+        self.answer({"access_token": "standin-%d" % self.server.server_port})
+
+    def do_GET(self):
+        self.answer(energy_document())
+
+    def reply(self, code, body):
+        self.send_response(code)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        if self.command != "HEAD":
+            self.wfile.write(body)
+
+    def log_message(self, fmt, *args):
+        print(":%d %s" % (self.server.server_port, fmt % args), flush=True)
+
+
+class StandinServer(ThreadingHTTPServer):
+    daemon_threads = True
+    tls = None
+
+    def finish_request(self, request, client_address):
+        # Runs in the connection's thread, so a slow endpoint only delays
+        # its own clients.
+        if self.tls:
+            time.sleep(self.settings["delay"])
+            try:
+                request = self.tls.wrap_socket(request, server_side=True)
+            except (ssl.SSLError, OSError):
+                return
+        super().finish_request(request, client_address)
+
+
+def parse_spec(spec):
+    parts = spec.split(":")
+    if not 2 <= len(parts) <= 3:
+        raise argparse.ArgumentTypeError("expected PORT:DELAY_MS[:FAIL_RATE]")
+    fail = float(parts[2]) if len(parts) == 3 else 0.0
+    return int(parts[0]), float(parts[1]) / 1000.0, fail
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--endpoint", type=parse_spec, action="append",
+                        required=True, metavar="PORT:DELAY_MS[:FAIL_RATE]")
+    parser.add_argument("--cert", help="certificate for HTTPS")
+    parser.add_argument("--key", help="private key for HTTPS")
+    args = parser.parse_args()
+    tls = None
+    if args.cert:
+        tls = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        tls.load_cert_chain(args.cert, args.key)
+    servers = {}
+    for port, delay, fail in args.endpoint:
+        server = StandinServer(("", port), StandinHandler)
+        server.settings = {"delay": delay, "fail": fail}
+        server.tls = tls
+        servers[port] = server
+        threading.Thread(target=server.serve_forever, daemon=True).start()
+        print("listening on :%d, %.0f ms delay, %.0f %% failures" %
+              (port, delay * 1000, fail * 100), flush=True)
+    try:
+        for line in sys.stdin:
+            line = line.strip()
+            if not line:
+                continue
+            try:
+                port, delay, fail = parse_spec(line)
+                servers[port].settings = {"delay": delay, "fail": fail}
+                print(":%d now %.0f ms delay, %.0f %% failures" %
+                      (port, delay * 1000, fail * 100), flush=True)
+            except (argparse.ArgumentTypeError, ValueError, KeyError):
+                print("expected PORT:DELAY_MS[:FAIL_RATE] of a running endpoint",
+                      flush=True)
+        # Keep serving when stdin is closed, e.g. when run in the background
+        threading.Event().wait()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
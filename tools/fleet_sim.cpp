@@ -0,0 +1,672 @@
+/*
+  fleet_sim — Many displays polling one server, simulated on a host.
+
+  Runs N virtual devices against a real HTTP server (a shared gateway, a
+  meter or ``tools/endpoint_standin.py``).  Each device runs the firmware's
+  own FetchSchedule, reads every answer through the JsonFieldMap and hashes
+  it like the firmware does.  Devices power up spread over one refresh
+  interval and their clocks run up to ``--drift`` ppm fast or slow, like
+  the crystals of real units.  Simulated time runs ``--speed`` times faster
+  than real time, so the server sees the load of N x speed devices polling
+  at their real pace; the latencies it shows are real.
+
+  Two events can be injected: ``--power-cut AT`` reboots every device at AT
+  seconds, as after a power failure, and ``--net-outage AT:LEN`` makes every
+  request fail for LEN seconds, as when the uplink is down.  Both line the
+  fleet up; the report shows the request-rate peaks that follow and the
+  server's latency percentiles before and after.  "late" is how long after
+  their due time devices fetched because all simulator threads were busy;
+  add ``--threads`` or lower ``--speed`` if it is not near zero.
+
+  Build:  g++ -O2 -std=c++17 -pthread -Isrc -o fleet_sim tools/fleet_sim.cpp \
+              src/fetch_schedule.cpp src/json_mapping.cpp src/content_hash.cpp
+  Usage:  ./fleet_sim [options] http://host:port/path   (--help for options)
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netdb.h>
+#include <poll.h>
+#include <queue>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "content_hash.h"
+#include "fetch_schedule.h"
+#include "json_mapping.h"
+
+struct Options {
+  unsigned devices = 500;
+  unsigned threads = 0;
+  double duration = 1800;  // simulated seconds
+  double speed = 10;
+  double refresh = 300;
+  double retry = 180;
+  double spread = -1;  // power-up spread, default one refresh interval
+  double drift = 50;   // ppm
+  double powerCut = -1;
+  double bootDelay = 2;   // shortest setup() after power returns, seconds
+  double bootJitter = 4;  // spread of setup() durations
+  double outageAt = -1;
+  double outageLen = 0;
+  int timeoutMs = 5000;  // HTTPClient's default
+  const char *map = nullptr;
+  const char *login = nullptr;
+  const char *url = nullptr;
+  const char *csv = nullptr;
+  unsigned seed = 1;
+};
+
+struct Url {
+  std::string host;
+  std::string port;
+  std::string path;
+  addrinfo *addr = nullptr;
+};
+
+enum class Outcome : uint8_t { OK, OUTAGE, CONNECT, TIMEOUT, STATUS, PARSE };
+static const char *const OUTCOME_NAMES[] = {"ok", "outage", "connect", "timeout",
+                                            "http status", "parse"};
+constexpr int OUTCOMES = 6;
+
+struct Request {
+  double at;       // simulated seconds
+  float latency;   // real milliseconds
+  Outcome outcome;
+};
+
+struct Device {
+  FetchSchedule schedule;
+  double bootAt;  // simulated milliseconds
+  double rate;    // device milliseconds per simulated millisecond
+  double dueAt;   // simulated time the next fetch is due
+  uint32_t last;  // device millis() of the last fetch
+  uint32_t lastHash;
+  bool hashValid;
+  bool rebooted;
+};
+
+struct Stats {
+  std::vector<Request> requests;
+  std::vector<double> late;  // simulated milliseconds
+  uint64_t fetches = 0;
+  uint64_t unchanged = 0;
+  uint64_t prewarms = 0;
+};
+
+static Options opt;
+static Url target;
+static Url loginTarget;
+static std::chrono::steady_clock::time_point startTime;
+
+// Simulated milliseconds since the start.
+static double simNow() {
+  std::chrono::duration<double, std::milli> real = std::chrono::steady_clock::now() - startTime;
+  return real.count() * opt.speed;
+}
+
+static bool parseUrl(const char *text, Url &url) {
+  const char *p = text;
+  if (strncmp(p, "http://", 7) != 0) {
+    fprintf(stderr, "%s: only http:// URLs are supported\n", text);
+    return false;
+  }
+  p += 7;
+  const char *slash = strchr(p, '/');
+  std::string hostPort = slash ? std::string(p, slash) : std::string(p);
+  url.path = slash ? slash : "/";
+  size_t colon = hostPort.rfind(':');
+  url.host = colon == std::string::npos ? hostPort : hostPort.substr(0, colon);
+  url.port = colon == std::string::npos ? "80" : hostPort.substr(colon + 1);
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  int rc = getaddrinfo(url.host.c_str(), url.port.c_str(), &hints, &url.addr);
+  if (rc != 0) {
+    fprintf(stderr, "%s: %s\n", url.host.c_str(), gai_strerror(rc));
+    return false;
+  }
+  return true;
+}
+
+// Wait until ``fd`` is ready for ``events`` or the deadline passes.
+static bool waitFor(int fd, short events, std::chrono::steady_clock::time_point deadline) {
+  auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - std::chrono::steady_clock::now());
+  if (left.count() <= 0) {
+    return false;
+  }
+  pollfd p = {fd, events, 0};
+  return poll(&p, 1, static_cast<int>(left.count())) > 0;
+}
+
+// One HTTP/1.1 request on a new connection, like HTTPClient after a cold
+// start.  The body of a 200 answer goes through ``map`` and ``hash``.
+static Outcome httpRequest(const Url &url, const char *method, const std::string &body,
+                           JsonFieldMap *map, Xxh32 *hash) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(opt.timeoutMs);
+  int fd = socket(url.addr->ai_family, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return Outcome::CONNECT;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  Outcome result = Outcome::CONNECT;
+  int rc = connect(fd, url.addr->ai_addr, url.addr->ai_addrlen);
+  if (rc < 0 && errno == EINPROGRESS) {
+    if (!waitFor(fd, POLLOUT, deadline)) {
+      close(fd);
+      return Outcome::TIMEOUT;
+    }
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+    rc = err ? -1 : 0;
+  }
+  if (rc < 0) {
+    close(fd);
+    return result;
+  }
+
+  std::string req = std::string(method) + " " + url.path + " HTTP/1.1\r\nHost: " + url.host +
+                    "\r\nUser-Agent: fleet_sim\r\nConnection: close\r\n";
+  if (!body.empty()) {
+    req += "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) +
+           "\r\n";
+  }
+  req += "\r\n" + body;
+  size_t sent = 0;
+  while (sent < req.size()) {
+    ssize_t n = send(fd, req.data() + sent, req.size() - sent, MSG_NOSIGNAL);
+    if (n > 0) {
+      sent += n;
+    } else if (n < 0 && errno == EAGAIN && waitFor(fd, POLLOUT, deadline)) {
+      continue;
+    } else {
+      close(fd);
+      return n < 0 && errno == EAGAIN ? Outcome::TIMEOUT : Outcome::CONNECT;
+    }
+  }
+
+  // Read the header, then feed the body until Content-Length bytes or
+  // the end of the connection.
+  std::string head;
+  long remaining = -1;
+  bool inBody = false;
+  int status = 0;
+  char buf[4096];
+  if (map) {
+    map->begin();
+  }
+  for (;;) {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n < 0 && errno == EAGAIN) {
+      if (!waitFor(fd, POLLIN, deadline)) {
+        result = Outcome::TIMEOUT;
+        break;
+      }
+      continue;
+    }
+    if (n <= 0) {
+      result = !inBody || remaining > 0 ? Outcome::CONNECT : Outcome::OK;
+      break;
+    }
+    const char *data = buf;
+    size_t len = n;
+    if (!inBody) {
+      head.append(buf, n);
+      size_t end = head.find("\r\n\r\n");
+      if (end == std::string::npos) {
+        continue;
+      }
+      status = atoi(head.c_str() + head.find(' ') + 1);
+      for (size_t pos = head.find("\r\n"); pos < end; pos = head.find("\r\n", pos + 2)) {
+        if (strncasecmp(head.c_str() + pos + 2, "Content-Length:", 15) == 0) {
+          remaining = atol(head.c_str() + pos + 17);
+        }
+      }
+      inBody = true;
+      size_t bodyStart = end + 4;
+      data = buf + (n - (head.size() - bodyStart));
+      len = head.size() - bodyStart;
+    }
+    if (status == 200) {
+      if (map) {
+        map->feed(reinterpret_cast<const uint8_t *>(data), len);
+      }
+      if (hash) {
+        hash->update(reinterpret_cast<const uint8_t *>(data), len);
+      }
+    }
+    if (remaining >= 0) {
+      remaining -= len;
+      if (remaining <= 0) {
+        result = Outcome::OK;
+        break;
+      }
+    }
+  }
+  close(fd);
+  if (result != Outcome::OK) {
+    return result;
+  }
+  if (status != 200) {
+    return Outcome::STATUS;
+  }
+  return map && !map->complete() ? Outcome::PARSE : Outcome::OK;
+}
+
+static void record(Stats &stats, double at, std::chrono::steady_clock::time_point t0,
+                   Outcome outcome) {
+  std::chrono::duration<float, std::milli> ms = std::chrono::steady_clock::now() - t0;
+  stats.requests.push_back({at / 1000.0, ms.count(), outcome});
+}
+
+// One fetch of a device: the login of the cloud mode if configured, then
+// the data request.  Requests during the network outage fail at once.
+static bool fetch(Device &dev, JsonFieldMap &map, Stats &stats) {
+  double at = simNow();
+  bool outage = opt.outageAt >= 0 && at >= opt.outageAt * 1000 &&
+                at < (opt.outageAt + opt.outageLen) * 1000;
+  if (outage) {
+    stats.requests.push_back({at / 1000.0, 0, Outcome::OUTAGE});
+    return false;
+  }
+  if (opt.login) {
+    auto t0 = std::chrono::steady_clock::now();
+    Outcome o = httpRequest(loginTarget, "POST", "{\"userAccount\":\"fleet\"}", nullptr, nullptr);
+    record(stats, at, t0, o);
+    if (o != Outcome::OK) {
+      return false;
+    }
+    at = simNow();
+  }
+  Xxh32 hash;
+  auto t0 = std::chrono::steady_clock::now();
+  Outcome o = httpRequest(target, "GET", std::string(), &map, &hash);
+  record(stats, at, t0, o);
+  if (o != Outcome::OK) {
+    dev.hashValid = false;
+    return false;
+  }
+  uint32_t digest = hash.digest();
+  if (dev.hashValid && digest == dev.lastHash) {
+    ++stats.unchanged;
+  }
+  dev.lastHash = digest;
+  dev.hashValid = true;
+  return true;
+}
+
+static void powerUp(Device &dev, double at, std::mt19937 &rng) {
+  std::uniform_real_distribution<double> ppm(-opt.drift, opt.drift);
+  dev.schedule = FetchSchedule();
+  dev.schedule.configure(static_cast<uint32_t>(opt.refresh * 1000),
+                         static_cast<uint32_t>(opt.retry * 1000));
+  dev.bootAt = at;
+  dev.rate = 1.0 + ppm(rng) * 1e-6;
+  dev.dueAt = at;
+  dev.last = 0;
+  dev.hashValid = false;
+}
+
+static uint32_t deviceMillis(const Device &dev, double sim) {
+  return static_cast<uint32_t>(static_cast<uint64_t>((sim - dev.bootAt) * dev.rate));
+}
+
+// Let a device run its loop() at ``sim`` and return when it next has
+// something to do.
+static double step(Device &dev, double sim, JsonFieldMap &map, Stats &stats, std::mt19937 &rng) {
+  if (opt.powerCut >= 0 && !dev.rebooted && sim >= opt.powerCut * 1000) {
+    std::uniform_real_distribution<double> setup(opt.bootDelay, opt.bootDelay + opt.bootJitter);
+    powerUp(dev, (opt.powerCut + setup(rng)) * 1000, rng);
+    dev.rebooted = true;
+  }
+  if (sim < dev.bootAt) {
+    return dev.bootAt;
+  }
+  uint32_t now = deviceMillis(dev, sim);
+  if (dev.schedule.prewarmDue(now)) {
+    ++stats.prewarms;
+  }
+  if (dev.schedule.due(now)) {
+    stats.late.push_back(std::max(0.0, sim - dev.dueAt));
+    dev.schedule.begin(now);
+    dev.last = now;
+    ++stats.fetches;
+    if (fetch(dev, map, stats)) {
+      dev.schedule.succeeded();
+    } else {
+      dev.schedule.failed();
+    }
+    dev.dueAt = sim + dev.schedule.interval() / dev.rate;
+    sim = simNow();
+  }
+  uint32_t interval = dev.schedule.interval();
+  uint32_t elapsed = deviceMillis(dev, sim) - dev.last;
+  double wait = 0;
+  if (interval > PREWARM_LEAD_MS && elapsed < interval - PREWARM_LEAD_MS) {
+    wait = interval - PREWARM_LEAD_MS - elapsed;
+  } else if (elapsed < interval) {
+    wait = interval - elapsed;
+  }
+  double next = sim + wait / dev.rate;
+  if (opt.powerCut >= 0 && !dev.rebooted) {
+    next = std::min(next, opt.powerCut * 1000);
+  }
+  return next;
+}
+
+// Devices of one thread, woken in order of their next event.
+static void runThread(unsigned index, unsigned count, Stats &stats) {
+  std::mt19937 rng(opt.seed * 7919 + index);
+  JsonFieldMap map;
+  if (opt.map) {
+    char err[64];
+    map.compile(opt.map, err, sizeof(err));  // checked in main()
+  }
+  std::vector<Device> devices(count);
+  std::uniform_real_distribution<double> boot(0, opt.spread * 1000);
+  typedef std::pair<double, unsigned> Wake;
+  std::priority_queue<Wake, std::vector<Wake>, std::greater<Wake>> queue;
+  for (unsigned i = 0; i < count; ++i) {
+    powerUp(devices[i], boot(rng), rng);
+    devices[i].rebooted = false;
+    queue.push({devices[i].bootAt, i});
+  }
+  const double end = opt.duration * 1000;
+  while (!queue.empty()) {
+    double sim = simNow();
+    if (sim >= end) {
+      break;
+    }
+    Wake w = queue.top();
+    if (w.first > sim) {
+      double realMs = std::min(w.first, end) - sim;
+      realMs = std::min(realMs / opt.speed, 20.0);
+      std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(realMs));
+      continue;
+    }
+    queue.pop();
+    queue.push({step(devices[w.second], sim, map, stats, rng), w.second});
+  }
+}
+
+static double percentile(std::vector<float> &v, double p) {
+  if (v.empty()) {
+    return NAN;
+  }
+  size_t i = std::min(v.size() - 1, static_cast<size_t>(p * v.size()));
+  std::nth_element(v.begin(), v.begin() + i, v.end());
+  return v[i];
+}
+
+// Latency of the requests that reached the server in [from, to).
+static void printPhase(const char *name, const std::vector<Request> &all, double from, double to) {
+  std::vector<float> lat;
+  unsigned failed = 0;
+  for (const Request &r : all) {
+    if (r.at >= from && r.at < to && r.outcome != Outcome::OUTAGE) {
+      lat.push_back(r.latency);
+      failed += r.outcome != Outcome::OK;
+    }
+  }
+  if (lat.empty()) {
+    printf("  %-22s no requests\n", name);
+    return;
+  }
+  double p50 = percentile(lat, 0.50), p90 = percentile(lat, 0.90);
+  double p99 = percentile(lat, 0.99);
+  printf("  %-22s %7zu req  p50 %7.1f  p90 %7.1f  p99 %7.1f  max %7.1f ms  %u failed\n",
+         name, lat.size(), p50, p90, p99, *std::max_element(lat.begin(), lat.end()), failed);
+}
+
+// Largest request count within ``window`` seconds starting in [from, to).
+static void printPeak(const char *name, const std::vector<unsigned> &perSecond, double from,
+                      double to, double mean) {
+  unsigned window = std::max(1u, static_cast<unsigned>(opt.duration / 120));
+  unsigned best = 0, bestAt = 0;
+  for (unsigned s = static_cast<unsigned>(std::max(0.0, from));
+       s < to && s + window <= perSecond.size(); ++s) {
+    unsigned n = 0;
+    for (unsigned k = 0; k < window; ++k) {
+      n += perSecond[s + k];
+    }
+    if (n > best) {
+      best = n;
+      bestAt = s;
+    }
+  }
+  double rate = static_cast<double>(best) / window;
+  printf("  %-22s %8.1f req/s at %us (%.1fx the mean; %.0f req/s at the server)\n", name, rate,
+         bestAt, mean > 0 ? rate / mean : 0.0, rate * opt.speed);
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [options] http://host:port/path\n"
+          "  --devices N         virtual devices (500)\n"
+          "  --threads N         simulator threads (hardware threads x 4)\n"
+          "  --duration S        simulated seconds (1800)\n"
+          "  --speed X           simulated seconds per real second (10)\n"
+          "  --refresh S         refresh interval (300)\n"
+          "  --retry S           retry interval after a failure (180)\n"
+          "  --spread S          devices power up within S seconds (refresh)\n"
+          "  --drift PPM         clock error of the devices, +- (50)\n"
+          "  --power-cut AT      reboot every device at AT seconds\n"
+          "  --boot MIN:JITTER   seconds from power to first fetch (2:4)\n"
+          "  --net-outage AT:LEN fail every request from AT for LEN seconds\n"
+          "  --timeout MS        connect and read timeout (5000)\n"
+          "  --map MAPPING       field_map of the devices (built-in)\n"
+          "  --login URL         POST here before every fetch, as the cloud mode\n"
+          "  --csv FILE          write requests and failures per second\n"
+          "  --seed N            random seed (1)\n",
+          argv0);
+}
+
+static bool parseArgs(int argc, char **argv) {
+  for (int i = 1; i < argc; ++i) {
+    const char *a = argv[i];
+    if (a[0] != '-') {
+      opt.url = a;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      return false;
+    }
+    const char *v = argv[++i];
+    if (!strcmp(a, "--devices")) {
+      opt.devices = atoi(v);
+    } else if (!strcmp(a, "--threads")) {
+      opt.threads = atoi(v);
+    } else if (!strcmp(a, "--duration")) {
+      opt.duration = atof(v);
+    } else if (!strcmp(a, "--speed")) {
+      opt.speed = atof(v);
+    } else if (!strcmp(a, "--refresh")) {
+      opt.refresh = atof(v);
+    } else if (!strcmp(a, "--retry")) {
+      opt.retry = atof(v);
+    } else if (!strcmp(a, "--spread")) {
+      opt.spread = atof(v);
+    } else if (!strcmp(a, "--drift")) {
+      opt.drift = atof(v);
+    } else if (!strcmp(a, "--power-cut")) {
+      opt.powerCut = atof(v);
+    } else if (!strcmp(a, "--boot")) {
+      if (sscanf(v, "%lf:%lf", &opt.bootDelay, &opt.bootJitter) != 2) {
+        return false;
+      }
+    } else if (!strcmp(a, "--net-outage")) {
+      if (sscanf(v, "%lf:%lf", &opt.outageAt, &opt.outageLen) != 2) {
+        return false;
+      }
+    } else if (!strcmp(a, "--timeout")) {
+      opt.timeoutMs = atoi(v);
+    } else if (!strcmp(a, "--map")) {
+      opt.map = v;
+    } else if (!strcmp(a, "--login")) {
+      opt.login = v;
+    } else if (!strcmp(a, "--csv")) {
+      opt.csv = v;
+    } else if (!strcmp(a, "--seed")) {
+      opt.seed = atoi(v);
+    } else {
+      return false;
+    }
+  }
+  return opt.url && opt.devices > 0 && opt.speed > 0 && opt.duration > 0 && opt.refresh > 0 &&
+         opt.retry > 0;
+}
+
+int main(int argc, char **argv) {
+  if (!parseArgs(argc, argv)) {
+    usage(argv[0]);
+    return 2;
+  }
+  if (opt.map) {
+    JsonFieldMap map;
+    char err[64];
+    if (!map.compile(opt.map, err, sizeof(err))) {
+      fprintf(stderr, "invalid mapping: %s\n", err);
+      return 1;
+    }
+  }
+  if (!parseUrl(opt.url, target) || (opt.login && !parseUrl(opt.login, loginTarget))) {
+    return 1;
+  }
+  if (opt.spread < 0) {
+    opt.spread = opt.refresh;
+  }
+  if (opt.threads == 0) {
+    opt.threads = std::max(1u, std::thread::hardware_concurrency()) * 4;
+  }
+  opt.threads = std::min(opt.threads, opt.devices);
+
+  printf("%u devices on %u threads, %.0f s at %gx, refresh %g s, retry %g s\n", opt.devices,
+         opt.threads, opt.duration, opt.speed, opt.refresh, opt.retry);
+  std::vector<Stats> stats(opt.threads);
+  std::vector<std::thread> threads;
+  startTime = std::chrono::steady_clock::now();
+  for (unsigned t = 0; t < opt.threads; ++t) {
+    unsigned first = opt.devices * t / opt.threads;
+    unsigned last = opt.devices * (t + 1) / opt.threads;
+    threads.emplace_back(runThread, t, last - first, std::ref(stats[t]));
+  }
+  for (std::thread &t : threads) {
+    t.join();
+  }
+
+  Stats all;
+  for (Stats &s : stats) {
+    all.requests.insert(all.requests.end(), s.requests.begin(), s.requests.end());
+    all.late.insert(all.late.end(), s.late.begin(), s.late.end());
+    all.fetches += s.fetches;
+    all.unchanged += s.unchanged;
+    all.prewarms += s.prewarms;
+  }
+  unsigned seconds = static_cast<unsigned>(ceil(opt.duration));
+  std::vector<unsigned> perSecond(seconds + 1), failedPerSecond(seconds + 1);
+  unsigned outcomes[OUTCOMES] = {};
+  for (const Request &r : all.requests) {
+    unsigned s = std::min(seconds, static_cast<unsigned>(r.at));
+    ++perSecond[s];
+    failedPerSecond[s] += r.outcome != Outcome::OK;
+    ++outcomes[static_cast<int>(r.outcome)];
+  }
+
+  printf("%llu fetches, %zu requests, %llu unchanged bodies, %llu pre-warms\n",
+         static_cast<unsigned long long>(all.fetches), all.requests.size(),
+         static_cast<unsigned long long>(all.unchanged),
+         static_cast<unsigned long long>(all.prewarms));
+  printf("outcomes:");
+  for (int i = 0; i < OUTCOMES; ++i) {
+    printf(" %s %u%s", OUTCOME_NAMES[i], outcomes[i], i + 1 < OUTCOMES ? "," : "\n");
+  }
+
+  // Steady state is the time before the first event, after every device
+  // has powered up.
+  double firstEvent = opt.duration;
+  if (opt.powerCut >= 0) {
+    firstEvent = std::min(firstEvent, opt.powerCut);
+  }
+  if (opt.outageAt >= 0) {
+    firstEvent = std::min(firstEvent, opt.outageAt);
+  }
+  double steadyFrom = std::min(opt.spread, firstEvent);
+  double steadyReq = 0;
+  for (unsigned s = static_cast<unsigned>(steadyFrom); s < firstEvent && s < seconds; ++s) {
+    steadyReq += perSecond[s];
+  }
+  double mean = firstEvent > steadyFrom ? steadyReq / (firstEvent - steadyFrom)
+                                        : static_cast<double>(all.requests.size()) / opt.duration;
+  printf("request rate (simulated time), mean %.2f req/s in steady state:\n", mean);
+  printPeak("steady state", perSecond, steadyFrom, firstEvent, mean);
+  double herd = opt.refresh + opt.retry;
+  if (opt.powerCut >= 0) {
+    printPeak("after power cut", perSecond, opt.powerCut, opt.powerCut + herd, mean);
+  }
+  if (opt.outageAt >= 0) {
+    double back = opt.outageAt + opt.outageLen;
+    printPeak("after outage", perSecond, back, back + herd, mean);
+  }
+
+  printf("latency at the server (real time):\n");
+  printPhase("steady state", all.requests, steadyFrom, firstEvent);
+  if (opt.powerCut >= 0) {
+    printPhase("after power cut", all.requests, opt.powerCut, opt.powerCut + herd);
+  }
+  if (opt.outageAt >= 0) {
+    double back = opt.outageAt + opt.outageLen;
+    printPhase("after outage", all.requests, back, back + herd);
+  }
+  printPhase("whole run", all.requests, 0, opt.duration + 1);
+
+  std::vector<float> late(all.late.begin(), all.late.end());
+  printf("late: p50 %.0f  p99 %.0f  max %.0f ms (simulated)\n", percentile(late, 0.5),
+         percentile(late, 0.99), late.empty() ? 0.0 : *std::max_element(late.begin(), late.end()));
+
+  // Coarse timeline, about 40 rows.
+  unsigned bucket = std::max(1u, seconds / 40);
+  unsigned peak = 1;
+  std::vector<unsigned> rows;
+  for (unsigned s = 0; s < seconds; s += bucket) {
+    unsigned n = 0;
+    for (unsigned k = s; k < s + bucket && k < seconds; ++k) {
+      n += perSecond[k];
+    }
+    rows.push_back(n);
+    peak = std::max(peak, n);
+  }
+  printf("requests per %u s:\n", bucket);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    printf("  %6zus %6u %s\n", i * bucket, rows[i], std::string(rows[i] * 50 / peak, '#').c_str());
+  }
+
+  if (opt.csv) {
+    FILE *f = fopen(opt.csv, "w");
+    if (!f) {
+      perror(opt.csv);
+      return 1;
+    }
+    fprintf(f, "second,requests,failed\n");
+    for (unsigned s = 0; s < seconds; ++s) {
+      fprintf(f, "%u,%u,%u\n", s, perSecond[s], failedPerSecond[s]);
+    }
+    fclose(f);
+  }
+  freeaddrinfo(target.addr);
+  if (loginTarget.addr) {
+    freeaddrinfo(loginTarget.addr);
+  }
+  return 0;
+}
@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""
+font_subset — Cut a VLW font down to the characters the firmware draws.
+
+Scans the firmware sources for every function that calls one of the text
+drawing functions given with ``--calls`` (default: drawValueText) and
+collects the characters of the string literals in those functions.  printf
+conversions are expanded to the characters they can produce (``%5.2f`` to
+digits, sign and decimal point), ``%%`` to ``%``.  The font is then
+rewritten with only those glyphs, in the same VLW format:
+
+    python3 tools/font_subset.py NotoSans-Bold-20.vlw data/fonts/values.vlw
+
+Conversions whose output cannot be known (``%s``, ``%c``) are reported;
+add the characters they may print with ``--extra``.
+"""
+
+import argparse
+import glob
+import os
+import re
+import struct
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+HEADER = struct.Struct(">6i")
+METRICS = struct.Struct(">7i")
+
+STRING = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+COMMENT = re.compile(r"//[^\n]*|/\*.*?\*/", re.S)
+FUNCTION = re.compile(r"^[A-Za-z_][\w:<>\s\*&]*?\b(\w+)\s*\([^;{]*\)\s*(?:const\s*)?\{", re.M)
+CONVERSION = re.compile(r"%([-+ #0]*)(\d+|\*)?(?:\.(\d+|\*))?(hh|h|ll|l|z|j|t|L)?([diouxXfFeEgGcsp%])")
+
+DIGITS = "0123456789"
+EXPANSIONS = {
+    "d": DIGITS + "-", "i": DIGITS + "-", "u": DIGITS, "o": "01234567",
+    "x": DIGITS + "abcdef", "X": DIGITS + "ABCDEF",
+    "f": DIGITS + "-.", "F": DIGITS + "-.",
+    "e": DIGITS + "-.e+", "E": DIGITS + "-.E+",
+    "g": DIGITS + "-.e+", "G": DIGITS + "-.E+",
+    "p": DIGITS + "abcdefx",
+}
+
+
+def unescape(literal):
+    return bytes(literal, "utf-8").decode("unicode_escape").encode("latin-1").decode("utf-8")
+
+
+def function_bodies(text):
+    """Yield (name, body) of every function definition in ``text``."""
+    for m in FUNCTION.finditer(text):
+        depth = 0
+        for i in range(m.end() - 1, len(text)):
+            if text[i] == "{":
+                depth += 1
+            elif text[i] == "}":
+                depth -= 1
+                if depth == 0:
+                    yield m.group(1), text[m.end():i]
+                    break
+
+
+def used_characters(sources, calls):
+    chars = set(" ")
+    unknown = []
+    pattern = re.compile(r"\b(?:%s)\s*\(" % "|".join(map(re.escape, calls)))
+    for path in sources:
+        with open(path, encoding="utf-8") as f:
+            text = COMMENT.sub("", f.read())
+        for name, body in function_bodies(text):
+            if name in calls or not pattern.search(body):
+                continue
+            for literal in STRING.findall(body):
+                s = unescape(literal)
+                pos = 0
+                for conv in CONVERSION.finditer(s):
+                    chars.update(s[pos:conv.start()])
+                    pos = conv.end()
+                    kind = conv.group(5)
+                    if kind == "%":
+                        chars.add("%")
+                    elif kind in EXPANSIONS:
+                        chars.update(EXPANSIONS[kind])
+                    else:
+                        unknown.append("%s: %s in %s()" % (os.path.relpath(path, ROOT),
+                                                           conv.group(0), name))
+                chars.update(s[pos:])
+    return chars, unknown
+
+
+def subset(src, dst, chars):
+    with open(src, "rb") as f:
+        data = f.read()
+    header = list(HEADER.unpack_from(data))
+    count = header[0]
+    bitmaps = HEADER.size + count * METRICS.size
+    if count <= 0 or bitmaps > len(data):
+        sys.exit("%s: not a VLW font" % src)
+    offset = bitmaps
+    kept = []
+    for i in range(count):
+        metrics = METRICS.unpack_from(data, HEADER.size + i * METRICS.size)
+        size = metrics[1] * metrics[2]
+        if chr(metrics[0]) in chars:
+            kept.append((metrics, data[offset:offset + size]))
+        offset += size
+    missing = sorted(c for c in chars if ord(c) not in {m[0] for m, _ in kept})
+    header[0] = len(kept)
+    out = HEADER.pack(*header)
+    out += b"".join(METRICS.pack(*m) for m, _ in kept)
+    out += b"".join(b for _, b in kept)
+    os.makedirs(os.path.dirname(os.path.abspath(dst)), exist_ok=True)
+    with open(dst, "wb") as f:
+        f.write(out)
+    return count, len(kept), len(data), len(out), missing
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("font", help="VLW font to subset")
+    parser.add_argument("output", help="VLW file to write")
+    parser.add_argument("--calls", default="drawValueText",
+                        help="comma-separated drawing functions whose callers are scanned")
+    parser.add_argument("--sources", nargs="*",
+                        default=sorted(glob.glob(os.path.join(ROOT, "src", "*.cpp"))))
+    parser.add_argument("--extra", default="", help="characters to keep in addition")
+    args = parser.parse_args()
+
+    chars, unknown = used_characters(args.sources, args.calls.split(","))
+    chars.update(args.extra)
+    for u in unknown:
+        print("warning: cannot tell what %s prints; use --extra" % u, file=sys.stderr)
+    total, kept, before, after, missing = subset(args.font, args.output, chars)
+    print("characters: %s" % "".join(sorted(chars)))
+    if missing:
+        print("warning: not in the font: %s" % "".join(missing), file=sys.stderr)
+    print("%d of %d glyphs, %d -> %d bytes" % (kept, total, before, after))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
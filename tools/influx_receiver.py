@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""
+influx_receiver.py — Local stand-in for the InfluxDB v2 write endpoint.
+
+Accepts ``POST /api/v2/write`` with optional gzip encoding, prints every
+received line and answers 204 like InfluxDB.  Failures can be injected to
+watch the exporter back off and spill to flash:
+
+    python3 tools/influx_receiver.py --port 8086 --fail-first 5 --fail-rate 0.2
+
+Set ``INFLUX_WRITE_URL`` in ``secrets.h`` to
+``http://<host-ip>:8086/api/v2/write?org=x&bucket=y&precision=s``.
+"""
+
+import argparse
+import gzip
+import random
+import sys
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+
+class WriteHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    requests_seen = 0
+    lines_seen = 0
+
+    def do_POST(self):
+        cls = type(self)
+        cls.requests_seen += 1
+        length = int(self.headers.get("Content-Length", 0))
+        body = self.rfile.read(length)
+        args = self.server.args
+        if args.delay:
+            time.sleep(args.delay)
+        if (cls.requests_seen <= args.fail_first or
+                random.random() < args.fail_rate):
+            self.reply(503, b"injected failure\n")
+            return
+        if not self.path.startswith("/api/v2/write"):
+            self.reply(404, b"not found\n")
+            return
+        if self.headers.get("Content-Encoding") == "gzip":
+            try:
+                body = gzip.decompress(body)
+            except OSError as exc:
+                self.reply(400, ("bad gzip: %s\n" % exc).encode())
+                return
+        lines = [l for l in body.decode("utf-8").split("\n") if l]
+        cls.lines_seen += len(lines)
+        print("request %d: %d bytes on the wire, %d lines (total %d)" %
+              (cls.requests_seen, length, len(lines), cls.lines_seen))
+        for line in lines:
+            print("  " + line)
+        sys.stdout.flush()
+        self.reply(204, b"")
+
+    def reply(self, code, body):
+        self.send_response(code)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, fmt, *args):
+        pass
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--port", type=int, default=8086)
+    parser.add_argument("--fail-first", type=int, default=0,
+                        help="answer 503 to the first N requests")
+    parser.add_argument("--fail-rate", type=float, default=0.0,
+                        help="probability of answering 503 afterwards")
+    parser.add_argument("--delay", type=float, default=0.0,
+                        help="seconds to wait before answering")
+    args = parser.parse_args()
+    server = ThreadingHTTPServer(("", args.port), WriteHandler)
+    server.args = args
+    print("listening on :%d" % args.port, flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
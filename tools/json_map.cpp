@@ -0,0 +1,72 @@
+/*
+  json_map — Try a field mapping on a saved API response.
+
+  Compiles the mapping with the same code the firmware uses, scans the
+  file with it and prints the values the display would show, followed by
+  the time the scan took.  Useful to write a ``field_map`` for a new meter
+  before configuring the device, e.g. from ``curl -o resp.json <endpoint>``.
+
+  Build:  g++ -O2 -std=c++17 -Isrc -o json_map tools/json_map.cpp src/json_mapping.cpp
+  Usage:  ./json_map '<mapping>' <file>      ('' for the built-in mapping)
+*/
+
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+#include "json_mapping.h"
+
+static void printCurve(const char *name, const float *values, size_t length) {
+  printf("%-12s", name);
+  // Points beyond CURVE_POINTS are counted but not stored
+  for (size_t i = 0; i < length && i < JsonFieldMap::CURVE_POINTS; ++i) {
+    printf(" %g", values[i]);
+  }
+  printf("  (%zu points)\n", length);
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s '<mapping>' <file>\n", argv[0]);
+    return 2;
+  }
+  JsonFieldMap map;
+  char err[64];
+  if (!map.compile(argv[1][0] ? argv[1] : DEFAULT_FIELD_MAP, err, sizeof(err))) {
+    fprintf(stderr, "invalid mapping: %s\n", err);
+    return 1;
+  }
+  FILE *f = fopen(argv[2], "rb");
+  if (!f) {
+    perror(argv[2]);
+    return 1;
+  }
+  std::vector<uint8_t> data;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    data.insert(data.end(), buf, buf + n);
+  }
+  fclose(f);
+
+  const int reps = 1000;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; ++r) {
+    map.begin();
+    map.feed(data.data(), data.size());
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  if (!map.complete()) {
+    fprintf(stderr, "%s: not a complete JSON document\n", argv[2]);
+    return 1;
+  }
+  const JsonFieldMap::Fields &v = map.fields();
+  printf("%-12s %g\n", "battery", v.battery);
+  printf("%-12s %g\n", "generation", v.generation);
+  printf("%-12s %g\n", "consumption", v.consumption);
+  printCurve("gen_curve", v.gen, v.genLength);
+  printCurve("cons_curve", v.cons, v.consLength);
+  printf("%zu bytes in %.2f us\n", data.size(),
+         std::chrono::duration<double, std::micro>(t1 - t0).count() / reps);
+  return 0;
+}
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""
+meter_replay.py — Feed meter telegrams through a pseudo terminal.
+
+Creates a pty pair and writes SML or D0 telegrams to the master side at a
+fixed interval, emulating the optical head of a smart-meter.  Point
+``tools/sml_dump`` (or any serial program) at the printed slave path to
+exercise the parsers in ``src/meter_parsers.cpp`` on a Linux host:
+
+    python3 tools/meter_replay.py --sml                # synthetic telegrams
+    python3 tools/meter_replay.py --file capture.bin   # recorded raw bytes
+    ./sml_dump /dev/pts/7
+
+Recorded captures are replayed verbatim; split multiple telegrams with
+``--interval`` to keep the original cadence.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+import tty
+
+
+def crc16_x25(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0x8408 if crc & 1 else crc >> 1
+    return crc ^ 0xFFFF
+
+
+def tl_octets(data):
+    return bytes([len(data) + 1]) + data
+
+
+def tl_uint(value, size):
+    return bytes([0x60 | (size + 1)]) + value.to_bytes(size, "big")
+
+
+def tl_int(value, size):
+    return bytes([0x50 | (size + 1)]) + value.to_bytes(size, "big", signed=True)
+
+
+def tl_list(*items):
+    return bytes([0x70 | len(items)]) + b"".join(items)
+
+
+OPTIONAL_ABSENT = b"\x01"
+
+
+def sml_message(txid, tag, body):
+    # SML_Message is a list of six: transactionId, groupNo, abortOnError,
+    # messageBody, crc16 and endOfSmlMsg.
+    head = (b"\x76" + tl_octets(txid) + tl_uint(0, 1) + tl_uint(0, 1) +
+            tl_list(tl_uint(tag, 2), body))
+    return head + tl_uint(crc16_x25(head), 2) + b"\x00"
+
+
+def list_entry(obis, unit, scaler, value):
+    return tl_list(tl_octets(bytes(obis)), OPTIONAL_ABSENT, OPTIONAL_ABSENT,
+                   tl_uint(unit, 1), tl_int(scaler, 1), tl_int(value, 8),
+                   OPTIONAL_ABSENT)
+
+
+def sml_telegram(import_wh, export_wh, power_w):
+    server_id = bytes.fromhex("0a01454d4800007a1b24")
+    open_res = tl_list(OPTIONAL_ABSENT, OPTIONAL_ABSENT, tl_octets(b"\x00\x01"),
+                       tl_octets(server_id), OPTIONAL_ABSENT, OPTIONAL_ABSENT)
+    values = tl_list(
+        list_entry([1, 0, 1, 8, 0, 255], 30, -1, int(import_wh * 10)),
+        list_entry([1, 0, 2, 8, 0, 255], 30, -1, int(export_wh * 10)),
+        list_entry([1, 0, 16, 7, 0, 255], 27, 0, int(power_w)),
+    )
+    get_list = tl_list(OPTIONAL_ABSENT, tl_octets(server_id),
+                       tl_octets(bytes([1, 0, 98, 10, 255, 255])),
+                       OPTIONAL_ABSENT, values, OPTIONAL_ABSENT, OPTIONAL_ABSENT)
+    close_res = tl_list(OPTIONAL_ABSENT)
+    payload = (sml_message(b"\x01", 0x0101, open_res) +
+               sml_message(b"\x02", 0x0701, get_list) +
+               sml_message(b"\x03", 0x0201, close_res))
+    payload = payload.replace(b"\x1b\x1b\x1b\x1b", b"\x1b\x1b\x1b\x1b" * 2)
+    fill = (4 - len(payload) % 4) % 4
+    frame = b"\x1b\x1b\x1b\x1b\x01\x01\x01\x01" + payload + b"\x00" * fill
+    frame += b"\x1b\x1b\x1b\x1b\x1a" + bytes([fill])
+    return frame + struct.pack("<H", crc16_x25(frame))
+
+
+def d0_telegram(import_wh, export_wh, power_w):
+    lines = [
+        "/ESY5Q3DA1004 V3.04",
+        "",
+        "1-0:0.0.0*255(1ESY1234567890)",
+        "1-0:1.8.0*255(%012.4f*kWh)" % (import_wh / 1000.0),
+        "1-0:2.8.0*255(%012.4f*kWh)" % (export_wh / 1000.0),
+        "1-0:16.7.0*255(%09.2f*W)" % power_w,
+        "!",
+    ]
+    return ("\r\n".join(lines) + "\r\n").encode("ascii")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    group = parser.add_mutually_exclusive_group()
+    group.add_argument("--sml", action="store_true", help="synthetic SML (default)")
+    group.add_argument("--d0", action="store_true", help="synthetic D0 telegrams")
+    group.add_argument("--file", help="replay a recorded capture")
+    parser.add_argument("--interval", type=float, default=1.0,
+                        help="seconds between telegrams")
+    parser.add_argument("--count", type=int, default=0,
+                        help="number of telegrams (0 = endless)")
+    args = parser.parse_args()
+
+    master, slave = os.openpty()
+    tty.setraw(slave)
+    print(os.ttyname(slave), flush=True)
+
+    recorded = open(args.file, "rb").read() if args.file else None
+    import_wh, export_wh = 1234567.8, 45678.9
+    sent = 0
+    try:
+        while args.count == 0 or sent < args.count:
+            power = 350 + 250 * ((sent % 20) - 10) / 10.0
+            import_wh += max(power, 0) * args.interval / 3600.0
+            export_wh += max(-power, 0) * args.interval / 3600.0
+            if recorded is not None:
+                data = recorded
+            elif args.d0:
+                data = d0_telegram(import_wh, export_wh, power)
+            else:
+                data = sml_telegram(import_wh, export_wh, power)
+            os.write(master, data)
+            sent += 1
+            time.sleep(args.interval)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,313 @@
+#!/usr/bin/env python3
+"""
+pack_assets — Pack PNG images into one indexed archive for the SD card.
+
+Every image is converted to RGB565 (big-endian, as the display takes it)
+on the host, so the firmware draws it without decoding anything.  Images
+with long runs of one colour are stored run-length encoded when that is
+smaller; transparent pixels (alpha below 50 %) become a key colour that is
+skipped when drawing.  Use ``--fit`` to shrink images larger than the
+screen.
+
+The archive starts with a header and an index of all images, followed by a
+hash table over their names, so the firmware reads the index once and then
+finds and draws any image with a single seek.  See src/asset_pack.h for
+the layout.
+
+    python3 tools/pack_assets.py -o SD_Card/assets.pak --fit 320x240 \\
+        "boot_logo=SD_Card/pictures/Boot Logo_GPT.png" icons/*.png
+    python3 tools/pack_assets.py --list SD_Card/assets.pak
+
+Without ``NAME=``, an image is named after its file: lower case, with
+everything but letters and digits replaced by ``_``.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+MAGIC = b"APAK"
+VERSION = 1
+HEADER = struct.Struct("<4sHHHHI")      # magic, version, count, slots, 0, data offset
+ENTRY = struct.Struct("<IHHBBHII")      # hash, w, h, format, flags, key, offset, length
+FORMAT_RGB565 = 0
+FORMAT_RLE565 = 1
+FLAG_TRANSPARENT = 1
+TRANSPARENT_KEY = 0xF81F                # magenta
+NAME_MAX = 31
+# Images at least this large start on a sector boundary so the firmware
+# can read them with multi-block transfers.
+SECTOR = 512
+SECTOR_ALIGN_FROM = 4096
+
+
+def fnv1a(name):
+    h = 0x811C9DC5
+    for b in name.encode():
+        h = ((h ^ b) * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+def read_png(path):
+    """Decode a non-interlaced 8-bit PNG into rows of (r, g, b, a)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError("not a PNG file")
+    pos = 8
+    idat = []
+    palette = []
+    trns = b""
+    while pos < len(data):
+        length, kind = struct.unpack(">I4s", data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b"IHDR":
+            width, height, depth, ctype, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif kind == b"PLTE":
+            palette = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif kind == b"tRNS":
+            trns = body
+        elif kind == b"IDAT":
+            idat.append(body)
+        elif kind == b"IEND":
+            break
+    if depth != 8 or interlace:
+        raise ValueError("only non-interlaced 8-bit PNGs are supported")
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[ctype]
+    raw = zlib.decompress(b"".join(idat))
+    stride = width * channels
+    prev = bytearray(stride)
+    rows = []
+    for y in range(height):
+        start = y * (stride + 1)
+        filt = raw[start]
+        line = bytearray(raw[start + 1:start + 1 + stride])
+        for i in range(stride):
+            left = line[i - channels] if i >= channels else 0
+            up = prev[i]
+            if filt == 1:
+                line[i] = (line[i] + left) & 0xFF
+            elif filt == 2:
+                line[i] = (line[i] + up) & 0xFF
+            elif filt == 3:
+                line[i] = (line[i] + ((left + up) >> 1)) & 0xFF
+            elif filt == 4:
+                ul = prev[i - channels] if i >= channels else 0
+                p = left + up - ul
+                pa, pb, pc = abs(p - left), abs(p - up), abs(p - ul)
+                pred = left if pa <= pb and pa <= pc else up if pb <= pc else ul
+                line[i] = (line[i] + pred) & 0xFF
+        prev = line
+        row = []
+        for x in range(width):
+            px = line[x * channels:(x + 1) * channels]
+            if ctype == 0:
+                row.append((px[0], px[0], px[0], 255))
+            elif ctype == 2:
+                row.append((px[0], px[1], px[2], 255))
+            elif ctype == 3:
+                r, g, b = palette[px[0]]
+                row.append((r, g, b, trns[px[0]] if px[0] < len(trns) else 255))
+            elif ctype == 4:
+                row.append((px[0], px[0], px[0], px[1]))
+            else:
+                row.append(tuple(px))
+        rows.append(row)
+    return width, height, rows
+
+
+def shrink(width, height, rows, max_w, max_h):
+    """Scale down to fit max_w x max_h by averaging the covered pixels."""
+    scale = max(width / max_w, height / max_h)
+    if scale <= 1:
+        return width, height, rows
+    out_w = max(1, int(width / scale))
+    out_h = max(1, int(height / scale))
+    out = []
+    for oy in range(out_h):
+        y0, y1 = int(oy * scale), max(int(oy * scale) + 1, int((oy + 1) * scale))
+        row = []
+        for ox in range(out_w):
+            x0, x1 = int(ox * scale), max(int(ox * scale) + 1, int((ox + 1) * scale))
+            acc = [0, 0, 0, 0]
+            for y in range(y0, min(y1, height)):
+                src = rows[y]
+                for x in range(x0, min(x1, width)):
+                    p = src[x]
+                    acc[0] += p[0]
+                    acc[1] += p[1]
+                    acc[2] += p[2]
+                    acc[3] += p[3]
+            n = (min(y1, height) - y0) * (min(x1, width) - x0)
+            row.append(tuple(v // n for v in acc))
+        out.append(row)
+    return out_w, out_h, out
+
+
+def to_rgb565(rows):
+    """Convert to rows of RGB565 values; returns (rows, has_transparency)."""
+    transparent = False
+    out = []
+    for row in rows:
+        line = []
+        for r, g, b, a in row:
+            if a < 128:
+                line.append(TRANSPARENT_KEY)
+                transparent = True
+                continue
+            c = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+            line.append(TRANSPARENT_KEY ^ 1 if c == TRANSPARENT_KEY else c)
+        out.append(line)
+    return out, transparent
+
+
+def encode_raw(rows):
+    return b"".join(struct.pack(">%dH" % len(row), *row) for row in rows)
+
+
+def encode_rle(rows):
+    """Packets of 1-128 pixels that never span rows.  A header byte with the
+    top bit set repeats the following pixel, otherwise the pixels follow."""
+    out = bytearray()
+    for row in rows:
+        i = 0
+        literal = []
+        while i < len(row):
+            run = 1
+            while i + run < len(row) and run < 128 and row[i + run] == row[i]:
+                run += 1
+            if run >= 3:
+                for j in range(0, len(literal), 128):
+                    chunk = literal[j:j + 128]
+                    out.append(len(chunk) - 1)
+                    out += struct.pack(">%dH" % len(chunk), *chunk)
+                literal = []
+                out.append(0x80 | (run - 1))
+                out += struct.pack(">H", row[i])
+                i += run
+            else:
+                literal.append(row[i])
+                i += 1
+        for j in range(0, len(literal), 128):
+            chunk = literal[j:j + 128]
+            out.append(len(chunk) - 1)
+            out += struct.pack(">%dH" % len(chunk), *chunk)
+    return bytes(out)
+
+
+def asset_name(spec):
+    if "=" in spec:
+        name, path = spec.split("=", 1)
+    else:
+        path = spec
+        name = re.sub(r"[^a-z0-9]+", "_", os.path.splitext(os.path.basename(spec))[0].lower()).strip("_")
+    if not name or len(name) > NAME_MAX:
+        raise ValueError("asset name must be 1-%d characters" % NAME_MAX)
+    return name, path
+
+
+def pack(specs, fit, rle, out_path):
+    images = []
+    seen = {}
+    for spec in specs:
+        name, path = asset_name(spec)
+        h = fnv1a(name)
+        if h in seen:
+            sys.exit("%s: name %r collides with %r" % (path, name, seen[h]))
+        seen[h] = name
+        width, height, rows = read_png(path)
+        if fit:
+            width, height, rows = shrink(width, height, rows, *fit)
+        if width > 0xFFFF or height > 0xFFFF:
+            sys.exit("%s: image too large" % path)
+        pixels, transparent = to_rgb565(rows)
+        data, fmt = encode_raw(pixels), FORMAT_RGB565
+        if rle != "never":
+            packed = encode_rle(pixels)
+            if rle == "always" or len(packed) < len(data):
+                data, fmt = packed, FORMAT_RLE565
+        images.append((name, h, width, height, fmt, transparent, data))
+
+    slots = 1
+    while slots < 2 * len(images):
+        slots *= 2
+    table = [0] * slots
+    for index, image in enumerate(images):
+        s = image[1] & (slots - 1)
+        while table[s]:
+            s = (s + 1) & (slots - 1)
+        table[s] = index + 1
+
+    offset = HEADER.size + ENTRY.size * len(images) + 2 * slots
+    entries = []
+    blobs = []
+    for name, h, width, height, fmt, transparent, data in images:
+        align = SECTOR if len(data) >= SECTOR_ALIGN_FROM else 4
+        pad = -offset % align
+        blobs.append(b"\0" * pad + data)
+        offset += pad
+        entries.append(ENTRY.pack(h, width, height, fmt,
+                                  FLAG_TRANSPARENT if transparent else 0,
+                                  TRANSPARENT_KEY, offset, len(data)))
+        offset += len(data)
+        print("%-20s %4dx%-4d %-6s %7d bytes%s" % (
+            name, width, height, "rle" if fmt == FORMAT_RLE565 else "rgb565",
+            len(data), ", transparent" if transparent else ""))
+
+    data_offset = HEADER.size + ENTRY.size * len(images) + 2 * slots
+    with open(out_path, "wb") as f:
+        f.write(HEADER.pack(MAGIC, VERSION, len(images), slots, 0, data_offset))
+        f.write(b"".join(entries))
+        f.write(struct.pack("<%dH" % slots, *table))
+        f.write(b"".join(blobs))
+    print("%d images, %d bytes -> %s" % (len(images), offset, out_path))
+
+
+def list_archive(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, version, count, slots, _, _ = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        sys.exit("%s: not an asset archive" % path)
+    for i in range(count):
+        h, w, hgt, fmt, flags, key, offset, length = ENTRY.unpack_from(
+            data, HEADER.size + i * ENTRY.size)
+        print("%08x %4dx%-4d %-6s %7d bytes at %d%s" % (
+            h, w, hgt, "rle" if fmt == FORMAT_RLE565 else "rgb565", length, offset,
+            ", transparent" if flags & FLAG_TRANSPARENT else ""))
+
+
+def parse_fit(text):
+    m = re.fullmatch(r"(\d+)x(\d+)", text)
+    if not m:
+        raise argparse.ArgumentTypeError("expected WIDTHxHEIGHT")
+    return int(m.group(1)), int(m.group(2))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("images", nargs="*", metavar="[NAME=]PNG")
+    parser.add_argument("-o", "--output", help="archive to write")
+    parser.add_argument("--fit", type=parse_fit, metavar="WxH",
+                        help="shrink larger images to fit")
+    parser.add_argument("--rle", choices=("auto", "always", "never"), default="auto")
+    parser.add_argument("--list", metavar="ARCHIVE", help="show the index of an archive")
+    args = parser.parse_args()
+    if args.list:
+        list_archive(args.list)
+        return 0
+    if not args.output or not args.images:
+        parser.error("need -o ARCHIVE and at least one image")
+    try:
+        pack(args.images, args.fit, args.rle, args.output)
+    except (OSError, ValueError, KeyError) as e:
+        sys.exit(str(e))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,102 @@
+/*
+  range_bench — Host benchmark of the /api/range query engine.
+
+  Fills an EnergyHistory with up to 31 days of hourly curves and one day of
+  per-minute readings, then times ``EnergyHistory::query()`` for typical
+  ranges and steps.  For comparison the same ranges are also reduced from
+  the finest level (one query per minute or hour, averaged here), which is
+  what a query engine without the aggregate levels would have to do.
+
+  Build:  g++ -O2 -std=c++17 -Isrc -o range_bench tools/range_bench.cpp src/history.cpp
+  Usage:  ./range_bench
+*/
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "history.h"
+
+struct Case {
+  const char *name;
+  uint32_t span;
+  uint32_t step;
+};
+
+static const Case CASES[] = {
+    {"1 day / 1 min", 86400, 60},        {"1 day / 15 min", 86400, 900},
+    {"7 days / 1 h", 7 * 86400, 3600},   {"31 days / 1 h", 31 * 86400, 3600},
+    {"31 days / 6 h", 31 * 86400, 21600}, {"31 days / 1 day", 31 * 86400, 86400},
+};
+
+static double nowUs() {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Average each step from the finest level only.
+static void naiveQuery(const EnergyHistory &h, uint32_t from, uint32_t step,
+                       size_t count, float *gen, float *cons) {
+  uint32_t unit = step < 3600 ? 60 : 3600;
+  size_t per = step / unit;
+  std::vector<float> g(per), c(per);
+  for (size_t i = 0; i < count; ++i) {
+    h.query(from + i * step, unit, per, g.data(), c.data(), nullptr);
+    double sg = 0, sc = 0;
+    size_t n = 0;
+    for (size_t k = 0; k < per; ++k) {
+      if (!isnan(g[k])) {
+        sg += g[k];
+        sc += c[k];
+        ++n;
+      }
+    }
+    gen[i] = n ? sg / n : NAN;
+    cons[i] = n ? sc / n : NAN;
+  }
+}
+
+int main() {
+  static const int FILLS[] = {1, 7, 14, 31};
+  const uint32_t end = 1760054400;  // midnight UTC
+  printf("%-6s %-18s %7s %12s %12s\n", "days", "query", "points", "query us",
+         "naive us");
+  for (int days : FILLS) {
+    EnergyHistory *h = new EnergyHistory;
+    srand(1);
+    for (int d = days; d > 0; --d) {
+      float gen[24], cons[24];
+      for (int k = 0; k < 24; ++k) {
+        gen[k] = rand() % 800;
+        cons[k] = rand() % 400;
+      }
+      h->recordHours(end - d * 86400, gen, cons, 24);
+    }
+    for (uint32_t t = end - 86400; t < end; t += 10) {
+      h->recordPower(t, (rand() % 2000) - 1000.0f);
+    }
+    for (const Case &c : CASES) {
+      size_t count = c.span / c.step;
+      std::vector<float> gen(count), cons(count);
+      std::vector<EnergyHistory::Envelope> env(count);
+      uint32_t from = end - c.span;
+      const int reps = 200;
+      double t0 = nowUs();
+      for (int r = 0; r < reps; ++r) {
+        h->query(from, c.step, count, gen.data(), cons.data(), env.data());
+      }
+      double t1 = nowUs();
+      for (int r = 0; r < reps; ++r) {
+        naiveQuery(*h, from, c.step, count, gen.data(), cons.data());
+      }
+      double t2 = nowUs();
+      printf("%-6d %-18s %7zu %12.2f %12.2f\n", days, c.name, count,
+             (t1 - t0) / reps, (t2 - t1) / reps);
+    }
+    delete h;
+  }
+  return 0;
+}
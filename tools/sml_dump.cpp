@@ -0,0 +1,73 @@
+/*
+  sml_dump — Decode SML or D0 meter telegrams on a Linux host.
+
+  Reads raw bytes from a serial device, pty or capture file and feeds them
+  through the same parsers the firmware uses.  Each validated telegram is
+  printed together with the time spent between its last byte arriving and
+  the reading being available.
+
+  Build:  g++ -O2 -std=c++17 -Isrc -o sml_dump tools/sml_dump.cpp src/meter_parsers.cpp
+  Usage:  ./sml_dump [-d] <device-or-file>      (-d selects the D0 parser)
+*/
+
+#include <chrono>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "meter_parsers.h"
+
+int main(int argc, char **argv) {
+  bool d0 = false;
+  const char *path = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-d") == 0) {
+      d0 = true;
+    } else {
+      path = argv[i];
+    }
+  }
+  if (!path) {
+    fprintf(stderr, "usage: %s [-d] <device-or-file>\n", argv[0]);
+    return 2;
+  }
+  int fd = open(path, O_RDONLY | O_NOCTTY);
+  if (fd < 0) {
+    perror(path);
+    return 1;
+  }
+  if (isatty(fd)) {
+    termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+
+  SmlParser sml;
+  D0Parser d0p;
+  uint8_t buf[256];
+  ssize_t n;
+  while ((n = read(fd, buf, sizeof(buf))) > 0) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (ssize_t i = 0; i < n; ++i) {
+      bool done = d0 ? d0p.feed(buf[i]) : sml.feed(buf[i]);
+      if (!done) {
+        continue;
+      }
+      const MeterReading &r = d0 ? d0p.reading() : sml.reading();
+      auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - t0)
+                    .count();
+      printf("#%u power=%.1f W import=%.1f Wh export=%.1f Wh (%lld us)\n",
+             static_cast<unsigned>(r.sequence), r.powerW, r.importWh,
+             r.exportWh, static_cast<long long>(us));
+      fflush(stdout);
+    }
+  }
+  printf("checksum errors: %u\n",
+         static_cast<unsigned>(d0 ? d0p.crcErrors() : sml.crcErrors()));
+  close(fd);
+  return 0;
+}
@@ -0,0 +1,106 @@
+'use strict';
+
+const POLL_MS = 5000;
+let span = 0;  // 0 shows today's curves from the snapshot
+let snapshot = null;
+
+function fmt(v, digits, unit) {
+  return v === null || v === undefined ? '--' : v.toFixed(digits) + ' ' + unit;
+}
+
+function showValues(s) {
+  document.getElementById('updated').textContent = s.updated;
+  document.getElementById('battery').textContent = fmt(s.battery, 1, '%');
+  document.getElementById('generation').textContent = fmt(s.generation, 2, 'kWh');
+  document.getElementById('consumption').textContent = fmt(s.consumption, 2, 'kWh');
+  document.getElementById('live').hidden = !s.live;
+  document.getElementById('power').textContent = fmt(s.power, 0, 'W');
+  const alarm = document.getElementById('alarm');
+  alarm.hidden = !s.alarm;
+  alarm.textContent = s.alarm || '';
+}
+
+// Draw generation and consumption over [from, from + gen.length * step).
+function drawGraph(gen, cons, from, step) {
+  const c = document.getElementById('graph');
+  const g = c.getContext('2d');
+  const left = 40, bottom = c.height - 20, top = 10, right = c.width - 10;
+  g.clearRect(0, 0, c.width, c.height);
+  const max = Math.max(1, ...gen.filter(v => v !== null), ...cons.filter(v => v !== null));
+  const x = i => left + (right - left) * i / gen.length;
+  const y = v => bottom - (bottom - top) * v / max;
+  g.strokeStyle = '#444';
+  g.fillStyle = '#aaa';
+  g.font = '12px sans-serif';
+  for (let k = 0; k <= 4; ++k) {
+    const yy = y(max * k / 4);
+    g.beginPath();
+    g.moveTo(left, yy);
+    g.lineTo(right, yy);
+    g.stroke();
+    g.fillText(Math.round(max * k / 4) + ' W', 0, yy + 4);
+  }
+  const labels = 6;
+  for (let k = 0; k <= labels; ++k) {
+    const t = new Date((from + step * gen.length * k / labels) * 1000);
+    const text = span === 0 || span <= 86400
+      ? String(t.getUTCHours()).padStart(2, '0') + ':00'
+      : t.getUTCDate() + '.' + (t.getUTCMonth() + 1) + '.';
+    g.fillText(text, left + (right - left) * k / labels - 16, c.height - 4);
+  }
+  for (const [data, colour] of [[cons, '#f00'], [gen, '#ff0']]) {
+    g.strokeStyle = colour;
+    g.beginPath();
+    let pen = false;
+    data.forEach((v, i) => {
+      if (v === null) {
+        pen = false;
+      } else if (pen) {
+        g.lineTo(x(i + 0.5), y(v));
+      } else {
+        g.moveTo(x(i + 0.5), y(v));
+        pen = true;
+      }
+    });
+    g.stroke();
+  }
+}
+
+async function refreshGraph() {
+  if (span === 0) {
+    if (snapshot) {
+      const day = snapshot.time - snapshot.time % 86400;
+      drawGraph(snapshot.gen, snapshot.cons, day, 3600);
+    }
+    return;
+  }
+  const step = span > 7 * 86400 ? 21600 : 3600;
+  const to = Math.floor(Date.now() / 1000 / step) * step + step;
+  const r = await fetch(`/api/range?from=${to - span}&to=${to}&step=${step}`);
+  const j = await r.json();
+  drawGraph(j.data.map(row => row[1]), j.data.map(row => row[2]), j.from, j.step);
+}
+
+async function poll() {
+  try {
+    // The device answers 304 while the snapshot is unchanged.
+    const r = await fetch('/api/now', {cache: 'no-cache'});
+    const s = await r.json();
+    if (!snapshot || s.seq !== snapshot.seq) {
+      snapshot = s;
+      showValues(s);
+      refreshGraph();
+    }
+  } catch (e) {
+    document.getElementById('updated').textContent = 'offline';
+  }
+  setTimeout(poll, POLL_MS);
+}
+
+document.querySelectorAll('nav button').forEach(b => b.addEventListener('click', () => {
+  document.querySelectorAll('nav button').forEach(o => o.classList.toggle('active', o === b));
+  span = Number(b.dataset.span);
+  refreshGraph();
+}));
+
+poll();